@@ -0,0 +1,158 @@
+// -------------------------------------------------------------------------------
+// PROJECT: Culling (benchmark)
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Frustum culling of 10k to 1M boxes scattered through a large
+// volume, seen by a camera that turns a little every frame while 1% of the
+// boxes move. The boxes' world bounds come from the lesson cube's vertex
+// array (Aabb::fromVertices) and their model matrices. Per frame it refits
+// the Bvh for the moved boxes and culls with it, and for comparison tests
+// every box without the tree (scalar and SIMD). Prints the build time,
+// visible/culled counts and average milliseconds per frame of each step,
+// and checks that all methods find the same visible boxes.
+// CPU only, no window or GL context needed.
+// Usage: Culling [objects] [frames]
+// -------------------------------------------------------------------------------
+
+#include "../../Common/culling.h"
+
+#include <glm-1.0.1/glm/glm.hpp>
+#include <glm-1.0.1/glm/gtc/matrix_transform.hpp>
+#include <glm-1.0.1/glm/gtc/type_ptr.hpp>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdlib>
+#include <iostream>
+
+// The lessons' box: 36 vertices of position + uv
+std::vector<float> makeCubeVertices()
+{
+	static const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+	std::vector<float> vertices;
+	for (int face = 0; face < 6; face++)
+	{
+		int axis = face / 2;
+		float side = face % 2 ? 0.5f : -0.5f;
+		for (int corner = 0; corner < 6; corner++)
+		{
+			float position[3];
+			position[axis] = side;
+			position[(axis + 1) % 3] = corners[corner][0] * 0.5f;
+			position[(axis + 2) % 3] = corners[corner][1] * 0.5f;
+			vertices.insert(vertices.end(), position, position + 3);
+			vertices.push_back(corners[corner][0] * 0.5f + 0.5f);
+			vertices.push_back(corners[corner][1] * 0.5f + 0.5f);
+		}
+	}
+	return vertices;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run(size_t count, int frames)
+{
+	if (count == 0)
+		return;
+	std::vector<float> vertices = makeCubeVertices();
+	Aabb mesh = Aabb::fromVertices(vertices.data(), vertices.size() / 5, 5);
+
+	// same density for every count: the volume grows with it
+	float extent = 4.0f * std::cbrt((float)count);
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<glm::vec3> positions(count);
+	std::vector<Aabb> bounds(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		positions[i] = glm::vec3(unit(random), unit(random) * 0.25f, unit(random)) * extent;
+		glm::vec3 axis = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.01f, 0.0f));
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), positions[i]);
+		model = glm::rotate(model, unit(random) * 3.14159f, axis);
+		model = glm::scale(model, glm::vec3(1.0f + unit(random) * 0.5f));
+		bounds[i] = mesh.transformed(glm::value_ptr(model));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Bvh bvh;
+	bvh.build(bounds);
+	double buildTime = millisecondsSince(start);
+	std::cout << count << " objects, build " << buildTime << " ms" << std::endl;
+	bvh.printStats();
+
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, extent);
+	std::vector<uint32_t> visible, reference, simd;
+	double refitTime = 0.0, cullTime = 0.0, scalarTime = 0.0, simdTime = 0.0;
+	size_t visibleTotal = 0, nodesTotal = 0;
+	bool same = true;
+	size_t moves = std::max((size_t)1, count / 100);
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (size_t m = 0; m < moves; m++)
+		{
+			size_t i = random() % count;
+			glm::vec3 offset = glm::vec3(unit(random), unit(random), unit(random)) * 2.0f;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				bounds[i].min[axis] += offset[axis];
+				bounds[i].max[axis] += offset[axis];
+			}
+			bvh.setBounds(i, bounds[i]);
+		}
+		start = std::chrono::steady_clock::now();
+		bvh.refit();
+		refitTime += millisecondsSince(start);
+
+		float yaw = frame * 0.05f;
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(std::sin(yaw), 0.0f, -std::cos(yaw)), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 viewProjection = projection * view;
+		Frustum frustum = Frustum::fromMatrix(glm::value_ptr(viewProjection));
+
+		Bvh::CullStats stats;
+		start = std::chrono::steady_clock::now();
+		bvh.cull(frustum, visible, Bvh::best(), &stats);
+		cullTime += millisecondsSince(start);
+		visibleTotal += stats.visible;
+		nodesTotal += stats.nodesVisited;
+
+		start = std::chrono::steady_clock::now();
+		bvh.cullAll(frustum, reference, Bvh::SCALAR);
+		scalarTime += millisecondsSince(start);
+		start = std::chrono::steady_clock::now();
+		bvh.cullAll(frustum, simd, Bvh::best());
+		simdTime += millisecondsSince(start);
+
+		std::sort(visible.begin(), visible.end());
+		std::sort(reference.begin(), reference.end());
+		std::sort(simd.begin(), simd.end());
+		same = same && visible == reference && simd == reference;
+	}
+
+	size_t averageVisible = visibleTotal / frames;
+	std::cout << "  visible " << averageVisible << ", culled " << count - averageVisible << " per frame ("
+		<< nodesTotal / frames << " nodes visited), " << (same ? "all methods agree" : "ERROR: methods disagree") << std::endl;
+	std::cout << "  refit (" << moves << " moved): " << refitTime / frames << " ms/frame" << std::endl;
+	std::cout << "  Bvh cull, " << Bvh::name(Bvh::best()) << ": " << cullTime / frames << " ms/frame" << std::endl;
+	std::cout << "  every object, scalar: " << scalarTime / frames << " ms/frame" << std::endl;
+	std::cout << "  every object, " << Bvh::name(Bvh::best()) << ": " << simdTime / frames << " ms/frame" << std::endl;
+	if (bvh.needsRebuild())
+		std::cout << "  refits have made the tree worth rebuilding" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 60;
+	if (argc > 1)
+	{
+		run((size_t)std::strtoull(argv[1], NULL, 10), frames);
+		return 0;
+	}
+	run(10000, frames);
+	run(100000, frames);
+	run(1000000, frames);
+	return 0;
+}
@@ -0,0 +1,489 @@
+// -------------------------------------------------------------------------------
+// PROJECT: ManyCubes (benchmark)
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Load test with many copies of the MatrixIntro_v3 box, each
+// spinning around its own axis. Compares the lesson's way of drawing (one
+// glUniformMatrix4fv + one draw call per box) with instancing, where the
+// per-box transforms go into an InstanceBuffer and one
+// glDrawElementsInstanced draws them all, either as full matrices or packed
+// as position/scale + axis/angle (expanded in the vertex shader). The
+// "ring" mode writes the matrices straight into a persistently mapped
+// UploadRing instead of orphaning a buffer every frame; "batch" does the
+// same with the matrices built by TransformBatch (SIMD, threaded).
+// "threaded" and "threaded-matrix" are "single" and "matrix" with a
+// RenderThread: the main thread animates and records a RenderCommandList,
+// the render thread replays the previous frame's list at the same time.
+// Without an instance count it sweeps 1 to 1M instances; the per-object path
+// stops at 100k there, as it takes seconds per frame beyond that.
+// Usage: ManyCubes [instances] [--mode single|matrix|packed|ring|batch|threaded|threaded-matrix] [--frames N] [--window]
+// -------------------------------------------------------------------------------
+
+#include "../../Common/shader.h"
+#include "../../Common/app_window.h"
+#include "../../Common/frame_timer.h"
+#include "../../Common/mesh_optimizer.h"
+#include "../../Common/instance_buffer.h"
+#include "../../Common/upload_ring.h"
+#include "../../Common/uniform_blocks.h"
+#include "../../Common/transform_batch.h"
+#include "../../Common/render_thread.h"
+
+#include <glm-1.0.1/glm/glm.hpp>
+#include <glm-1.0.1/glm/gtc/matrix_transform.hpp>
+#include <glm-1.0.1/glm/gtc/type_ptr.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <cstdlib>
+
+enum Mode
+{
+	SINGLE,
+	MATRIX,
+	PACKED,
+	RING,
+	BATCH,
+	THREADED,
+	THREADED_MATRIX,
+	MODE_COUNT
+};
+
+static const char* modeNames[MODE_COUNT] = { "single", "matrix", "packed", "ring", "batch", "threaded", "threaded-matrix" };
+static const char* modeDefines[MODE_COUNT] = { "", "INSTANCE_MATRIX", "INSTANCE_PACKED", "INSTANCE_MATRIX", "INSTANCE_MATRIX", "", "INSTANCE_MATRIX" };
+
+// One spinning box
+struct Cube
+{
+	glm::vec3 position;
+	glm::vec3 axis;
+	float speed;
+	float scale;
+};
+
+// Frame times of one run (milliseconds)
+struct RunStats
+{
+	double frame;  // whole frame, swap to swap
+	double submit; // CPU time to animate and issue the draws (threaded: record)
+};
+
+// Unit box as position + uv, 6 faces x 2 triangles (unindexed, like the lessons)
+std::vector<float> makeCubeVertices()
+{
+	static const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+	std::vector<float> vertices;
+	for (int face = 0; face < 6; face++)
+	{
+		int axis = face / 2;
+		float side = face % 2 ? 0.5f : -0.5f;
+		for (int corner = 0; corner < 6; corner++)
+		{
+			float position[3];
+			position[axis] = side;
+			position[(axis + 1) % 3] = corners[corner][0] * 0.5f;
+			position[(axis + 2) % 3] = corners[corner][1] * 0.5f;
+			vertices.insert(vertices.end(), position, position + 3);
+			vertices.push_back(corners[corner][0] * 0.5f + 0.5f);
+			vertices.push_back(corners[corner][1] * 0.5f + 0.5f);
+		}
+	}
+	return vertices;
+}
+
+// Boxes on a cubic grid centered on the origin, random axes and speeds
+std::vector<Cube> makeCubes(size_t count, int& side)
+{
+	side = (int)std::ceil(std::cbrt((double)count));
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<Cube> cubes(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Cube& cube = cubes[i];
+		int x = (int)(i % side);
+		int y = (int)(i / side % side);
+		int z = (int)(i / ((size_t)side * side));
+		cube.position = glm::vec3(x, y, z) * 2.0f - glm::vec3((float)(side - 1));
+		glm::vec3 axis(unit(random), unit(random), unit(random));
+		cube.axis = glm::length(axis) > 0.01f ? glm::normalize(axis) : glm::vec3(0.0f, 1.0f, 0.0f);
+		cube.speed = 0.5f + unit(random) * 0.4f;
+		cube.scale = 0.8f + unit(random) * 0.2f;
+	}
+	return cubes;
+}
+
+// Vertex array over the shared box buffers (the instanced modes add their
+// instance attributes to it)
+unsigned int makeVertexArray(unsigned int VBO, unsigned int EBO)
+{
+	GLState& state = GLState::instance();
+	unsigned int VAO;
+	glGenVertexArrays(1, &VAO);
+	state.bindVertexArray(VAO);
+	state.bindBuffer(GL_ARRAY_BUFFER, VBO);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	return VAO;
+}
+
+// The threaded modes: animate and record here, replay on a RenderThread.
+// Timed from the end of the warm-up to the last frame presented.
+RunStats runThreaded(AppWindow& window, Mode mode, const std::vector<Cube>& cubes, GLuint program, GLint modelLocation, GLuint VAO,
+	GLuint instanceBuffer, GLsizei indexCount, int warmup, int frames)
+{
+	size_t count = cubes.size();
+	RenderThread renderer(window);
+	if (!renderer.start())
+		return RunStats();
+
+	FrameTimer::Stats submit;
+	std::chrono::steady_clock::time_point timed;
+	for (int frame = 0; frame < warmup + frames; frame++)
+	{
+		if (frame == warmup)
+		{
+			// first timed frame starts here
+			renderer.finish();
+			renderer.resetStats();
+			timed = std::chrono::steady_clock::now();
+		}
+		float time = frame / 60.0f;
+		RenderCommandList& commands = renderer.beginFrame();
+		// not counting the wait for a free list
+		auto start = std::chrono::steady_clock::now();
+		commands.clearTarget(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, 0.1f, 0.1f, 0.15f, 1.0f);
+		commands.useProgram(program);
+		commands.bindVertexArray(VAO);
+		if (mode == THREADED)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const Cube& cube = cubes[i];
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), cube.position);
+				model = glm::rotate(model, time * cube.speed, cube.axis);
+				model = glm::scale(model, glm::vec3(cube.scale));
+				commands.setMat4(modelLocation, glm::value_ptr(model));
+				commands.drawElements(GL_TRIANGLES, indexCount);
+			}
+		}
+		else
+		{
+			// built straight into the list, no copy
+			glm::mat4* target = reinterpret_cast<glm::mat4*>(commands.uploadBuffer(GL_ARRAY_BUFFER, instanceBuffer, count * sizeof(glm::mat4)));
+			for (size_t i = 0; i < count; i++)
+			{
+				const Cube& cube = cubes[i];
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), cube.position);
+				model = glm::rotate(model, time * cube.speed, cube.axis);
+				target[i] = glm::scale(model, glm::vec3(cube.scale));
+			}
+			commands.drawElementsInstanced(GL_TRIANGLES, indexCount, (GLsizei)count);
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		renderer.submit();
+		window.endFrame();
+		if (frame >= warmup)
+			submit.add(ms);
+	}
+	renderer.finish();
+	double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - timed).count();
+	renderer.printStats();
+	renderer.stop();
+
+	RunStats stats;
+	stats.frame = elapsed / frames;
+	stats.submit = submit.mean();
+	return stats;
+}
+
+// Render 'frames' frames of 'count' boxes in one mode
+RunStats run(AppWindow& window, Mode mode, size_t count, int frames, unsigned int VBO, unsigned int EBO, GLsizei indexCount)
+{
+	GLState& state = GLState::instance();
+	int side = 0;
+	std::vector<Cube> cubes = makeCubes(count, side);
+
+	Shader shader("cube.vs", "cube.fs", modeDefines[mode]);
+	UniformHandle modelLoc = shader.getUniform("model");
+
+	unsigned int VAO = makeVertexArray(VBO, EBO);
+	InstanceBuffer instances(mode == PACKED ? InstanceBuffer::PACKED : InstanceBuffer::MATRIX);
+	if (mode == MATRIX || mode == PACKED || mode == THREADED_MATRIX)
+		instances.attach(VAO, 2);
+	std::vector<glm::mat4> matrices(mode == MATRIX ? count : 0);
+	bool threaded = mode == THREADED || mode == THREADED_MATRIX;
+	// three frames of matrices (and Frame blocks) in flight
+	UploadRing::Settings ringSettings;
+	bool ringMode = mode == RING || mode == BATCH;
+	ringSettings.frameSize = ringMode ? count * sizeof(glm::mat4) + 1024 : 16;
+	UploadRing ring(ringSettings);
+	std::vector<InstanceBuffer::Packed> packed(mode == PACKED ? count : 0);
+	static_assert(sizeof(glm::mat4) == sizeof(InstanceBuffer::Matrix), "glm::mat4 must match InstanceBuffer::Matrix");
+	// batch: the boxes as arrays, only the angles change per frame
+	TransformBatch::Transforms transforms;
+	std::vector<float> speeds;
+	TransformBatch::Options batchOptions;
+	batchOptions.stream = ring.isPersistent();
+	if (mode == BATCH)
+	{
+		transforms.resize(count);
+		speeds.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const Cube& cube = cubes[i];
+			transforms.set(i, cube.position.x, cube.position.y, cube.position.z, cube.axis.x, cube.axis.y, cube.axis.z, 0.0f, cube.scale);
+			speeds[i] = cube.speed;
+		}
+	}
+
+	int width, height;
+	window.getFramebufferSize(&width, &height);
+	float distance = side * 3.0f + 2.0f;
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, distance * 2.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, side * 0.5f, distance), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 viewProjection = projection * view;
+	// the camera is shared through the Camera block: uploaded once, not set per program
+	UniformBlocks& blocks = UniformBlocks::instance();
+	CameraBlock camera;
+	std::memcpy(camera.view, glm::value_ptr(view), sizeof(camera.view));
+	std::memcpy(camera.projection, glm::value_ptr(projection), sizeof(camera.projection));
+	std::memcpy(camera.viewProjection, glm::value_ptr(viewProjection), sizeof(camera.viewProjection));
+	camera.cameraPosition[0] = 0.0f;
+	camera.cameraPosition[1] = side * 0.5f;
+	camera.cameraPosition[2] = distance;
+	camera.cameraPosition[3] = 1.0f;
+	FrameBlock frameBlock = {};
+	frameBlock.resolution[0] = (float)width;
+	frameBlock.resolution[1] = (float)height;
+
+	const int warmup = 5;
+	FrameTimer frameTimer;
+	FrameTimer::Stats submit;
+	if (threaded)
+	{
+		// the camera does not change: bound once, before the context moves
+		shader.use();
+		blocks.update(camera);
+		RunStats stats = runThreaded(window, mode, cubes, shader.ID, shader.getLocation(modelLoc), VAO, instances.getBuffer(), indexCount, warmup, frames);
+		instances.release();
+		state.bindVertexArray(0);
+		state.deleteVertexArray(VAO);
+		return stats;
+	}
+	for (int frame = 0; frame < warmup + frames; frame++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		float time = frame / 60.0f;
+		state.clearColor(0.1f, 0.1f, 0.15f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		shader.use();
+		blocks.update(camera);
+		frameBlock.time = time;
+		frameBlock.deltaTime = 1.0f / 60.0f;
+		frameBlock.frameIndex = frame;
+		// changes every frame: through the ring when there is one
+		if (ringMode)
+		{
+			ring.beginFrame();
+			blocks.update(frameBlock, ring);
+		}
+		else
+			blocks.update(frameBlock);
+		state.bindVertexArray(VAO);
+
+		if (mode == SINGLE)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const Cube& cube = cubes[i];
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), cube.position);
+				model = glm::rotate(model, time * cube.speed, cube.axis);
+				model = glm::scale(model, glm::vec3(cube.scale));
+				shader.setMat4(modelLoc, glm::value_ptr(model));
+				glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+			}
+		}
+		else if (mode == MATRIX)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const Cube& cube = cubes[i];
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), cube.position);
+				model = glm::rotate(model, time * cube.speed, cube.axis);
+				matrices[i] = glm::scale(model, glm::vec3(cube.scale));
+			}
+			instances.upload(matrices.data(), count);
+			glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, (GLsizei)count);
+		}
+		else if (mode == PACKED)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const Cube& cube = cubes[i];
+				InstanceBuffer::Packed& instance = packed[i];
+				instance.position[0] = cube.position.x;
+				instance.position[1] = cube.position.y;
+				instance.position[2] = cube.position.z;
+				instance.scale = cube.scale;
+				instance.axis[0] = cube.axis.x;
+				instance.axis[1] = cube.axis.y;
+				instance.axis[2] = cube.axis.z;
+				instance.angle = time * cube.speed;
+			}
+			instances.upload(packed.data(), count);
+			glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, (GLsizei)count);
+		}
+		else
+		{
+			UploadRing::Allocation allocation = ring.allocate(count * sizeof(glm::mat4), sizeof(glm::mat4));
+			if (mode == BATCH)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					transforms.rotationW[i] = time * speeds[i];
+				}
+				TransformBatch::build(transforms, reinterpret_cast<float*>(allocation.data), batchOptions);
+			}
+			else
+			{
+				glm::mat4* target = reinterpret_cast<glm::mat4*>(allocation.data);
+				for (size_t i = 0; i < count; i++)
+				{
+					const Cube& cube = cubes[i];
+					glm::mat4 model = glm::translate(glm::mat4(1.0f), cube.position);
+					model = glm::rotate(model, time * cube.speed, cube.axis);
+					target[i] = glm::scale(model, glm::vec3(cube.scale));
+				}
+			}
+			ring.commit(allocation);
+			InstanceBuffer::point(InstanceBuffer::MATRIX, VAO, 2, ring.getBuffer(), allocation.offset);
+			glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, (GLsizei)count);
+			ring.endFrame();
+		}
+
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		window.swapBuffers();
+		if (frame == warmup - 1)
+		{
+			// first timed frame starts here
+			glFinish();
+			frameTimer.tick();
+		}
+		else if (frame >= warmup)
+		{
+			submit.add(ms);
+			frameTimer.tick();
+		}
+	}
+	glFinish();
+
+	if (ringMode)
+		ring.printStats();
+	ring.release();
+	instances.release();
+	state.bindVertexArray(0);
+	state.deleteVertexArray(VAO);
+
+	RunStats stats;
+	stats.frame = frameTimer.getFrames().mean();
+	stats.submit = submit.mean();
+	return stats;
+}
+
+void report(Mode mode, size_t count, const RunStats& stats)
+{
+	std::cout << "  " << modeNames[mode] << ": " << stats.frame << " ms/frame (submit " << stats.submit << " ms), "
+		<< (stats.frame > 0.0 ? count / stats.frame * 1e-3 : 0.0) << " M cubes/s" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	// takes --headless and its options out of argv (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	size_t requested = 0;
+	int modeFilter = -1;
+	int frames = 60;
+	bool visible = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--mode" && i + 1 < argc)
+		{
+			std::string name = argv[++i];
+			for (int m = 0; m < MODE_COUNT; m++)
+			{
+				if (name == modeNames[m])
+					modeFilter = m;
+			}
+		}
+		else if (arg == "--frames" && i + 1 < argc)
+			frames = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--window")
+			visible = true;
+		else
+			requested = (size_t)std::strtoull(arg.c_str(), NULL, 10);
+	}
+
+	if (!window.open("ManyCubes", 800, 600, visible))
+	{
+		return -1;
+	}
+	// measure frames, not the display's refresh rate
+	window.setSwapInterval(0);
+	GLState::instance().enable(GL_DEPTH_TEST);
+
+	std::vector<float> vertices = makeCubeVertices();
+	MeshOptimizer::Mesh mesh = MeshOptimizer::optimize(vertices.data(), vertices.size() / 5, 5);
+	unsigned int VBO, EBO;
+	glGenBuffers(1, &VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+	GLState::instance().invalidate();
+
+	std::vector<size_t> counts;
+	if (requested > 0)
+	{
+		counts.push_back(requested);
+	}
+	else
+	{
+		for (size_t count = 1; count <= 1000000; count *= 10)
+		{
+			counts.push_back(count);
+		}
+	}
+
+	for (size_t c = 0; c < counts.size(); c++)
+	{
+		std::cout << counts[c] << " cubes, " << frames << " frames" << std::endl;
+		for (int m = 0; m < MODE_COUNT; m++)
+		{
+			if (modeFilter >= 0 && m != modeFilter)
+				continue;
+			if ((m == SINGLE || m == THREADED) && requested == 0 && counts[c] > 100000)
+			{
+				std::cout << "  " << modeNames[m] << ": skipped (pass the count explicitly to run it)" << std::endl;
+				continue;
+			}
+			report((Mode)m, counts[c], run(window, (Mode)m, counts[c], frames, VBO, EBO, (GLsizei)mesh.indices.size()));
+		}
+	}
+
+	GLState::instance().deleteBuffer(VBO);
+	GLState::instance().deleteBuffer(EBO);
+	JobSystem::instance().printStats();
+	UniformBlocks::instance().printStats();
+	UniformBlocks::instance().release();
+	GLState::instance().printStats();
+	window.close();
+	return 0;
+}
@@ -0,0 +1,28 @@
+#version 330 core
+#include "../../Common/instancing.glsl"
+#include "../../Common/uniform_blocks.glsl"
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+#if defined(INSTANCE_MATRIX)
+layout (location = 2) in mat4 aModel;
+#elif defined(INSTANCE_PACKED)
+layout (location = 2) in vec4 aPositionScale;
+layout (location = 3) in vec4 aAxisAngle;
+#else
+uniform mat4 model;
+#endif
+
+out vec2 TexCoord;
+
+void main()
+{
+#if defined(INSTANCE_MATRIX)
+	mat4 world = aModel;
+#elif defined(INSTANCE_PACKED)
+	mat4 world = instanceMatrix(aPositionScale, aAxisAngle);
+#else
+	mat4 world = model;
+#endif
+	gl_Position = viewProjection * world * vec4(aPos, 1.0f);
+	TexCoord = aTexCoord;
+}
@@ -0,0 +1,270 @@
+// -------------------------------------------------------------------------------
+// PROJECT: MultiDraw (benchmark)
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Driver overhead of drawing N objects that mix the projects'
+// meshes (MatrixIntro box, HelloTextures quad, HelloRectangle rectangle,
+// HelloTriangle triangle) in random order:
+//   separate  each mesh in its own buffers and vertex array, per object a
+//             vertex array bind + glUniformMatrix4fv + glDrawElements
+//   direct    MeshBatch: shared buffers, one instanced draw per command
+//   mdi       MeshBatch: one glMultiDrawElementsIndirect for the pass
+//   sorted    as mdi with the objects sorted by mesh (one command per mesh)
+// Rasterization is discarded, so the times are CPU submit + driver work.
+// Prints CPU submit time and frame time (glFinish) per frame.
+// Usage: MultiDraw [objects] [frames]
+// -------------------------------------------------------------------------------
+
+#include "../../Common/shader.h"
+#include "../../Common/app_window.h"
+#include "../../Common/mesh_batch.h"
+#include "../../Common/mesh_optimizer.h"
+#include "../../Common/uniform_blocks.h"
+
+#include <glm-1.0.1/glm/glm.hpp>
+#include <glm-1.0.1/glm/gtc/matrix_transform.hpp>
+#include <glm-1.0.1/glm/gtc/type_ptr.hpp>
+
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <algorithm>
+
+enum Mode
+{
+	SEPARATE,
+	DIRECT,
+	MDI,
+	SORTED,
+	MODE_COUNT
+};
+
+static const char* modeNames[MODE_COUNT] = { "separate", "direct", "mdi", "sorted" };
+
+// One object: which mesh and where
+struct Object
+{
+	int mesh;
+	glm::mat4 model;
+};
+
+// A mesh in its own buffers, the way the lessons set them up
+struct SeparateMesh
+{
+	unsigned int VAO, VBO, EBO;
+	GLsizei indexCount;
+};
+
+// The projects' meshes as position + uv, indexed
+std::vector<MeshOptimizer::Mesh> makeMeshes()
+{
+	std::vector<MeshOptimizer::Mesh> meshes;
+
+	// MatrixIntro box: 36 unindexed vertices, welded by the optimizer
+	static const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+	std::vector<float> box;
+	for (int face = 0; face < 6; face++)
+	{
+		int axis = face / 2;
+		float side = face % 2 ? 0.5f : -0.5f;
+		for (int corner = 0; corner < 6; corner++)
+		{
+			float position[3];
+			position[axis] = side;
+			position[(axis + 1) % 3] = corners[corner][0] * 0.5f;
+			position[(axis + 2) % 3] = corners[corner][1] * 0.5f;
+			box.insert(box.end(), position, position + 3);
+			box.push_back(corners[corner][0] * 0.5f + 0.5f);
+			box.push_back(corners[corner][1] * 0.5f + 0.5f);
+		}
+	}
+	meshes.push_back(MeshOptimizer::optimize(box.data(), box.size() / 5, 5));
+
+	// HelloTextures quad (its colors dropped) and HelloRectangle rectangle
+	MeshOptimizer::Mesh quad;
+	quad.stride = 5;
+	quad.vertices = {
+		0.5f,  0.5f, 0.0f,   1.0f, 1.0f,
+		0.5f, -0.5f, 0.0f,   1.0f, 0.0f,
+	   -0.5f, -0.5f, 0.0f,   0.0f, 0.0f,
+	   -0.5f,  0.5f, 0.0f,   0.0f, 1.0f
+	};
+	quad.indices = { 0, 1, 3, 1, 2, 3 };
+	meshes.push_back(quad);
+	MeshOptimizer::Mesh rectangle = quad;
+	for (size_t v = 0; v < rectangle.vertexCount(); v++)
+	{
+		rectangle.vertices[v * 5 + 3] = rectangle.vertices[v * 5 + 4] = 0.0f;
+	}
+	meshes.push_back(rectangle);
+
+	// HelloTriangle triangle
+	MeshOptimizer::Mesh triangle;
+	triangle.stride = 5;
+	triangle.vertices = {
+		-0.5f, -0.5f, 0.0f,   0.0f, 0.0f,
+		 0.5f, -0.5f, 0.0f,   1.0f, 0.0f,
+		 0.0f,  0.5f, 0.0f,   0.5f, 1.0f
+	};
+	triangle.indices = { 0, 1, 2 };
+	meshes.push_back(triangle);
+	return meshes;
+}
+
+SeparateMesh makeSeparateMesh(const MeshOptimizer::Mesh& mesh)
+{
+	GLState& state = GLState::instance();
+	SeparateMesh separate;
+	separate.indexCount = (GLsizei)mesh.indices.size();
+	glGenVertexArrays(1, &separate.VAO);
+	state.bindVertexArray(separate.VAO);
+	glGenBuffers(1, &separate.VBO);
+	state.bindBuffer(GL_ARRAY_BUFFER, separate.VBO);
+	glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+	glGenBuffers(1, &separate.EBO);
+	state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, separate.EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	return separate;
+}
+
+// Objects on a grid with a random mesh each
+std::vector<Object> makeObjects(size_t count, int meshCount)
+{
+	std::mt19937 random(11);
+	int side = (int)std::ceil(std::sqrt((double)count));
+	std::vector<Object> objects(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		objects[i].mesh = (int)(random() % meshCount);
+		glm::vec3 position((float)(i % side), (float)(i / side), 0.0f);
+		objects[i].model = glm::scale(glm::translate(glm::mat4(1.0f), position * 1.5f), glm::vec3(0.5f));
+	}
+	return objects;
+}
+
+// Average CPU submit and frame time (ms) for one mode
+void run(Mode mode, std::vector<Object> objects, int frames, Shader& separateShader, Shader& batchShader,
+	const std::vector<SeparateMesh>& separate, MeshBatch& batch)
+{
+	GLState& state = GLState::instance();
+	if (mode == SORTED)
+	{
+		std::stable_sort(objects.begin(), objects.end(), [](const Object& a, const Object& b) { return a.mesh < b.mesh; });
+	}
+	if ((mode == MDI || mode == SORTED) && !batch.supports(MeshBatch::MULTI_DRAW_INDIRECT))
+	{
+		std::cout << "  " << modeNames[mode] << ": skipped, no GL 4.3 / ARB_multi_draw_indirect" << std::endl;
+		return;
+	}
+	UniformHandle modelLoc = separateShader.getUniform("model");
+	const int warmup = 5;
+	double submitTotal = 0.0;
+	double frameTotal = 0.0;
+	unsigned long long callsBefore = batch.getStats().calls;
+	for (int frame = 0; frame < warmup + frames; frame++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (mode == SEPARATE)
+		{
+			separateShader.use();
+			for (size_t i = 0; i < objects.size(); i++)
+			{
+				const SeparateMesh& mesh = separate[objects[i].mesh];
+				state.bindVertexArray(mesh.VAO);
+				separateShader.setMat4(modelLoc, glm::value_ptr(objects[i].model));
+				glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0);
+			}
+		}
+		else
+		{
+			batchShader.use();
+			batch.begin();
+			for (size_t i = 0; i < objects.size(); i++)
+			{
+				batch.draw(objects[i].mesh, glm::value_ptr(objects[i].model));
+			}
+			batch.submit(mode == DIRECT ? MeshBatch::DIRECT : MeshBatch::MULTI_DRAW_INDIRECT);
+		}
+		double submit = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		glFinish();
+		double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (frame >= warmup)
+		{
+			submitTotal += submit;
+			frameTotal += total;
+		}
+	}
+	std::cout << "  " << modeNames[mode] << ": submit " << submitTotal / frames << " ms, frame " << frameTotal / frames << " ms";
+	if (mode == SEPARATE)
+		std::cout << ", " << objects.size() << " GL draw calls/frame" << std::endl;
+	else
+		std::cout << ", " << batch.commandCount() << " commands, " << (batch.getStats().calls - callsBefore) / (warmup + frames) << " GL draw calls/frame" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	// takes --headless and its options out of argv (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	size_t requested = argc > 1 ? (size_t)std::strtoull(argv[1], NULL, 10) : 0;
+	int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 60;
+
+	// Hidden window (or headless context), we only need the context
+	if (!window.open("MultiDraw", 64, 64, false))
+	{
+		return -1;
+	}
+	window.setSwapInterval(0);
+	GLState& state = GLState::instance();
+	state.enable(GL_RASTERIZER_DISCARD);
+
+	std::vector<MeshOptimizer::Mesh> meshes = makeMeshes();
+	std::vector<SeparateMesh> separate;
+	MeshBatch batch(5);
+	batch.attribute(0, 3, 0);
+	batch.attribute(1, 2, 3);
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		separate.push_back(makeSeparateMesh(meshes[i]));
+		batch.add(meshes[i]);
+	}
+	batch.upload(2);
+
+	Shader separateShader("mesh.vs", "mesh.fs");
+	Shader batchShader("mesh.vs", "mesh.fs", "BATCHED");
+	CameraBlock camera = {};
+	glm::mat4 viewProjection = glm::ortho(0.0f, 200.0f, 0.0f, 200.0f, -1.0f, 1.0f);
+	std::memcpy(camera.viewProjection, glm::value_ptr(viewProjection), sizeof(camera.viewProjection));
+	UniformBlocks::instance().update(camera);
+
+	std::vector<size_t> counts;
+	if (requested > 0)
+		counts.push_back(requested);
+	else
+		counts = { 1000, 10000, 100000 };
+	for (size_t c = 0; c < counts.size(); c++)
+	{
+		std::cout << counts[c] << " objects, " << meshes.size() << " meshes, " << frames << " frames" << std::endl;
+		std::vector<Object> objects = makeObjects(counts[c], (int)meshes.size());
+		for (int m = 0; m < MODE_COUNT; m++)
+		{
+			run((Mode)m, objects, frames, separateShader, batchShader, separate, batch);
+		}
+	}
+
+	batch.printStats();
+	batch.release();
+	for (size_t i = 0; i < separate.size(); i++)
+	{
+		state.deleteVertexArray(separate[i].VAO);
+		state.deleteBuffer(separate[i].VBO);
+		state.deleteBuffer(separate[i].EBO);
+	}
+	UniformBlocks::instance().release();
+	state.printStats();
+	window.close();
+	return 0;
+}
@@ -0,0 +1,23 @@
+#version 330 core
+#include "../../Common/uniform_blocks.glsl"
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+#ifdef BATCHED
+// per draw, through the command's baseInstance
+layout (location = 2) in mat4 aModel;
+#else
+uniform mat4 model;
+#endif
+
+out vec2 TexCoord;
+
+void main()
+{
+#ifdef BATCHED
+	mat4 world = aModel;
+#else
+	mat4 world = model;
+#endif
+	gl_Position = viewProjection * world * vec4(aPos, 1.0f);
+	TexCoord = aTexCoord;
+}
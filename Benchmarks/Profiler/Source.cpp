@@ -0,0 +1,141 @@
+// -------------------------------------------------------------------------------
+// PROJECT: Profiler (benchmark)
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Cost of a PROFILE_SCOPE zone around a tiny piece of work: no
+// zone at all, the profiler disabled (what every program pays by default)
+// and enabled, with a frame ended every 'zones per frame' zones so events
+// are aggregated as in a real frame. Prints nanoseconds per zone over the
+// bare loop.
+// CPU only, no window or GL context needed. With --gpu it instead opens a
+// hidden window (or headless context) and runs frames of nested GPU zones,
+// as the lessons do, reporting the slowest beginFrame() (where results are
+// read back: a read that waited on an unfinished query shows up there) and
+// how many frames were read or dropped.
+// Usage: Profiler [zones] [zones per frame]
+//        Profiler --gpu [frames]
+// -------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "../../Common/profiler.h"
+#include "../../Common/app_window.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+static volatile unsigned int sink = 0;
+
+// The work inside each zone: a few dependent operations
+inline void work(unsigned int i)
+{
+	sink = sink * 31u + i;
+}
+
+// Nanoseconds for 'zones' iterations, with or without a zone each
+double run(bool zone, long long zones, int perFrame)
+{
+	Profiler& profiler = Profiler::instance();
+	auto start = std::chrono::steady_clock::now();
+	for (long long i = 0; i < zones; i += perFrame)
+	{
+		profiler.beginFrame();
+		for (int j = 0; j < perFrame; j++)
+		{
+			if (zone)
+			{
+				PROFILE_SCOPE("work");
+				work((unsigned int)j);
+			}
+			else
+			{
+				work((unsigned int)j);
+			}
+		}
+		profiler.endFrame();
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nested GPU zones around large clears; returns the slowest beginFrame() in ms
+double runGpu(AppWindow& window, int frames)
+{
+	Profiler& profiler = Profiler::instance();
+	GLState& state = GLState::instance();
+	double slowest = 0.0;
+	for (int i = 0; i < frames && !window.shouldClose(); i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		profiler.beginFrame();
+		slowest = std::max(slowest, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		{
+			// the outer zone ends after the inner ones: its end query is the
+			// last one of the frame
+			PROFILE_GPU_SCOPE("outer");
+			state.clearColor(0.1f, 0.2f, 0.3f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			{
+				PROFILE_GPU_SCOPE("inner");
+				for (int j = 0; j < 8; j++)
+				{
+					state.clearColor(j / 8.0f, 0.0f, 0.0f, 1.0f);
+					glClear(GL_COLOR_BUFFER_BIT);
+				}
+			}
+			for (int j = 0; j < 8; j++)
+			{
+				state.clearColor(0.0f, j / 8.0f, 0.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT);
+			}
+		}
+		profiler.endFrame();
+		window.swapBuffers();
+	}
+	return slowest;
+}
+
+int main(int argc, char** argv)
+{
+	// takes --headless and its options out of argv (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "--gpu")
+	{
+		int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 300;
+		if (!window.open("Profiler", 1024, 1024, false))
+		{
+			return -1;
+		}
+		window.setSwapInterval(0);
+		Profiler& profiler = Profiler::instance();
+		profiler.setEnabled(true);
+		double slowest = runGpu(window, frames);
+		std::cout << frames << " frames of nested GPU zones, slowest beginFrame() " << slowest << " ms" << std::endl;
+		// prints the stats
+		profiler.shutdown();
+		window.close();
+		return window.exitCode();
+	}
+
+	long long zones = argc > 1 ? std::atoll(argv[1]) : 10000000;
+	int perFrame = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000;
+	if (zones < perFrame)
+		zones = perFrame;
+	Profiler& profiler = Profiler::instance();
+	profiler.disableGpu();
+
+	profiler.setEnabled(false);
+	run(true, zones / 10, perFrame); // warm up
+	double bare = run(false, zones, perFrame);
+	double disabled = run(true, zones, perFrame);
+	profiler.setEnabled(true);
+	double enabled = run(true, zones, perFrame);
+	profiler.setEnabled(false);
+
+	std::cout << zones << " zones, " << perFrame << " per frame" << std::endl;
+	std::cout << "  no zone:  " << bare / zones << " ns per iteration" << std::endl;
+	std::cout << "  disabled: +" << (disabled - bare) / zones << " ns per zone" << std::endl;
+	std::cout << "  enabled:  +" << (enabled - bare) / zones << " ns per zone (recorded, aggregated per frame)" << std::endl;
+	profiler.printStats();
+	return 0;
+}
@@ -0,0 +1,65 @@
+// -------------------------------------------------------------------------------
+// PROJECT: ShaderCompile (benchmark)
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Builds N variants of shader.vs/shader.fs (each with a different
+// VARIANT define) one at a time with the Shader constructor, and then as one
+// ShaderLibrary batch. All variants share one mapped and expanded copy of
+// each file. The program cache is turned off so both paths really compile.
+// Set MESA_SHADER_CACHE_DISABLE=true on Mesa for the same reason.
+// Usage: ShaderCompile [programs]
+// -------------------------------------------------------------------------------
+
+#include "../../Common/shader_library.h"
+#include "../../Common/app_window.h"
+
+#include <cstdlib>
+
+// Defines for variant n
+std::string makeVariant(int variant)
+{
+	return "VARIANT=" + std::to_string(variant) + ".0f";
+}
+
+int main(int argc, char** argv)
+{
+	// takes --headless and its options out of argv (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	int programs = argc > 1 ? std::atoi(argv[1]) : 64;
+
+	// Hidden window (or headless context), we only need the context
+	if (!window.open("ShaderCompile", 64, 64, false))
+	{
+		return -1;
+	}
+
+	ProgramCache::instance().setEnabled(false);
+
+	// 1. serial: compile, link and check one program at a time
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < programs; i++)
+	{
+		// the destructor deletes the program
+		Shader variant("shader.vs", "shader.fs", makeVariant(i));
+	}
+	double serialTime = ProgramCache::millisecondsSince(start);
+
+	// 2. batch: different variants so nothing is reused from the first pass
+	ShaderLibrary library;
+	for (int i = 0; i < programs; i++)
+	{
+		library.add("variant" + std::to_string(i), "shader.vs", "shader.fs", makeVariant(programs + i));
+	}
+	library.build();
+
+	std::cout << "Serial: " << programs << " programs in " << serialTime << " ms" << std::endl;
+	library.printStats();
+	const ShaderSourceCache::Stats& sourceStats = ShaderSourceCache::instance().getStats();
+	std::cout << "Sources: " << sourceStats.filesMapped << " files mapped, " << sourceStats.unitsExpanded
+		<< " expanded, " << sourceStats.unitsReused << " reused" << std::endl;
+	std::cout << "Speedup: " << serialTime / library.getStats().totalTime << "x on "
+		<< std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+	window.close();
+	return 0;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D texture0;
+
+void main()
+{
+	// some arithmetic so every variant is real work for the compiler
+	vec4 color = texture(texture0, TexCoord);
+	for (int i = 0; i < 8; i++)
+	{
+		color.rgb = mix(color.rgb, color.gbr * (VARIANT * 0.01f), 0.1f * float(i));
+	}
+	FragColor = color;
+}
@@ -0,0 +1,169 @@
+// -------------------------------------------------------------------------------
+// PROJECT: TextureLoad (benchmark)
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Compares the two ways a project can get a mipmapped texture:
+// stbi_load + glTexImage2D + glGenerateMipmap (what the lessons did), and a
+// baked .gltx file mapped and uploaded level by level. Reports the time per
+// texture (up to glFinish) and the peak resident memory of each path. The
+// images are baked into the temp directory first, so no setup is needed.
+// Peak memory is reset between the two runs on Linux (/proc/self/clear_refs);
+// elsewhere the baked path runs first so its peak is not hidden by stbi's.
+// Usage: TextureLoad [repeats] [image...]
+// -------------------------------------------------------------------------------
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "stb_image.h"
+#include "../../Common/baked_texture.h"
+#include "../../Common/app_window.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+
+#ifdef _WIN32
+#include <psapi.h>
+#endif
+
+// Resident memory in KB; peak == true for the high-water mark
+long long residentKB(bool peak)
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return -1;
+	return (long long)(peak ? counters.PeakWorkingSetSize : counters.WorkingSetSize) / 1024;
+#else
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	const char* key = peak ? "VmHWM:" : "VmRSS:";
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, std::strlen(key), key) == 0)
+			return std::atoll(line.c_str() + std::strlen(key));
+	}
+	return -1;
+#endif
+}
+
+// Start a new high-water mark where the platform allows it
+bool resetPeak()
+{
+#ifdef _WIN32
+	return false;
+#else
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+	clearRefs.close();
+	return (bool)clearRefs;
+#endif
+}
+
+// Time 'load' over every image and repeat; it returns a texture to delete
+void runCase(const char* label, const std::vector<std::string>& images, int repeats, std::function<unsigned int(size_t)> load)
+{
+	bool reset = resetPeak();
+	long long base = residentKB(false);
+	glFinish();
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; r++)
+	{
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			unsigned int texture = load(i);
+			glFinish();
+			GLState::instance().deleteTexture(texture);
+		}
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	long long peak = residentKB(true);
+	std::cout << label << ": " << ms / (repeats * images.size()) << " ms/texture, peak resident +"
+		<< (peak - base) << " KB" << (reset ? "" : " (process peak, not reset)") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	// takes --headless and its options out of argv (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	int repeats = argc > 1 ? std::atoi(argv[1]) : 10;
+	std::vector<std::string> images;
+	for (int i = 2; i < argc; i++)
+	{
+		images.push_back(argv[i]);
+	}
+	if (images.empty())
+	{
+		images.push_back("../../HelloTextures/container.jpg");
+		images.push_back("../../HelloTextures/awesomeface.png");
+		images.push_back("../../MatrixIntro/MatrixIntro_v3/heya.png");
+	}
+	if (repeats < 1)
+		repeats = 1;
+
+	// Hidden window (or headless context), we only need the context
+	if (!window.open("TextureLoad", 64, 64, false))
+	{
+		return -1;
+	}
+
+	// Bake every image into the temp directory
+	stbi_set_flip_vertically_on_load(true);
+	std::vector<std::string> baked;
+	size_t sourceBytes = 0;
+	size_t bakedBytes = 0;
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		int width, height, components;
+		unsigned char* pixels = stbi_load(images[i].c_str(), &width, &height, &components, 0);
+		if (pixels == NULL)
+		{
+			std::cout << "Failed to load texture " << images[i] << std::endl;
+			return -1;
+		}
+		std::filesystem::path name = std::filesystem::path(images[i]).filename();
+		std::string output = BakedTexture::bakedPath((std::filesystem::temp_directory_path() / name).string());
+		bool written = BakedTexture::bake(output, pixels, width, height, components, BakedTexture::FLIPPED);
+		stbi_image_free(pixels);
+		if (!written)
+			return -1;
+		std::error_code ec;
+		sourceBytes += (size_t)std::filesystem::file_size(images[i], ec);
+		bakedBytes += (size_t)std::filesystem::file_size(output, ec);
+		baked.push_back(output);
+	}
+	std::cout << images.size() << " textures x " << repeats << " repeats, source files " << sourceBytes / 1024
+		<< " KB, baked files " << bakedBytes / 1024 << " KB" << std::endl;
+
+	// 1. baked: map, upload every stored level, unmap
+	runCase("baked .gltx (map + upload levels)", baked, repeats, [&](size_t i)
+	{
+		BakedTexture texture(baked[i]);
+		return texture.upload(GL_REPEAT);
+	});
+
+	// 2. stbi: decode, upload level 0, let the driver build the mip chain
+	runCase("stbi (decode + upload + glGenerateMipmap)", images, repeats, [&](size_t i)
+	{
+		int width, height, components;
+		unsigned char* pixels = stbi_load(images[i].c_str(), &width, &height, &components, 0);
+		GLenum format = components == 4 ? GL_RGBA : components == 3 ? GL_RGB : components == 2 ? GL_RG : GL_RED;
+		GLState& state = GLState::instance();
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		state.bindTextureForEdit(GL_TEXTURE_2D, texture);
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		stbi_image_free(pixels);
+		return texture;
+	});
+
+	for (size_t i = 0; i < baked.size(); i++)
+	{
+		std::error_code ec;
+		std::filesystem::remove(baked[i], ec);
+	}
+	window.close();
+	return 0;
+}
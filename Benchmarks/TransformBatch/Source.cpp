@@ -0,0 +1,164 @@
+// -------------------------------------------------------------------------------
+// PROJECT: TransformBatch (benchmark)
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Times building the model matrices of N spinning objects. The
+// reference is the lessons' way, per object: glm::mat4(1.0f) ->
+// glm::translate -> glm::rotate -> glm::scale. It is compared with
+// TransformBatch on the same transforms kept as arrays, scalar and with the
+// SSE2/AVX2 paths this build was compiled for (e.g. -mavx2 or /arch:AVX2),
+// on one thread and on all of them, with normal and streaming stores, and
+// with quaternion instead of axis/angle rotations. Prints the time per run,
+// objects per second and the largest difference to the glm matrices.
+// CPU only, no window or GL context needed.
+// Usage: TransformBatch [objects] [repeats]
+// -------------------------------------------------------------------------------
+
+#include "../../Common/transform_batch.h"
+
+#include <glm-1.0.1/glm/glm.hpp>
+#include <glm-1.0.1/glm/gtc/matrix_transform.hpp>
+#include <glm-1.0.1/glm/gtc/type_ptr.hpp>
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// The same objects as ManyCubes: grid positions, random unit axes, speeds and scales
+TransformBatch::Transforms makeTransforms(size_t count, float time)
+{
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	int side = (int)std::ceil(std::cbrt((double)count));
+	TransformBatch::Transforms transforms;
+	transforms.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		glm::vec3 position = glm::vec3((float)(i % side), (float)(i / side % side), (float)(i / ((size_t)side * side))) * 2.0f - glm::vec3((float)(side - 1));
+		glm::vec3 axis(unit(random), unit(random), unit(random));
+		axis = glm::length(axis) > 0.01f ? glm::normalize(axis) : glm::vec3(0.0f, 1.0f, 0.0f);
+		float speed = 0.5f + unit(random) * 0.4f;
+		float scale = 0.8f + unit(random) * 0.2f;
+		transforms.set(i, position.x, position.y, position.z, axis.x, axis.y, axis.z, time * speed, scale);
+	}
+	return transforms;
+}
+
+// Same rotations as unit quaternions
+TransformBatch::Transforms toQuaternions(const TransformBatch::Transforms& axisAngle)
+{
+	TransformBatch::Transforms transforms = axisAngle;
+	transforms.rotation = TransformBatch::QUATERNION;
+	for (size_t i = 0; i < transforms.size(); i++)
+	{
+		float half = axisAngle.rotationW[i] * 0.5f;
+		float s = std::sin(half);
+		transforms.rotationX[i] = axisAngle.rotationX[i] * s;
+		transforms.rotationY[i] = axisAngle.rotationY[i] * s;
+		transforms.rotationZ[i] = axisAngle.rotationZ[i] * s;
+		transforms.rotationW[i] = std::cos(half);
+	}
+	return transforms;
+}
+
+// Best time of 'repeats' runs of 'build', in milliseconds
+template <typename Build>
+double best(int repeats, Build build)
+{
+	double result = 0.0;
+	for (int r = 0; r < repeats; r++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		build();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (r == 0 || ms < result)
+			result = ms;
+	}
+	return result;
+}
+
+float maxDifference(const float* a, const float* b, size_t floats)
+{
+	float result = 0.0f;
+	for (size_t i = 0; i < floats; i++)
+	{
+		result = std::max(result, std::fabs(a[i] - b[i]));
+	}
+	return result;
+}
+
+void report(const std::string& label, double ms, double referenceTime, size_t count, float difference)
+{
+	std::cout << "  " << label << ": " << ms << " ms (" << referenceTime / ms << "x, " << count / ms * 1e-3
+		<< " M/s), max difference " << difference << std::endl;
+}
+
+void run(size_t count, int repeats)
+{
+	if (count == 0)
+		return;
+	std::cout << count << " objects" << std::endl;
+	TransformBatch::Transforms transforms = makeTransforms(count, 12.5f);
+	TransformBatch::Transforms quaternions = toQuaternions(transforms);
+
+	// reference: one glm chain per object
+	std::vector<glm::mat4> reference(count);
+	double referenceTime = best(repeats, [&]()
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(transforms.positionX[i], transforms.positionY[i], transforms.positionZ[i]));
+			model = glm::rotate(model, transforms.rotationW[i], glm::vec3(transforms.rotationX[i], transforms.rotationY[i], transforms.rotationZ[i]));
+			reference[i] = glm::scale(model, glm::vec3(transforms.scaleX[i], transforms.scaleY[i], transforms.scaleZ[i]));
+		}
+	});
+	std::cout << "  glm per object (reference): " << referenceTime << " ms (" << count / referenceTime * 1e-3 << " M/s)" << std::endl;
+	const float* expected = glm::value_ptr(reference[0]);
+
+	// 64 byte aligned target, like a mapped buffer, so streaming stores apply
+	std::vector<float> storage(count * 16 + 16);
+	float* matrices = storage.data() + (16 - ((uintptr_t)storage.data() / sizeof(float)) % 16) % 16;
+
+	TransformBatch::Options options;
+	options.threads = 1;
+	for (int level = TransformBatch::SCALAR; level <= TransformBatch::best(); level++)
+	{
+		options.instructions = (TransformBatch::Instructions)level;
+		double ms = best(repeats, [&]() { TransformBatch::build(transforms, matrices, options); });
+		report(std::string(TransformBatch::name(options.instructions)) + ", 1 thread", ms, referenceTime, count, maxDifference(expected, matrices, count * 16));
+	}
+
+	options.instructions = TransformBatch::best();
+	options.stream = true;
+	double ms = best(repeats, [&]() { TransformBatch::build(transforms, matrices, options); });
+	report(std::string(TransformBatch::name(options.instructions)) + ", 1 thread, streaming stores", ms, referenceTime, count, maxDifference(expected, matrices, count * 16));
+
+	options.threads = 0;
+	ms = best(repeats, [&]() { TransformBatch::build(transforms, matrices, options); });
+	report(std::string(TransformBatch::name(options.instructions)) + ", threads: " + std::to_string(JobSystem::instance().threadCount()) + ", streaming stores",
+		ms, referenceTime, count, maxDifference(expected, matrices, count * 16));
+
+	options.threads = 1;
+	ms = best(repeats, [&]() { TransformBatch::build(quaternions, matrices, options); });
+	report(std::string(TransformBatch::name(options.instructions)) + ", 1 thread, quaternions", ms, referenceTime, count, maxDifference(expected, matrices, count * 16));
+}
+
+int main(int argc, char** argv)
+{
+	int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+	if (repeats < 1)
+		repeats = 1;
+	if (argc > 1)
+	{
+		run((size_t)std::strtoull(argv[1], NULL, 10), repeats);
+		return 0;
+	}
+	run(10000, repeats);
+	run(100000, repeats);
+	run(1000000, repeats);
+	JobSystem::instance().printStats();
+	return 0;
+}
@@ -0,0 +1,10 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform vec4 tint;
+uniform int mode;
+
+void main()
+{
+	FragColor = mode == 0 ? tint : tint.bgra;
+}
@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 transform;
+uniform float scale;
+
+void main()
+{
+	gl_Position = transform * vec4(aPos * scale, 1.0f);
+}
@@ -0,0 +1,175 @@
+// -------------------------------------------------------------------------------
+// PROJECT: VertexFormats (benchmark)
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Compares full float vertices with VertexCompress encodings for
+// the layouts the projects use (position + uv like MatrixIntro, position +
+// color + uv like HelloTextures) and a lit one (position + normal + uv), on a
+// finely tessellated sphere. Prints memory per layout, the error of each
+// compressed attribute, and the vertex fetch rate: the mesh is drawn
+// 'draws' times with rasterization discarded, so only vertex work is timed.
+// Usage: VertexFormats [segments] [draws]
+// -------------------------------------------------------------------------------
+
+#include "../../Common/shader.h"
+#include "../../Common/app_window.h"
+#include "../../Common/vertex_compress.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+
+// Which attributes follow the position
+enum Extra
+{
+	COLOR = 1,
+	NORMAL = 2,
+	UV = 4
+};
+
+// Sphere of radius 2 around (0, 0, -3), (segments + 1)^2 vertices
+std::vector<float> makeSphere(int segments, int extras, std::vector<unsigned int>& indices)
+{
+	const float pi = 3.14159265358979f;
+	std::vector<float> vertices;
+	for (int y = 0; y <= segments; y++)
+	{
+		float v = (float)y / segments;
+		float theta = v * pi;
+		for (int x = 0; x <= segments; x++)
+		{
+			float u = (float)x / segments;
+			float phi = u * 2.0f * pi;
+			float normal[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+			vertices.push_back(normal[0] * 2.0f);
+			vertices.push_back(normal[1] * 2.0f);
+			vertices.push_back(normal[2] * 2.0f - 3.0f);
+			if (extras & COLOR)
+			{
+				vertices.push_back(u);
+				vertices.push_back(v);
+				vertices.push_back(1.0f - u * v);
+			}
+			if (extras & NORMAL)
+				vertices.insert(vertices.end(), normal, normal + 3);
+			if (extras & UV)
+			{
+				vertices.push_back(u);
+				vertices.push_back(v);
+			}
+		}
+	}
+	indices.clear();
+	for (int y = 0; y < segments; y++)
+	{
+		for (int x = 0; x < segments; x++)
+		{
+			unsigned int a = y * (segments + 1) + x;
+			unsigned int b = a + segments + 1;
+			unsigned int triangles[6] = { a, b, a + 1, a + 1, b, b + 1 };
+			indices.insert(indices.end(), triangles, triangles + 6);
+		}
+	}
+	return vertices;
+}
+
+// Upload one encoding and time drawing it; returns milliseconds per draw
+double timeEncoding(const VertexCompress::Encoded& encoded, const std::vector<unsigned int>& indices,
+	Shader& shader, UniformHandle decodeLoc, int draws)
+{
+	unsigned int VAO, VBO, EBO;
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, encoded.data.size(), encoded.data.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	VertexCompress::setupAttributes(encoded);
+
+	float decode[16];
+	VertexCompress::decodeMatrix(encoded.attributes[0], decode);
+	shader.use();
+	shader.setMat4(decodeLoc, decode);
+
+	// one untimed draw so uploads and shader setup are out of the way
+	glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
+	glFinish();
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < draws; i++)
+	{
+		glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
+	}
+	glFinish();
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / draws;
+
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+	return ms;
+}
+
+void runLayout(const char* label, int segments, int extras, const std::vector<VertexCompress::Attribute>& compressed,
+	Shader& shader, UniformHandle decodeLoc, int draws)
+{
+	std::vector<unsigned int> indices;
+	std::vector<float> vertices = makeSphere(segments, extras, indices);
+
+	std::vector<VertexCompress::Attribute> floats;
+	for (size_t a = 0; a < compressed.size(); a++)
+	{
+		floats.push_back(VertexCompress::Attribute(compressed[a].components, VertexCompress::FLOAT32));
+	}
+	size_t vertexCount = (size_t)(segments + 1) * (segments + 1);
+	VertexCompress::Encoded reference = VertexCompress::encode(vertices.data(), vertexCount, floats);
+	VertexCompress::Encoded encoded = VertexCompress::encode(vertices.data(), vertexCount, compressed);
+
+	std::cout << label << std::endl;
+	VertexCompress::printReport("compressed", encoded);
+	double referenceTime = timeEncoding(reference, indices, shader, decodeLoc, draws);
+	double time = timeEncoding(encoded, indices, shader, decodeLoc, draws);
+	// vertices are fetched about once each thanks to the post-transform cache
+	std::cout << "  float:      " << referenceTime << " ms/draw, "
+		<< reference.data.size() / (referenceTime * 1e-3) / 1e9 << " GB/s of vertex data" << std::endl;
+	std::cout << "  compressed: " << time << " ms/draw, "
+		<< encoded.data.size() / (time * 1e-3) / 1e9 << " GB/s of vertex data (" << referenceTime / time << "x)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	// takes --headless and its options out of argv (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	int segments = argc > 1 ? std::atoi(argv[1]) : 512;
+	int draws = argc > 2 ? std::atoi(argv[2]) : 200;
+	if (segments < 2)
+		segments = 2;
+	if (draws < 1)
+		draws = 1;
+
+	// Hidden window (or headless context), we only need the context
+	if (!window.open("VertexFormats", 64, 64, false))
+	{
+		return -1;
+	}
+
+	Shader myShader("shader.vs", "shader.fs");
+	UniformHandle decodeLoc = myShader.getUniform("decode");
+	glEnable(GL_RASTERIZER_DISCARD);
+
+	std::cout << "Vertex formats, " << (segments + 1) * (segments + 1) << " vertices, " << segments * segments * 2
+		<< " triangles, " << draws << " draws" << std::endl;
+	typedef VertexCompress::Attribute Attribute;
+	runLayout("position + uv (MatrixIntro)", segments, UV,
+		{ Attribute(3, VertexCompress::SNORM16, true), Attribute(2, VertexCompress::UNORM16) }, myShader, decodeLoc, draws);
+	runLayout("position + color + uv (HelloTextures)", segments, COLOR | UV,
+		{ Attribute(3, VertexCompress::SNORM16, true), Attribute(3, VertexCompress::UNORM8), Attribute(2, VertexCompress::UNORM16) },
+		myShader, decodeLoc, draws);
+	runLayout("position + normal + uv, half positions", segments, NORMAL | UV,
+		{ Attribute(3, VertexCompress::HALF), Attribute(3, VertexCompress::SNORM16), Attribute(2, VertexCompress::UNORM16) },
+		myShader, decodeLoc, draws);
+
+	window.close();
+	return 0;
+}
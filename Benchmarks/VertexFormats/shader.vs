@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aFirst;
+layout (location = 2) in vec3 aSecond;
+
+// undoes the position's bounding box mapping (identity for floats)
+uniform mat4 decode;
+
+void main()
+{
+	// every attribute feeds the output so none of the fetches is skipped
+	gl_Position = decode * vec4(aPos, 1.0f) + vec4((aFirst + aSecond) * 0.001f, 0.0f);
+}
@@ -0,0 +1,747 @@
+#ifndef APP_WINDOW_H
+#define APP_WINDOW_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "gl_extensions.h"
+#include "gl_state.h"
+#include "frame_benchmark.h"
+#include "frame_pacer.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <iostream>
+
+// Headless contexts come from EGL where it exists (Linux); define
+// APP_WINDOW_NO_EGL to build without it
+#if defined(__linux__) && !defined(APP_WINDOW_NO_EGL)
+#define APP_WINDOW_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
+
+// App Window Declaration
+// Opens the GL 3.3 core context of a program, either in a GLFW window or
+// headless: an EGL context without any window or display (Mesa's surfaceless
+// platform, or a 1x1 pbuffer on other EGL drivers; with no GPU Mesa picks
+// llvmpipe) that renders into an offscreen framebuffer of the chosen size.
+// A headless run draws a fixed number of frames, advances getTime() by a
+// fixed 1/60 s per frame so every run draws the same images, and can write
+// the last frame to a .ppm file.
+// The mode is chosen at startup, so the same binary runs both ways:
+//   --headless             or GL_HEADLESS=1
+//   --headless-frames N    or GL_HEADLESS_FRAMES=N (default 300)
+//   --headless-size WxH    or GL_HEADLESS_SIZE=WxH (default: window size)
+//   --headless-dump FILE   or GL_HEADLESS_DUMP=FILE
+// The options are removed from argv, so programs parse the rest as before.
+// --benchmark runs the frame benchmark in either mode (frame_benchmark.h).
+// --swap-interval, --frames-in-flight and --target-fps pace the loop
+// (frame_pacer.h).
+// swapBuffers() is present() (GL) + endFrame() (events); a RenderThread
+// (render_thread.h) takes the context and calls present() on its own thread.
+// Without EGL (Windows, macOS) headless uses a hidden GLFW window and the
+// same offscreen framebuffer, which still needs a desktop session.
+
+class AppWindow
+{
+public:
+	enum Mode
+	{
+		WINDOWED,
+		HEADLESS
+	};
+
+	struct Settings
+	{
+		Mode mode = WINDOWED;
+		int frames = 300;       // headless: frames until shouldClose()
+		int width = 0;          // headless: 0 = size passed to open()
+		int height = 0;
+		std::string dumpPath;   // headless: last frame as .ppm, empty = none
+		double timeStep = 1.0 / 60.0;
+	};
+
+	// A second context sharing objects with the window's, for a worker
+	// thread (see ShaderWatcher). makeCurrent() on the worker; release() on
+	// the thread that created it, after the worker called doneCurrent().
+	class SharedContext
+	{
+	public:
+		bool valid() const
+		{
+#ifdef APP_WINDOW_EGL
+			if (context != EGL_NO_CONTEXT)
+				return true;
+#endif
+			return window != NULL;
+		}
+
+		// -------------------------------------------------------------------
+		bool makeCurrent()
+		{
+#ifdef APP_WINDOW_EGL
+			if (context != EGL_NO_CONTEXT)
+				return eglMakeCurrent(display, surface, surface, context) == EGL_TRUE;
+#endif
+			if (window == NULL)
+				return false;
+			glfwMakeContextCurrent(window);
+			return true;
+		}
+
+		// -------------------------------------------------------------------
+		void doneCurrent()
+		{
+#ifdef APP_WINDOW_EGL
+			if (context != EGL_NO_CONTEXT)
+			{
+				eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+				return;
+			}
+#endif
+			if (window != NULL)
+				glfwMakeContextCurrent(NULL);
+		}
+
+		// -------------------------------------------------------------------
+		void release()
+		{
+#ifdef APP_WINDOW_EGL
+			if (surface != EGL_NO_SURFACE)
+				eglDestroySurface(display, surface);
+			if (context != EGL_NO_CONTEXT)
+				eglDestroyContext(display, context);
+			surface = EGL_NO_SURFACE;
+			context = EGL_NO_CONTEXT;
+#endif
+			if (window != NULL)
+				glfwDestroyWindow(window);
+			window = NULL;
+		}
+
+	private:
+		friend class AppWindow;
+		GLFWwindow* window = NULL;
+#ifdef APP_WINDOW_EGL
+		EGLDisplay display = EGL_NO_DISPLAY;
+		EGLContext context = EGL_NO_CONTEXT;
+		EGLSurface surface = EGL_NO_SURFACE;
+#endif
+	};
+
+	// AppWindow Constructors: settings from the environment, then from (and
+	// removed from) the command line
+	// -------------------------------------------------------------------
+	AppWindow()
+	{
+		readEnvironment();
+	}
+
+	AppWindow(int& argc, char** argv)
+		: benchmark(argc, argv), pacer(argc, argv)
+	{
+		readEnvironment();
+		readArguments(argc, argv);
+	}
+
+	AppWindow(const Settings& settings) : settings(settings)
+	{
+	}
+
+	~AppWindow()
+	{
+		close();
+	}
+
+	AppWindow(const AppWindow&) = delete;
+	AppWindow& operator=(const AppWindow&) = delete;
+
+	// Create the context (and window), make it current and load GL.
+	// 'visible' = false gives a hidden window, for benchmarks.
+	// -------------------------------------------------------------------
+	bool open(const char* title, int windowWidth, int windowHeight, bool visible = true)
+	{
+		width = settings.width > 0 ? settings.width : windowWidth;
+		height = settings.height > 0 ? settings.height : windowHeight;
+		this->title = title;
+		bool opened = settings.mode == HEADLESS ? openHeadless(title) : openWindow(title, visible);
+		if (opened && pacer.getSettings().swapInterval >= 0)
+			setSwapInterval(pacer.getSettings().swapInterval);
+		if (opened)
+		{
+			GLState::instance().setContextAlive(true);
+			pacer.start();
+		}
+		if (opened && benchmark.isEnabled())
+		{
+			// measure frames, not the display's refresh rate
+			setSwapInterval(0);
+			std::cout << "APP_WINDOW:: benchmark, " << benchmark.getSettings().warmup << " warm-up + " << benchmark.getSettings().frames
+				<< " frames" << std::endl;
+			benchmark.start();
+		}
+		return opened;
+	}
+
+	bool isOpen() const { return window != NULL || isHeadlessOpen(); }
+	bool isHeadless() const { return settings.mode == HEADLESS; }
+	const Settings& getSettings() const { return settings; }
+	const FrameBenchmark& getBenchmark() const { return benchmark; }
+	FramePacer& getPacer() { return pacer; }
+
+	// What main() returns: FrameBenchmark::EXIT_REGRESSION after a benchmark
+	// run slower than its baseline
+	int exitCode() const { return benchmark.hasPassed() ? 0 : FrameBenchmark::EXIT_REGRESSION; }
+
+	// GLFW window, NULL when headless
+	GLFWwindow* getWindow() const { return settings.mode == HEADLESS ? NULL : window; }
+
+	// Framebuffer the program draws to: 0 when windowed
+	GLuint getFramebuffer() const { return framebuffer; }
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getFrame() const { return frame; }
+
+	// -------------------------------------------------------------------
+	void getFramebufferSize(int* outWidth, int* outHeight) const
+	{
+		if (settings.mode == WINDOWED && window != NULL)
+		{
+			glfwGetFramebufferSize(window, outWidth, outHeight);
+			return;
+		}
+		*outWidth = width;
+		*outHeight = height;
+	}
+
+	// Bind the framebuffer the program draws to and its viewport, e.g. after
+	// rendering into a texture
+	// -------------------------------------------------------------------
+	void bindFramebuffer()
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		int w, h;
+		getFramebufferSize(&w, &h);
+		GLState::instance().viewport(0, 0, w, h);
+	}
+
+	// Headless or benchmark: true once the frame count is reached
+	// -------------------------------------------------------------------
+	bool shouldClose() const
+	{
+		if (closeRequested || frame >= lastFrame())
+			return true;
+		if (settings.mode == HEADLESS)
+			return false;
+		return window == NULL || glfwWindowShouldClose(window);
+	}
+
+	// -------------------------------------------------------------------
+	void setShouldClose(bool value)
+	{
+		closeRequested = value;
+		if (settings.mode == WINDOWED && window != NULL)
+			glfwSetWindowShouldClose(window, value);
+	}
+
+	// Key state; headless runs have no keyboard, every key is released
+	// -------------------------------------------------------------------
+	int getKey(int key) const
+	{
+		if (settings.mode == HEADLESS || window == NULL)
+			return GLFW_RELEASE;
+		return glfwGetKey(window, key);
+	}
+
+	// Seconds since open(); headless: frame * time step, benchmark: frame *
+	// the benchmark's time step
+	// -------------------------------------------------------------------
+	double getTime() const
+	{
+		if (benchmark.isEnabled())
+			return benchmark.getTime(frame);
+		if (settings.mode == HEADLESS)
+			return frame * settings.timeStep;
+		return glfwGetTime();
+	}
+
+	// -------------------------------------------------------------------
+	void setSwapInterval(int interval)
+	{
+		if (settings.mode == WINDOWED && window != NULL)
+			glfwSwapInterval(interval);
+	}
+
+	// End the frame: swap and poll events, or headless, submit the frame
+	// and write the last one out if a dump path is set. The pacer waits
+	// between the swap and the poll, so the next frame reads fresh input.
+	// -------------------------------------------------------------------
+	void swapBuffers()
+	{
+		present(frame);
+		endFrame();
+	}
+
+	// The GL half of swapBuffers(), on the thread the context is current
+	// on (RenderThread): swap or submit frame 'index', pace, benchmark
+	// -------------------------------------------------------------------
+	void present(int index)
+	{
+		if (settings.mode == HEADLESS)
+		{
+			if (index + 1 == lastFrame() && !settings.dumpPath.empty())
+				dumpFrame(settings.dumpPath, index);
+			// what a swap would do: hand the frame to the driver
+			glFlush();
+		}
+		else
+		{
+			glfwSwapBuffers(window);
+		}
+		pacer.endFrame();
+		if (benchmark.isEnabled())
+		{
+			double cpu = FrameBenchmark::threadCpuTime();
+			glFinish();
+			benchmark.endFrame(index, cpu);
+			if (index + 1 == benchmark.totalFrames())
+				benchmark.report(title, settings.mode == HEADLESS ? "headless" : "windowed", (const char*)glGetString(GL_RENDERER));
+		}
+	}
+
+	// The main thread half: poll events and move on to the next frame
+	// -------------------------------------------------------------------
+	void endFrame()
+	{
+		if (settings.mode == WINDOWED)
+			glfwPollEvents();
+		frame++;
+	}
+
+	// Make the window's context current on the calling thread, e.g. to hand
+	// it to a render thread: doneCurrent() here, makeCurrent() there
+	// -------------------------------------------------------------------
+	bool makeCurrent()
+	{
+#ifdef APP_WINDOW_EGL
+		if (eglContext != EGL_NO_CONTEXT)
+			return eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext) == EGL_TRUE;
+#endif
+		if (window == NULL)
+			return false;
+		glfwMakeContextCurrent(window);
+		return true;
+	}
+
+	// -------------------------------------------------------------------
+	void doneCurrent()
+	{
+#ifdef APP_WINDOW_EGL
+		if (eglContext != EGL_NO_CONTEXT)
+		{
+			eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			return;
+		}
+#endif
+		if (window != NULL)
+			glfwMakeContextCurrent(NULL);
+	}
+
+	// Write the frame being presented (before the swap) to a binary .ppm.
+	// 'index' is only for the log: on a RenderThread the main thread is
+	// already counting the next frame.
+	// -------------------------------------------------------------------
+	bool dumpFrame(const std::string& path, int index)
+	{
+		int w, h;
+		getFramebufferSize(&w, &h);
+		std::vector<unsigned char> pixels((size_t)w * h * 3);
+		GLint packAlignment = 4;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		if (framebuffer == 0)
+			glReadBuffer(GL_BACK);
+		glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+		glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+
+		FILE* file = std::fopen(path.c_str(), "wb");
+		if (file == NULL)
+		{
+			std::cout << "ERROR::APP_WINDOW::DUMP_FAILED " << path << std::endl;
+			return false;
+		}
+		std::fprintf(file, "P6\n%d %d\n255\n", w, h);
+		// GL rows start at the bottom
+		for (int y = h - 1; y >= 0; y--)
+		{
+			std::fwrite(pixels.data() + (size_t)y * w * 3, 1, (size_t)w * 3, file);
+		}
+		std::fclose(file);
+		std::cout << "APP_WINDOW:: frame " << index << " written to " << path << " (" << w << "x" << h << ")" << std::endl;
+		return true;
+	}
+
+	// Context for a worker thread, sharing objects with this one. Call on
+	// the main thread after open().
+	// -------------------------------------------------------------------
+	SharedContext createSharedContext()
+	{
+		SharedContext shared;
+#ifdef APP_WINDOW_EGL
+		if (eglContext != EGL_NO_CONTEXT)
+		{
+			shared.display = eglDisplay;
+			shared.context = eglCreateContext(eglDisplay, eglConfig, eglContext, contextAttributes());
+			if (shared.context != EGL_NO_CONTEXT && !surfaceless)
+				shared.surface = createPbuffer();
+			return shared;
+		}
+#endif
+		if (window != NULL)
+		{
+			setWindowHints(false);
+			shared.window = glfwCreateWindow(1, 1, "SharedContext", NULL, window);
+			glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+		}
+		return shared;
+	}
+
+	// Destroy the framebuffer, context and window. Shared contexts must be
+	// released first.
+	// -------------------------------------------------------------------
+	void close()
+	{
+		if (isOpen())
+		{
+			if (pacer.getSettings().printStats && pacer.getStats().frames > 0)
+				pacer.printStats();
+			pacer.release();
+		}
+		if (framebuffer != 0)
+		{
+			glDeleteFramebuffers(1, &framebuffer);
+			glDeleteRenderbuffers(2, renderbuffers);
+			framebuffer = 0;
+			GLState::instance().invalidate();
+		}
+#ifdef APP_WINDOW_EGL
+		if (eglDisplay != EGL_NO_DISPLAY)
+		{
+			eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			if (eglSurface != EGL_NO_SURFACE)
+				eglDestroySurface(eglDisplay, eglSurface);
+			if (eglContext != EGL_NO_CONTEXT)
+				eglDestroyContext(eglDisplay, eglContext);
+			eglTerminate(eglDisplay);
+			eglDisplay = EGL_NO_DISPLAY;
+			eglSurface = EGL_NO_SURFACE;
+			eglContext = EGL_NO_CONTEXT;
+		}
+#endif
+		if (window != NULL)
+			glfwDestroyWindow(window);
+		window = NULL;
+		if (glfwInitialized)
+			glfwTerminate();
+		glfwInitialized = false;
+		// objects still owned by the caller died with the context
+		GLState& state = GLState::instance();
+		state.invalidate();
+		state.setContextAlive(false);
+	}
+
+private:
+	Settings settings;
+	FrameBenchmark benchmark;
+	FramePacer pacer;
+	std::string title;
+	GLFWwindow* window = NULL;
+	bool glfwInitialized = false;
+	GLuint framebuffer = 0;
+	GLuint renderbuffers[2] = {};
+	int width = 0;
+	int height = 0;
+	int frame = 0;
+	bool closeRequested = false;
+#ifdef APP_WINDOW_EGL
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+	EGLConfig eglConfig = NULL;
+	EGLContext eglContext = EGL_NO_CONTEXT;
+	EGLSurface eglSurface = EGL_NO_SURFACE;
+	bool surfaceless = false;
+#endif
+
+	// Frame after which shouldClose() is true
+	int lastFrame() const
+	{
+		if (benchmark.isEnabled())
+			return benchmark.totalFrames();
+		return settings.mode == HEADLESS ? settings.frames : INT_MAX;
+	}
+
+	// -------------------------------------------------------------------
+	void readEnvironment()
+	{
+		const char* value = std::getenv("GL_HEADLESS");
+		if (value != NULL && value[0] != '\0' && std::strcmp(value, "0") != 0)
+			settings.mode = HEADLESS;
+		if ((value = std::getenv("GL_HEADLESS_FRAMES")) != NULL)
+			settings.frames = std::atoi(value);
+		if ((value = std::getenv("GL_HEADLESS_SIZE")) != NULL)
+			parseSize(value);
+		if ((value = std::getenv("GL_HEADLESS_DUMP")) != NULL)
+			settings.dumpPath = value;
+	}
+
+	// -------------------------------------------------------------------
+	void readArguments(int& argc, char** argv)
+	{
+		int kept = 1;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--headless")
+				settings.mode = HEADLESS;
+			else if (arg == "--headless-frames" && hasValue)
+				settings.frames = std::atoi(argv[++i]);
+			else if (arg == "--headless-size" && hasValue)
+				parseSize(argv[++i]);
+			else if (arg == "--headless-dump" && hasValue)
+				settings.dumpPath = argv[++i];
+			else
+				argv[kept++] = argv[i];
+		}
+		argc = kept;
+		argv[argc] = NULL;
+	}
+
+	// -------------------------------------------------------------------
+	void parseSize(const char* value)
+	{
+		int w = 0, h = 0;
+		if (std::sscanf(value, "%dx%d", &w, &h) == 2 && w > 0 && h > 0)
+		{
+			settings.width = w;
+			settings.height = h;
+		}
+		else
+		{
+			std::cout << "ERROR::APP_WINDOW::INVALID_SIZE " << value << " (expected WxH)" << std::endl;
+		}
+	}
+
+	// -------------------------------------------------------------------
+	void setWindowHints(bool visible)
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+	}
+
+	bool isHeadlessOpen() const
+	{
+#ifdef APP_WINDOW_EGL
+		if (eglContext != EGL_NO_CONTEXT)
+			return true;
+#endif
+		return false;
+	}
+
+	// GLFW window with its context
+	// -------------------------------------------------------------------
+	bool openWindow(const char* title, bool visible)
+	{
+		glfwInit();
+		glfwInitialized = true;
+		setWindowHints(visible);
+		window = glfwCreateWindow(width, height, title, NULL, NULL);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+		if (window == NULL)
+		{
+			std::cout << "Failed to create window" << std::endl;
+			close();
+			return false;
+		}
+		glfwMakeContextCurrent(window);
+		// NOTE: GLAD can only be initialized after window creation + context!
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			close();
+			return false;
+		}
+		glfwGetFramebufferSize(window, &width, &height);
+		return true;
+	}
+
+	// Context without a window, then the offscreen framebuffer
+	// -------------------------------------------------------------------
+	bool openHeadless(const char* title)
+	{
+#ifdef APP_WINDOW_EGL
+		if (!createEglContext())
+		{
+			close();
+			return false;
+		}
+		GLExtensions::setLoader(eglLoader);
+		if (!gladLoadGLLoader((GLADloadproc)eglLoader))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			close();
+			return false;
+		}
+#else
+		glfwInit();
+		glfwInitialized = true;
+		setWindowHints(false);
+		window = glfwCreateWindow(1, 1, title, NULL, NULL);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+		if (window == NULL)
+		{
+			std::cout << "Failed to create window" << std::endl;
+			close();
+			return false;
+		}
+		glfwMakeContextCurrent(window);
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			close();
+			return false;
+		}
+#endif
+		if (!createFramebuffer())
+		{
+			close();
+			return false;
+		}
+		std::cout << "APP_WINDOW:: " << title << " headless " << width << "x" << height << ", " << lastFrame() << " frames, "
+			<< glGetString(GL_RENDERER) << std::endl;
+		return true;
+	}
+
+	// Color + depth/stencil renderbuffers, left bound as the draw target
+	// -------------------------------------------------------------------
+	bool createFramebuffer()
+	{
+		glGenRenderbuffers(2, renderbuffers);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "ERROR::APP_WINDOW::FRAMEBUFFER_INCOMPLETE 0x" << std::hex << status << std::dec << std::endl;
+			return false;
+		}
+		GLState::instance().viewport(0, 0, width, height);
+		return true;
+	}
+
+#ifdef APP_WINDOW_EGL
+	static void* eglLoader(const char* name)
+	{
+		return (void*)eglGetProcAddress(name);
+	}
+
+	static const EGLint* contextAttributes()
+	{
+		static const EGLint attributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		return attributes;
+	}
+
+	static bool hasExtension(const char* extensions, const char* name)
+	{
+		if (extensions == NULL)
+			return false;
+		size_t length = std::strlen(name);
+		for (const char* at = std::strstr(extensions, name); at != NULL; at = std::strstr(at + length, name))
+		{
+			if ((at == extensions || at[-1] == ' ') && (at[length] == ' ' || at[length] == '\0'))
+				return true;
+		}
+		return false;
+	}
+
+	EGLSurface createPbuffer()
+	{
+		static const EGLint attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		return eglCreatePbufferSurface(eglDisplay, eglConfig, attributes);
+	}
+
+	// Surfaceless platform if Mesa offers it (no X11/Wayland/GPU needed),
+	// otherwise the default display with a pbuffer
+	// -------------------------------------------------------------------
+	bool createEglContext()
+	{
+		const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != NULL && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+			eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (eglDisplay == EGL_NO_DISPLAY)
+			eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		EGLint major = 0, minor = 0;
+		if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor))
+		{
+			std::cout << "ERROR::APP_WINDOW::EGL_INITIALIZE_FAILED 0x" << std::hex << eglGetError() << std::dec << std::endl;
+			eglDisplay = EGL_NO_DISPLAY;
+			return false;
+		}
+		if (!eglBindAPI(EGL_OPENGL_API))
+		{
+			std::cout << "ERROR::APP_WINDOW::EGL_NO_DESKTOP_GL" << std::endl;
+			return false;
+		}
+		surfaceless = hasExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+		const EGLint configAttributes[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+			EGL_NONE
+		};
+		EGLint configCount = 0;
+		if (!eglChooseConfig(eglDisplay, configAttributes, &eglConfig, 1, &configCount) || configCount == 0)
+		{
+			std::cout << "ERROR::APP_WINDOW::EGL_NO_CONFIG" << std::endl;
+			return false;
+		}
+		eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttributes());
+		if (eglContext == EGL_NO_CONTEXT)
+		{
+			std::cout << "ERROR::APP_WINDOW::EGL_CREATE_CONTEXT_FAILED 0x" << std::hex << eglGetError() << std::dec << std::endl;
+			return false;
+		}
+		if (!surfaceless)
+			eglSurface = createPbuffer();
+		if (!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext))
+		{
+			std::cout << "ERROR::APP_WINDOW::EGL_MAKE_CURRENT_FAILED 0x" << std::hex << eglGetError() << std::dec << std::endl;
+			return false;
+		}
+		return true;
+	}
+#endif
+};
+#endif
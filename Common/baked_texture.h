@@ -0,0 +1,308 @@
+#ifndef BAKED_TEXTURE_H
+#define BAKED_TEXTURE_H
+
+#include <glad/glad.h>
+#include "gl_state.h"
+#include "mapped_file.h"
+#include "image_resample.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+// Baked Texture Declaration
+// A .gltx file holds a texture exactly as GL wants it: the full mip chain,
+// already in its final internal format, one level after the other. Loading
+// maps the file and hands each level's pointer straight to glTexImage2D, so
+// there is no decode, no CPU copy and no glGenerateMipmap at runtime.
+// Layout (little endian):
+//   Header        64 bytes
+//   Level[levels] 24 bytes each
+//   level data    each level starts on a LEVEL_ALIGNMENT boundary, rows are
+//                 tightly packed (unpack alignment 1)
+// Files are written by the TextureBaker project.
+
+class BakedTexture
+{
+public:
+	static const uint32_t FORMAT_VERSION = 1;
+	static const uint32_t LEVEL_ALIGNMENT = 4096;
+
+	enum Flags
+	{
+		FLIPPED = 1, // rows stored bottom-up (stbi_set_flip_vertically_on_load)
+		SRGB = 2     // color stored as sRGB (GL_SRGB8 / GL_SRGB8_ALPHA8)
+	};
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t levels;
+		uint32_t internalFormat; // e.g. GL_RGBA8
+		uint32_t format;         // e.g. GL_RGBA
+		uint32_t type;           // e.g. GL_UNSIGNED_BYTE
+		uint32_t components;
+		uint32_t flags;
+		uint32_t reserved[6];
+	};
+
+	struct Level
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	// Map and validate 'path'. Check isValid() afterwards.
+	// -------------------------------------------------------------------
+	BakedTexture(const std::string& path)
+		: path(path), file(path)
+	{
+		if (!file.isOpen() || file.size() < sizeof(Header))
+			return;
+		std::memcpy(&header, file.data(), sizeof(Header));
+		if (std::memcmp(header.magic, "GLTX", 4) != 0 || header.version != FORMAT_VERSION || header.levels == 0 || header.levels > 32)
+		{
+			std::cout << "ERROR::BAKED_TEXTURE::INVALID_HEADER " << path << std::endl;
+			return;
+		}
+		uint64_t pixelBytes = bytesPerPixel(header);
+		if (pixelBytes == 0 || header.width == 0 || header.height == 0)
+		{
+			std::cout << "ERROR::BAKED_TEXTURE::INVALID_FORMAT " << path << std::endl;
+			return;
+		}
+		uint64_t tableEnd = sizeof(Header) + (uint64_t)header.levels * sizeof(Level);
+		if (file.size() < tableEnd)
+		{
+			std::cout << "ERROR::BAKED_TEXTURE::TRUNCATED " << path << std::endl;
+			return;
+		}
+		levels.resize(header.levels);
+		std::memcpy(levels.data(), file.data() + sizeof(Header), header.levels * sizeof(Level));
+
+		// every level must be the next step of the chain, hold exactly its
+		// pixels and lie inside the mapping, or upload() would read past it
+		uint32_t width = header.width;
+		uint32_t height = header.height;
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			const Level& level = levels[i];
+			if (i > 0 && width == 1 && height == 1)
+			{
+				std::cout << "ERROR::BAKED_TEXTURE::INVALID_LEVEL " << i << " " << path << std::endl;
+				return;
+			}
+			if (i > 0)
+			{
+				width = width > 1 ? width / 2 : 1;
+				height = height > 1 ? height / 2 : 1;
+			}
+			if (level.width != width || level.height != height || level.size != (uint64_t)width * height * pixelBytes)
+			{
+				std::cout << "ERROR::BAKED_TEXTURE::INVALID_LEVEL " << i << " " << path << std::endl;
+				return;
+			}
+			if (level.offset < tableEnd || level.offset > file.size() || level.size > file.size() - level.offset)
+			{
+				std::cout << "ERROR::BAKED_TEXTURE::TRUNCATED " << path << std::endl;
+				return;
+			}
+		}
+		valid = true;
+	}
+
+	BakedTexture(const BakedTexture&) = delete;
+	BakedTexture& operator=(const BakedTexture&) = delete;
+
+	bool isValid() const { return valid; }
+	const Header& getHeader() const { return header; }
+	unsigned int getLevelCount() const { return (unsigned int)levels.size(); }
+	const Level& getLevel(unsigned int level) const { return levels[level]; }
+	const std::string& getPath() const { return path; }
+
+	// Pixels of a level, pointing into the mapping
+	// -------------------------------------------------------------------
+	const unsigned char* getPixels(unsigned int level) const
+	{
+		return reinterpret_cast<const unsigned char*>(file.data() + levels[level].offset);
+	}
+
+	// Touch every page so later reads of the mapping never wait on the disk
+	// (meant for worker threads, see TextureStreamer)
+	// -------------------------------------------------------------------
+	void prefetch() const
+	{
+		volatile unsigned char sink = 0;
+		for (size_t offset = 0; offset < file.size(); offset += LEVEL_ALIGNMENT)
+		{
+			sink = sink + (unsigned char)file.data()[offset];
+		}
+	}
+
+	// Create a texture and upload every level from the mapping. Returns 0
+	// if the file is not valid. Binds through GLState; the unpack state is
+	// left at its defaults.
+	// -------------------------------------------------------------------
+	unsigned int upload(GLint wrap = GL_REPEAT) const
+	{
+		if (!valid)
+			return 0;
+		GLState& state = GLState::instance();
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 1);
+
+		unsigned int texture = 0;
+		glGenTextures(1, &texture);
+		state.bindTextureForEdit(GL_TEXTURE_2D, texture);
+		setParameters(wrap);
+		for (unsigned int i = 0; i < levels.size(); i++)
+		{
+			glTexImage2D(GL_TEXTURE_2D, i, header.internalFormat, levels[i].width, levels[i].height, 0, header.format, header.type, getPixels(i));
+		}
+
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 4);
+		return texture;
+	}
+
+	// Sampler state for the bound texture; the chain is complete, so trilinear
+	// -------------------------------------------------------------------
+	void setParameters(GLint wrap) const
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+	}
+
+	// "textures/wall.jpg" -> "textures/wall.gltx"
+	// -------------------------------------------------------------------
+	static std::string bakedPath(const std::string& source)
+	{
+		return std::filesystem::path(source).replace_extension(".gltx").string();
+	}
+
+	// The baked file for 'source' if it exists and is not older than it
+	// -------------------------------------------------------------------
+	static bool findBaked(const std::string& source, std::string& baked)
+	{
+		std::error_code ec;
+		std::string candidate = bakedPath(source);
+		std::filesystem::file_time_type bakedTime = std::filesystem::last_write_time(candidate, ec);
+		if (ec)
+			return false;
+		std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(source, ec);
+		if (!ec && sourceTime > bakedTime)
+			return false;
+		baked = candidate;
+		return true;
+	}
+
+	// Bake 8-bit pixels (1-4 components, as stbi_load returns them) into
+	// 'path' with a full mip chain built by ImageResample. The SRGB flag
+	// (3 and 4 components only) selects an sRGB internal format and filters
+	// in linear space. Returns false if the file cannot be written.
+	// -------------------------------------------------------------------
+	static bool bake(const std::string& path, const unsigned char* pixels, int width, int height, int components, uint32_t flags = 0,
+		ImageResample::Filter filter = ImageResample::BOX)
+	{
+		if (pixels == NULL || width <= 0 || height <= 0 || components < 1 || components > 4)
+			return false;
+
+		Header header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, "GLTX", 4);
+		header.version = FORMAT_VERSION;
+		header.width = width;
+		header.height = height;
+		header.components = components;
+		header.flags = flags;
+		header.type = GL_UNSIGNED_BYTE;
+		header.format = components == 4 ? GL_RGBA : components == 3 ? GL_RGB : components == 2 ? GL_RG : GL_RED;
+		header.internalFormat = components == 4 ? GL_RGBA8 : components == 3 ? GL_RGB8 : components == 2 ? GL_RG8 : GL_R8;
+		if (components < 3)
+			header.flags &= ~SRGB;
+		if (header.flags & SRGB)
+			header.internalFormat = components == 4 ? GL_SRGB8_ALPHA8 : GL_SRGB8;
+
+		// mip chain down to 1x1
+		ImageResample::Options options;
+		options.filter = filter;
+		options.srgb = (header.flags & SRGB) != 0;
+		std::vector<ImageResample::MipLevel> mips = ImageResample::buildMipChain(pixels, width, height, components, options);
+		std::vector<const unsigned char*> chain;
+		std::vector<Level> levels;
+		chain.push_back(pixels);
+		levels.push_back(Level{ 0, (uint64_t)width * height * components, (uint32_t)width, (uint32_t)height });
+		for (size_t i = 0; i < mips.size(); i++)
+		{
+			chain.push_back(mips[i].pixels.data());
+			levels.push_back(Level{ 0, mips[i].pixels.size(), (uint32_t)mips[i].width, (uint32_t)mips[i].height });
+		}
+		header.levels = (uint32_t)levels.size();
+
+		uint64_t offset = sizeof(Header) + levels.size() * sizeof(Level);
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			offset = (offset + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+			levels[i].offset = offset;
+			offset += levels[i].size;
+		}
+
+		// write to a temporary name first so a reader never maps a torn file
+		std::string temporary = path + ".tmp";
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::BAKED_TEXTURE::FAILED_TO_WRITE " << temporary << std::endl;
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(Level));
+		uint64_t written = sizeof(Header) + levels.size() * sizeof(Level);
+		const char zeros[LEVEL_ALIGNMENT] = {};
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			file.write(zeros, (std::streamsize)(levels[i].offset - written));
+			file.write(reinterpret_cast<const char*>(chain[i]), (std::streamsize)levels[i].size);
+			written = levels[i].offset + levels[i].size;
+		}
+		file.close();
+		if (!file)
+			return false;
+		std::error_code ec;
+		std::filesystem::rename(temporary, path, ec);
+		return !ec;
+	}
+
+private:
+	// Size of one pixel as the header describes it, 0 if unsupported
+	// -------------------------------------------------------------------
+	static uint64_t bytesPerPixel(const Header& header)
+	{
+		uint64_t channels = header.format == GL_RGBA ? 4 : header.format == GL_RGB ? 3 : header.format == GL_RG ? 2 : header.format == GL_RED ? 1 : 0;
+		uint64_t size = header.type == GL_UNSIGNED_BYTE ? 1 : header.type == GL_UNSIGNED_SHORT || header.type == GL_HALF_FLOAT ? 2
+			: header.type == GL_FLOAT ? 4 : 0;
+		if (channels != header.components)
+			return 0;
+		return channels * size;
+	}
+
+	std::string path;
+	MappedFile file;
+	Header header = {};
+	std::vector<Level> levels;
+	bool valid = false;
+};
+#endif
@@ -0,0 +1,627 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define CULLING_AVX2
+#include <immintrin.h>
+#endif
+
+// Culling Declaration
+// Bounds and view frustum culling for scenes with many objects:
+//   Aabb     axis-aligned box, from a vertex array (the mesh's bounds) and
+//            moved into world space with a model matrix
+//   Frustum  the six planes of a (column-major) view-projection matrix
+//   Bvh      bounding volume hierarchy over the objects' world boxes, built
+//            with the surface area heuristic. When objects move, setBounds()
+//            marks their path to the root and refit() recomputes only those
+//            nodes; needsRebuild() says when refitting has made the tree
+//            much worse than a fresh build. cull() walks it, skipping
+//            subtrees outside the frustum and taking whole subtrees inside
+//            it, tests the objects of partly visible leaves 4 (SSE2) or 8
+//            (AVX2) at a time, and returns a compact list of visible object
+//            indices, in tree order, for the draw path.
+// cullAll() tests every object without the tree (the brute force reference).
+
+struct Aabb
+{
+	float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	bool empty() const { return min[0] > max[0]; }
+
+	void expand(const float point[3])
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			min[axis] = std::min(min[axis], point[axis]);
+			max[axis] = std::max(max[axis], point[axis]);
+		}
+	}
+
+	void expand(const Aabb& box)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			min[axis] = std::min(min[axis], box.min[axis]);
+			max[axis] = std::max(max[axis], box.max[axis]);
+		}
+	}
+
+	float surfaceArea() const
+	{
+		if (empty())
+			return 0.0f;
+		float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+		return 2.0f * (x * y + y * z + z * x);
+	}
+
+	// Bounds of the positions in an interleaved vertex array ('stride' floats
+	// per vertex, position first, as MeshOptimizer and the lessons lay it out)
+	// -------------------------------------------------------------------
+	static Aabb fromVertices(const float* vertices, size_t vertexCount, int stride)
+	{
+		Aabb box;
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			box.expand(vertices + i * stride);
+		}
+		return box;
+	}
+
+	// Box around this box moved by a column-major model matrix (Arvo)
+	// -------------------------------------------------------------------
+	Aabb transformed(const float matrix[16]) const
+	{
+		Aabb box;
+		for (int row = 0; row < 3; row++)
+		{
+			box.min[row] = box.max[row] = matrix[12 + row];
+			for (int column = 0; column < 3; column++)
+			{
+				float a = matrix[column * 4 + row] * min[column];
+				float b = matrix[column * 4 + row] * max[column];
+				box.min[row] += std::min(a, b);
+				box.max[row] += std::max(a, b);
+			}
+		}
+		return box;
+	}
+};
+
+struct Frustum
+{
+	// left, right, bottom, top, near, far: inside where dot(n, p) + d >= 0
+	float planes[6][4];
+
+	// Gribb/Hartmann extraction from a column-major matrix (glm::value_ptr)
+	// -------------------------------------------------------------------
+	static Frustum fromMatrix(const float m[16])
+	{
+		Frustum frustum;
+		for (int i = 0; i < 6; i++)
+		{
+			int row = i / 2;
+			float sign = i % 2 ? -1.0f : 1.0f;
+			float length = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				frustum.planes[i][c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+				if (c < 3)
+					length += frustum.planes[i][c] * frustum.planes[i][c];
+			}
+			length = length > 0.0f ? 1.0f / std::sqrt(length) : 1.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				frustum.planes[i][c] *= length;
+			}
+		}
+		return frustum;
+	}
+
+	// Planes (bits of 'mask') the box is not fully inside of. Sets 'outside'
+	// when the box is entirely behind one of them.
+	// -------------------------------------------------------------------
+	unsigned int classify(const Aabb& box, unsigned int mask, bool& outside) const
+	{
+		outside = false;
+		unsigned int result = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			if (!(mask & (1u << i)))
+				continue;
+			const float* p = planes[i];
+			// the corner farthest along the normal, and the nearest one
+			float far = p[3], near = p[3];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				far += p[axis] * (p[axis] > 0.0f ? box.max[axis] : box.min[axis]);
+				near += p[axis] * (p[axis] > 0.0f ? box.min[axis] : box.max[axis]);
+			}
+			if (far < 0.0f)
+			{
+				outside = true;
+				return 0;
+			}
+			if (near < 0.0f)
+				result |= 1u << i;
+		}
+		return result;
+	}
+};
+
+class Bvh
+{
+public:
+	enum Instructions
+	{
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+	static const unsigned int ALL_PLANES = 0x3f;
+	static const int MAX_LEAF_OBJECTS = 8;
+	static const int BINS = 16;
+
+	struct CullStats
+	{
+		size_t nodesVisited = 0;
+		size_t objectsTested = 0; // tested one by one (partly visible leaves)
+		size_t visible = 0;
+	};
+
+	// Widest instruction set this build can use
+	// -------------------------------------------------------------------
+	static Instructions best()
+	{
+#if defined(CULLING_AVX2)
+		return AVX2;
+#elif defined(CULLING_SSE2)
+		return SSE2;
+#else
+		return SCALAR;
+#endif
+	}
+
+	static const char* name(Instructions instructions)
+	{
+		return instructions == AVX2 ? "AVX2" : instructions == SSE2 ? "SSE2" : "scalar";
+	}
+
+	// Build over the objects' world boxes (object i = bounds[i])
+	// -------------------------------------------------------------------
+	void build(const std::vector<Aabb>& bounds)
+	{
+		size_t count = bounds.size();
+		nodes.clear();
+		order.resize(count);
+		positionOf.resize(count);
+		leafOf.assign(count, 0);
+		for (size_t i = 0; i < count; i++)
+		{
+			order[i] = (uint32_t)i;
+		}
+		std::vector<float> centroids(count * 3);
+		for (size_t i = 0; i < count; i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				centroids[i * 3 + axis] = (bounds[i].min[axis] + bounds[i].max[axis]) * 0.5f;
+			}
+		}
+
+		nodes.reserve(count > 0 ? count / 2 + 1 : 1);
+		Node root;
+		root.first = 0;
+		root.count = (uint32_t)count;
+		nodes.push_back(root);
+		// depth first with an explicit stack; a node's children are allocated as a pair
+		std::vector<uint32_t> stack(1, 0);
+		while (!stack.empty())
+		{
+			uint32_t index = stack.back();
+			stack.pop_back();
+			uint32_t first = nodes[index].first;
+			uint32_t objects = nodes[index].count;
+			Aabb box;
+			for (uint32_t i = first; i < first + objects; i++)
+			{
+				box.expand(bounds[order[i]]);
+			}
+			nodes[index].bounds = box;
+
+			uint32_t split = objects > (uint32_t)MAX_LEAF_OBJECTS ? findSplit(bounds, centroids, first, objects) : 0;
+			if (split == 0)
+				continue;
+			Node left, right;
+			left.first = first;
+			left.count = split;
+			left.parent = index;
+			right.first = first + split;
+			right.count = objects - split;
+			right.parent = index;
+			nodes[index].left = (uint32_t)nodes.size();
+			nodes.push_back(left);
+			nodes.push_back(right);
+			stack.push_back(nodes[index].left + 1);
+			stack.push_back(nodes[index].left);
+		}
+
+		// object boxes in tree order, one array per component for the SIMD tests
+		for (int c = 0; c < 6; c++)
+		{
+			boxes[c].resize(count);
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			positionOf[order[i]] = (uint32_t)i;
+			storeBox(i, bounds[order[i]]);
+		}
+		for (uint32_t n = 0; n < (uint32_t)nodes.size(); n++)
+		{
+			if (nodes[n].left == 0)
+			{
+				for (uint32_t i = nodes[n].first; i < nodes[n].first + nodes[n].count; i++)
+				{
+					leafOf[order[i]] = n;
+				}
+			}
+		}
+		dirty.assign(nodes.size(), 0);
+		builtCost = cost();
+		currentCost = builtCost;
+	}
+
+	// New world box for object 'object'; takes effect at refit()
+	// -------------------------------------------------------------------
+	void setBounds(size_t object, const Aabb& box)
+	{
+		storeBox(positionOf[object], box);
+		for (uint32_t n = leafOf[object]; ; n = nodes[n].parent)
+		{
+			if (dirty[n])
+				break;
+			dirty[n] = 1;
+			if (n == 0)
+				break;
+		}
+	}
+
+	// Recompute the boxes of nodes above moved objects. Children always come
+	// after their parent, so one backwards pass sees them first.
+	// -------------------------------------------------------------------
+	void refit()
+	{
+		for (size_t n = nodes.size(); n-- > 0;)
+		{
+			if (!dirty[n])
+				continue;
+			dirty[n] = 0;
+			Node& node = nodes[n];
+			Aabb box;
+			if (node.left == 0)
+			{
+				for (uint32_t i = node.first; i < node.first + node.count; i++)
+				{
+					box.expand(loadBox(i));
+				}
+			}
+			else
+			{
+				box = nodes[node.left].bounds;
+				box.expand(nodes[node.left + 1].bounds);
+			}
+			node.bounds = box;
+		}
+		currentCost = cost();
+	}
+
+	// Refitting keeps the topology; once moved objects have grown the tree's
+	// SAH cost by 'factor' over the built one, a rebuild pays off
+	// -------------------------------------------------------------------
+	bool needsRebuild(float factor = 1.5f) const
+	{
+		return currentCost > builtCost * factor;
+	}
+
+	// Visible object indices (frustum test against each object's box)
+	// -------------------------------------------------------------------
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible, Instructions instructions = best(), CullStats* stats = NULL) const
+	{
+		visible.clear();
+		CullStats local;
+		if (nodes.empty() || order.empty())
+		{
+			if (stats)
+				*stats = local;
+			return;
+		}
+		instructions = instructions > best() ? best() : instructions;
+		// node + planes still to test (a child inside a plane its parent is inside of)
+		struct Entry
+		{
+			uint32_t node;
+			unsigned int mask;
+		};
+		Entry stack[64];
+		int top = 0;
+		stack[top++] = { 0, ALL_PLANES };
+		while (top > 0)
+		{
+			Entry entry = stack[--top];
+			const Node& node = nodes[entry.node];
+			local.nodesVisited++;
+			bool outside;
+			unsigned int mask = frustum.classify(node.bounds, entry.mask, outside);
+			if (outside)
+				continue;
+			if (mask == 0)
+			{
+				visible.insert(visible.end(), order.begin() + node.first, order.begin() + node.first + node.count);
+				continue;
+			}
+			if (node.left == 0 || top + 2 > 64)
+			{
+				// a leaf (or the stack is full): test its objects
+				local.objectsTested += node.count;
+				testObjects(frustum, mask, node.first, node.first + node.count, visible, instructions);
+				continue;
+			}
+			stack[top++] = { node.left + 1, mask };
+			stack[top++] = { node.left, mask };
+		}
+		local.visible = visible.size();
+		if (stats)
+			*stats = local;
+	}
+
+	// Every object, no tree: the reference for cull()
+	// -------------------------------------------------------------------
+	void cullAll(const Frustum& frustum, std::vector<uint32_t>& visible, Instructions instructions = best()) const
+	{
+		visible.clear();
+		instructions = instructions > best() ? best() : instructions;
+		testObjects(frustum, ALL_PLANES, 0, order.size(), visible, instructions);
+	}
+
+	size_t nodeCount() const { return nodes.size(); }
+	size_t objectCount() const { return order.size(); }
+	float getCost() const { return currentCost; }
+	float getBuiltCost() const { return builtCost; }
+
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		size_t leaves = 0;
+		for (size_t n = 0; n < nodes.size(); n++)
+		{
+			if (nodes[n].left == 0)
+				leaves++;
+		}
+		std::cout << "BVH:: objects: " << order.size() << ", nodes: " << nodes.size() << " (" << leaves << " leaves), SAH cost: "
+			<< currentCost << " (built " << builtCost << ")" << std::endl;
+	}
+
+private:
+	struct Node
+	{
+		Aabb bounds;
+		uint32_t first = 0;  // objects [first, first + count) of 'order', also for inner nodes
+		uint32_t count = 0;
+		uint32_t left = 0;   // children left and left + 1; 0 for a leaf
+		uint32_t parent = 0;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> order;      // tree position -> object
+	std::vector<uint32_t> positionOf; // object -> tree position
+	std::vector<uint32_t> leafOf;     // object -> leaf node
+	std::vector<float> boxes[6];      // min x, y, z, max x, y, z by tree position
+	std::vector<unsigned char> dirty;
+	float builtCost = 0.0f;
+	float currentCost = 0.0f;
+
+	void storeBox(size_t position, const Aabb& box)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			boxes[axis][position] = box.min[axis];
+			boxes[3 + axis][position] = box.max[axis];
+		}
+	}
+
+	Aabb loadBox(size_t position) const
+	{
+		Aabb box;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			box.min[axis] = boxes[axis][position];
+			box.max[axis] = boxes[3 + axis][position];
+		}
+		return box;
+	}
+
+	// SAH cost of the tree relative to its root: inner nodes cost 1 per
+	// visit, leaves 1 per object
+	// -------------------------------------------------------------------
+	float cost() const
+	{
+		if (nodes.empty())
+			return 0.0f;
+		float root = nodes[0].bounds.surfaceArea();
+		if (root <= 0.0f)
+			return 0.0f;
+		double total = 0.0;
+		for (size_t n = 0; n < nodes.size(); n++)
+		{
+			total += nodes[n].bounds.surfaceArea() * (nodes[n].left == 0 ? (double)nodes[n].count : 1.0);
+		}
+		return (float)(total / root);
+	}
+
+	// Binned SAH over the centroids: sorts objects [first, first + count) of
+	// 'order' around the cheapest split and returns the left count
+	// -------------------------------------------------------------------
+	uint32_t findSplit(const std::vector<Aabb>& bounds, const std::vector<float>& centroids, uint32_t first, uint32_t count)
+	{
+		Aabb centers;
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			centers.expand(&centroids[(size_t)order[i] * 3]);
+		}
+
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		int bestBin = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = centers.max[axis] - centers.min[axis];
+			if (extent <= 0.0f)
+				continue;
+			Aabb binBoxes[BINS];
+			uint32_t binCounts[BINS] = {};
+			float scale = BINS / extent;
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				int bin = std::min(BINS - 1, (int)((centroids[(size_t)order[i] * 3 + axis] - centers.min[axis]) * scale));
+				binBoxes[bin].expand(bounds[order[i]]);
+				binCounts[bin]++;
+			}
+			// sweep from the right, then from the left
+			float rightArea[BINS];
+			uint32_t rightCount[BINS];
+			Aabb sweep;
+			uint32_t total = 0;
+			for (int b = BINS - 1; b > 0; b--)
+			{
+				sweep.expand(binBoxes[b]);
+				total += binCounts[b];
+				rightArea[b] = sweep.surfaceArea();
+				rightCount[b] = total;
+			}
+			sweep = Aabb();
+			total = 0;
+			for (int b = 0; b < BINS - 1; b++)
+			{
+				sweep.expand(binBoxes[b]);
+				total += binCounts[b];
+				if (total == 0 || rightCount[b + 1] == 0)
+					continue;
+				float splitCost = sweep.surfaceArea() * total + rightArea[b + 1] * rightCount[b + 1];
+				if (splitCost < bestCost)
+				{
+					bestCost = splitCost;
+					bestAxis = axis;
+					bestBin = b;
+				}
+			}
+		}
+
+		// all centroids in one spot: any halving is as good as another
+		if (bestAxis < 0)
+			return count / 2;
+
+		float scale = BINS / (centers.max[bestAxis] - centers.min[bestAxis]);
+		float minimum = centers.min[bestAxis];
+		uint32_t* begin = &order[first];
+		uint32_t* middle = std::partition(begin, begin + count, [&](uint32_t object)
+		{
+			return std::min(BINS - 1, (int)((centroids[(size_t)object * 3 + bestAxis] - minimum) * scale)) <= bestBin;
+		});
+		return (uint32_t)(middle - begin);
+	}
+
+	// Test objects [begin, end) (tree positions) against the planes in 'mask'
+	// -------------------------------------------------------------------
+	void testObjects(const Frustum& frustum, unsigned int mask, size_t begin, size_t end, std::vector<uint32_t>& visible, Instructions instructions) const
+	{
+		int planes[6];
+		int planeCount = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			if (mask & (1u << i))
+				planes[planeCount++] = i;
+		}
+		size_t i = begin;
+#ifdef CULLING_AVX2
+		if (instructions == AVX2)
+		{
+			for (; i + 8 <= end; i += 8)
+			{
+				__m256 outside = _mm256_setzero_ps();
+				for (int k = 0; k < planeCount; k++)
+				{
+					const float* p = frustum.planes[planes[k]];
+					// the corner farthest along the plane normal
+					__m256 x = _mm256_loadu_ps(&boxes[p[0] > 0.0f ? 3 : 0][i]);
+					__m256 y = _mm256_loadu_ps(&boxes[p[1] > 0.0f ? 4 : 1][i]);
+					__m256 z = _mm256_loadu_ps(&boxes[p[2] > 0.0f ? 5 : 2][i]);
+					__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(p[0])), _mm256_mul_ps(y, _mm256_set1_ps(p[1]))),
+						_mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(p[2])), _mm256_set1_ps(p[3])));
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+				}
+				appendVisible(~_mm256_movemask_ps(outside) & 0xff, i, visible);
+			}
+		}
+#endif
+#ifdef CULLING_SSE2
+		if (instructions >= SSE2)
+		{
+			for (; i + 4 <= end; i += 4)
+			{
+				__m128 outside = _mm_setzero_ps();
+				for (int k = 0; k < planeCount; k++)
+				{
+					const float* p = frustum.planes[planes[k]];
+					__m128 x = _mm_loadu_ps(&boxes[p[0] > 0.0f ? 3 : 0][i]);
+					__m128 y = _mm_loadu_ps(&boxes[p[1] > 0.0f ? 4 : 1][i]);
+					__m128 z = _mm_loadu_ps(&boxes[p[2] > 0.0f ? 5 : 2][i]);
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p[0])), _mm_mul_ps(y, _mm_set1_ps(p[1]))),
+						_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p[2])), _mm_set1_ps(p[3])));
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+				}
+				appendVisible(~_mm_movemask_ps(outside) & 0xf, i, visible);
+			}
+		}
+#endif
+		for (; i < end; i++)
+		{
+			bool inside = true;
+			for (int k = 0; k < planeCount && inside; k++)
+			{
+				const float* p = frustum.planes[planes[k]];
+				float x = boxes[p[0] > 0.0f ? 3 : 0][i];
+				float y = boxes[p[1] > 0.0f ? 4 : 1][i];
+				float z = boxes[p[2] > 0.0f ? 5 : 2][i];
+				inside = (x * p[0] + y * p[1]) + (z * p[2] + p[3]) >= 0.0f;
+			}
+			if (inside)
+				visible.push_back(order[i]);
+		}
+	}
+
+	// Objects at i + each set bit of 'bits' are visible
+	void appendVisible(int bits, size_t i, std::vector<uint32_t>& visible) const
+	{
+		while (bits)
+		{
+			int lane = 0;
+			while (!(bits & (1 << lane)))
+				lane++;
+			visible.push_back(order[i + lane]);
+			bits &= bits - 1;
+		}
+	}
+};
+#endif
@@ -0,0 +1,326 @@
+#ifndef FRAME_BENCHMARK_H
+#define FRAME_BENCHMARK_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Frame Benchmark Declaration
+// Benchmark mode for the render loops. AppWindow owns one: with --benchmark
+// (or GL_BENCHMARK=1) its getTime() steps by a fixed simulated time per
+// frame instead of the wall clock, so every run renders the same frames,
+// and it closes after 'warmup' + 'frames' frames. Every measured frame is
+// timed from one swap to the next, with a glFinish before the end so GPU
+// work is included; the CPU time the rendering thread used is recorded
+// alongside. At the end mean/p50/p95/p99/max of both are printed as JSON
+// (and written to 'outputPath'), and compared with a saved result: a metric
+// more than 'threshold' percent above the baseline is a regression, and
+// AppWindow::exitCode() becomes non-zero for the CI job.
+//   --benchmark                 or GL_BENCHMARK=1
+//   --benchmark-warmup N        or GL_BENCHMARK_WARMUP=N (default 60)
+//   --benchmark-frames M        or GL_BENCHMARK_FRAMES=M (default 600)
+//   --benchmark-out FILE        or GL_BENCHMARK_OUT=FILE
+//   --benchmark-baseline FILE   or GL_BENCHMARK_BASELINE=FILE
+//   --benchmark-threshold PCT   or GL_BENCHMARK_THRESHOLD=PCT (default 5)
+// Works windowed (vsync is turned off) and headless.
+
+class FrameBenchmark
+{
+public:
+	static const int EXIT_REGRESSION = 3;
+
+	struct Settings
+	{
+		bool enabled = false;
+		int warmup = 60;
+		int frames = 600;
+		double timeStep = 1.0 / 60.0;  // simulated seconds per frame
+		std::string outputPath;
+		std::string baselinePath;
+		double threshold = 5.0;        // percent
+	};
+
+	// Percentiles of one series (milliseconds)
+	struct Summary
+	{
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	FrameBenchmark()
+	{
+		readEnvironment();
+	}
+
+	// Settings from the environment, then from (and removed from) argv
+	// -------------------------------------------------------------------
+	FrameBenchmark(int& argc, char** argv)
+	{
+		readEnvironment();
+		readArguments(argc, argv);
+	}
+
+	bool isEnabled() const { return settings.enabled; }
+	const Settings& getSettings() const { return settings; }
+	int totalFrames() const { return settings.warmup + settings.frames; }
+	bool isFinished() const { return (int)frameTimes.size() >= settings.frames; }
+	bool hasPassed() const { return passed; }
+
+	// Simulated time of a frame
+	double getTime(int frame) const
+	{
+		return frame * settings.timeStep;
+	}
+
+	// Start of the first frame (AppWindow::open)
+	// -------------------------------------------------------------------
+	void start()
+	{
+		lastWall = std::chrono::steady_clock::now();
+		lastCpu = threadCpuTime();
+	}
+
+	// End of frame 'frame': 'cpuEnd' is the thread CPU time taken before
+	// waiting on the GPU, the wall clock is read now (after glFinish)
+	// -------------------------------------------------------------------
+	void endFrame(int frame, double cpuEnd)
+	{
+		std::chrono::steady_clock::time_point wall = std::chrono::steady_clock::now();
+		double frameMs = std::chrono::duration<double, std::milli>(wall - lastWall).count();
+		double cpuMs = (cpuEnd - lastCpu) * 1000.0;
+		lastWall = wall;
+		lastCpu = threadCpuTime();
+		if (frame < settings.warmup || isFinished())
+			return;
+		frameTimes.push_back(frameMs);
+		cpuTimes.push_back(cpuMs);
+	}
+
+	// Print the result as JSON, write it to the output file and compare
+	// it with the baseline. Returns false on a regression.
+	// -------------------------------------------------------------------
+	bool report(const std::string& program, const std::string& mode, const std::string& renderer)
+	{
+		Summary frame = summarize(frameTimes);
+		Summary cpu = summarize(cpuTimes);
+		std::ostringstream json;
+		json << "{\n"
+			<< "  \"program\": \"" << escape(program) << "\",\n"
+			<< "  \"mode\": \"" << mode << "\",\n"
+			<< "  \"renderer\": \"" << escape(renderer) << "\",\n"
+			<< "  \"warmup\": " << settings.warmup << ",\n"
+			<< "  \"frames\": " << frameTimes.size() << ",\n"
+			<< "  \"timeStep\": " << settings.timeStep << ",\n"
+			<< "  \"frameTime\": " << toJson(frame) << ",\n"
+			<< "  \"cpuTime\": " << toJson(cpu) << "\n"
+			<< "}\n";
+		std::cout << json.str();
+		if (!settings.outputPath.empty())
+		{
+			std::ofstream file(settings.outputPath);
+			if (file)
+				file << json.str();
+			else
+				std::cout << "ERROR::FRAME_BENCHMARK::WRITE_FAILED " << settings.outputPath << std::endl;
+		}
+		passed = true;
+		if (!settings.baselinePath.empty())
+			passed = compare(frame, cpu);
+		return passed;
+	}
+
+	// -------------------------------------------------------------------
+	static Summary summarize(std::vector<double> values)
+	{
+		Summary summary;
+		if (values.empty())
+			return summary;
+		std::sort(values.begin(), values.end());
+		double total = 0.0;
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			total += values[i];
+		}
+		size_t last = values.size() - 1;
+		summary.mean = total / values.size();
+		summary.p50 = values[last / 2];
+		summary.p95 = values[last * 95 / 100];
+		summary.p99 = values[last * 99 / 100];
+		summary.max = values[last];
+		return summary;
+	}
+
+	// Thread CPU time in seconds
+	// -------------------------------------------------------------------
+	static double threadCpuTime()
+	{
+#ifdef _WIN32
+		FILETIME creation, exit, kernel, user;
+		if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+			return 0.0;
+		unsigned long long ticks = ((unsigned long long)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime)
+			+ ((unsigned long long)user.dwHighDateTime << 32 | user.dwLowDateTime);
+		return ticks * 1e-7;
+#else
+		timespec time;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+		return time.tv_sec + time.tv_nsec * 1e-9;
+#endif
+	}
+
+private:
+	Settings settings;
+	std::vector<double> frameTimes;
+	std::vector<double> cpuTimes;
+	std::chrono::steady_clock::time_point lastWall;
+	double lastCpu = 0.0;
+	bool passed = true;
+
+	// -------------------------------------------------------------------
+	void readEnvironment()
+	{
+		const char* value = std::getenv("GL_BENCHMARK");
+		if (value != NULL && value[0] != '\0' && std::strcmp(value, "0") != 0)
+			settings.enabled = true;
+		if ((value = std::getenv("GL_BENCHMARK_WARMUP")) != NULL)
+			settings.warmup = std::max(0, std::atoi(value));
+		if ((value = std::getenv("GL_BENCHMARK_FRAMES")) != NULL)
+			settings.frames = std::max(1, std::atoi(value));
+		if ((value = std::getenv("GL_BENCHMARK_OUT")) != NULL)
+			settings.outputPath = value;
+		if ((value = std::getenv("GL_BENCHMARK_BASELINE")) != NULL)
+			settings.baselinePath = value;
+		if ((value = std::getenv("GL_BENCHMARK_THRESHOLD")) != NULL)
+			settings.threshold = std::atof(value);
+	}
+
+	// -------------------------------------------------------------------
+	void readArguments(int& argc, char** argv)
+	{
+		int kept = 1;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--benchmark")
+				settings.enabled = true;
+			else if (arg == "--benchmark-warmup" && hasValue)
+				settings.warmup = std::max(0, std::atoi(argv[++i]));
+			else if (arg == "--benchmark-frames" && hasValue)
+				settings.frames = std::max(1, std::atoi(argv[++i]));
+			else if (arg == "--benchmark-out" && hasValue)
+				settings.outputPath = argv[++i];
+			else if (arg == "--benchmark-baseline" && hasValue)
+				settings.baselinePath = argv[++i];
+			else if (arg == "--benchmark-threshold" && hasValue)
+				settings.threshold = std::atof(argv[++i]);
+			else
+				argv[kept++] = argv[i];
+		}
+		argc = kept;
+		argv[argc] = NULL;
+	}
+
+	// Metrics that count as a regression, checked against the baseline
+	// -------------------------------------------------------------------
+	bool compare(const Summary& frame, const Summary& cpu)
+	{
+		std::ifstream file(settings.baselinePath);
+		if (!file)
+		{
+			std::cout << "ERROR::FRAME_BENCHMARK::NO_BASELINE " << settings.baselinePath << std::endl;
+			return false;
+		}
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		std::string baseline = buffer.str();
+		const char* sections[2] = { "frameTime", "cpuTime" };
+		const Summary* current[2] = { &frame, &cpu };
+		const char* keys[4] = { "mean", "p50", "p95", "p99" };
+		bool ok = true;
+		std::cout << "FRAME_BENCHMARK:: against " << settings.baselinePath << " (threshold " << settings.threshold << "%)" << std::endl;
+		for (int s = 0; s < 2; s++)
+		{
+			const double values[4] = { current[s]->mean, current[s]->p50, current[s]->p95, current[s]->p99 };
+			for (int k = 0; k < 4; k++)
+			{
+				double old = 0.0;
+				if (!readNumber(baseline, sections[s], keys[k], old))
+				{
+					std::cout << "ERROR::FRAME_BENCHMARK::BASELINE_MISSING " << sections[s] << "." << keys[k] << std::endl;
+					ok = false;
+					continue;
+				}
+				double change = old > 0.0 ? (values[k] - old) / old * 100.0 : 0.0;
+				bool regressed = change > settings.threshold;
+				std::cout << "FRAME_BENCHMARK::   " << sections[s] << "." << keys[k] << ": " << old << " -> " << values[k] << " ms ("
+					<< (change >= 0.0 ? "+" : "") << change << "%)" << (regressed ? " REGRESSION" : "") << std::endl;
+				ok = ok && !regressed;
+			}
+		}
+		std::cout << "FRAME_BENCHMARK:: " << (ok ? "passed" : "FAILED") << std::endl;
+		return ok;
+	}
+
+	// "section": { ... "key": number ... } in a result written by report()
+	// -------------------------------------------------------------------
+	static bool readNumber(const std::string& json, const std::string& section, const std::string& key, double& value)
+	{
+		size_t at = json.find("\"" + section + "\"");
+		if (at == std::string::npos)
+			return false;
+		size_t end = json.find('}', at);
+		at = json.find("\"" + key + "\"", at);
+		if (at == std::string::npos || at > end)
+			return false;
+		at = json.find(':', at);
+		if (at == std::string::npos)
+			return false;
+		char* parsed = NULL;
+		value = std::strtod(json.c_str() + at + 1, &parsed);
+		return parsed != json.c_str() + at + 1;
+	}
+
+	static std::string toJson(const Summary& summary)
+	{
+		std::ostringstream json;
+		json << "{ \"mean\": " << summary.mean << ", \"p50\": " << summary.p50 << ", \"p95\": " << summary.p95 << ", \"p99\": "
+			<< summary.p99 << ", \"max\": " << summary.max << " }";
+		return json.str();
+	}
+
+	static std::string escape(const std::string& text)
+	{
+		std::string escaped;
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			if (text[i] == '"' || text[i] == '\\')
+				escaped += '\\';
+			escaped += text[i];
+		}
+		return escaped;
+	}
+};
+#endif
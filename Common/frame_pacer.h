@@ -0,0 +1,339 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <glad/glad.h>
+#include "frame_benchmark.h"
+
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+// Frame Pacer Declaration
+// Paces the render loop after every swap, before the next frame's events
+// are polled. AppWindow owns one.
+// Frames in flight: a fence is put behind every frame, and once more than
+// 'framesInFlight' frames are queued the CPU waits (glClientWaitSync) for
+// the oldest one, so the driver cannot buffer several frames of input lag
+// ahead of the display. 0 leaves the queue to the driver.
+// Frame rate limit: with a target fps every frame gets a deadline one
+// period after the previous one. The thread sleeps until 'spin'
+// microseconds before it, which is coarse (the OS scheduler may wake it a
+// millisecond or more late), then spins on the clock for the rest. A
+// larger spin is more precise and burns more CPU. A frame that misses its
+// deadline by more than a period starts a new schedule instead of rushing
+// to catch up.
+// The stats give the achieved frame time, its jitter (standard deviation
+// and p99 - p50), the time spent waiting on fences, sleeping and spinning,
+// and how busy the render thread was, to pick settings per machine.
+//   --swap-interval N        or GL_SWAP_INTERVAL=N (default: driver's)
+//   --frames-in-flight N     or GL_FRAMES_IN_FLIGHT=N (default 2, 0 = off)
+//   --target-fps F           or GL_TARGET_FPS=F (default 0 = off)
+//   --pacing-spin US         or GL_PACING_SPIN=US (default 1500)
+//   --pacing-stats           or GL_PACING_STATS=1, printed on close
+// Fences are core in 3.2, so this works on every context AppWindow opens.
+
+class FramePacer
+{
+public:
+	static const int MAX_FRAMES_IN_FLIGHT = 8;
+	static const int HISTORY = 600; // frame intervals kept for the stats
+
+	struct Settings
+	{
+		int swapInterval = -1;     // -1 = leave the driver's default
+		int framesInFlight = 2;    // 0 = no limit
+		double targetFps = 0.0;    // 0 = no limit
+		int spinMicros = 1500;     // spin instead of sleeping this close to a deadline
+		bool printStats = false;
+	};
+
+	struct Stats
+	{
+		int frames = 0;
+		double meanMs = 0.0;
+		double jitterMs = 0.0;     // standard deviation of the frame time
+		double p50Ms = 0.0;
+		double p99Ms = 0.0;
+		double maxMs = 0.0;
+		double fenceWaitMs = 0.0;  // per frame
+		double sleepMs = 0.0;      // per frame
+		double spinMs = 0.0;       // per frame
+		double cpuUsage = 0.0;     // render thread CPU time / wall time
+		int missed = 0;            // frames past their deadline (target fps)
+	};
+
+	FramePacer()
+	{
+		readEnvironment();
+	}
+
+	// Settings from the environment, then from (and removed from) argv
+	// -------------------------------------------------------------------
+	FramePacer(int& argc, char** argv)
+	{
+		readEnvironment();
+		readArguments(argc, argv);
+	}
+
+	const Settings& getSettings() const { return settings; }
+
+	void setFramesInFlight(int frames)
+	{
+		settings.framesInFlight = frames < 0 ? 0 : frames > MAX_FRAMES_IN_FLIGHT ? MAX_FRAMES_IN_FLIGHT : frames;
+	}
+
+	void setTargetFps(double fps)
+	{
+		settings.targetFps = std::max(0.0, fps);
+		deadlineSet = false;
+	}
+
+	// Start of the first frame (AppWindow::open)
+	// -------------------------------------------------------------------
+	void start()
+	{
+		lastFrame = std::chrono::steady_clock::now();
+		deadlineSet = false;
+		cpuSampled = false;
+	}
+
+	// After the swap: fence the frame, wait for old frames, then hold the
+	// thread until the frame's deadline
+	// -------------------------------------------------------------------
+	void endFrame()
+	{
+		if (settings.framesInFlight > 0)
+			limitFramesInFlight();
+		if (settings.targetFps > 0.0)
+			waitForDeadline();
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double ms = std::chrono::duration<double, std::milli>(now - lastFrame).count();
+		lastFrame = now;
+		if (frameTimes.size() < (size_t)HISTORY)
+			frameTimes.push_back(ms);
+		else
+			frameTimes[nextFrame] = ms;
+		nextFrame = (nextFrame + 1) % HISTORY;
+		frames++;
+
+		// CPU time is per thread, so sample it on the thread that presents
+		// (the render thread under RenderThread)
+		double cpu = FrameBenchmark::threadCpuTime();
+		if (!cpuSampled)
+		{
+			startCpu = cpu;
+			startWall = now;
+			cpuSampled = true;
+		}
+		lastCpu = cpu;
+		lastWall = now;
+	}
+
+	// -------------------------------------------------------------------
+	Stats getStats() const
+	{
+		Stats stats;
+		stats.frames = frames;
+		if (frameTimes.empty())
+			return stats;
+		std::vector<double> sorted = frameTimes;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0.0;
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			total += sorted[i];
+		}
+		stats.meanMs = total / sorted.size();
+		double variance = 0.0;
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			variance += (sorted[i] - stats.meanMs) * (sorted[i] - stats.meanMs);
+		}
+		stats.jitterMs = std::sqrt(variance / sorted.size());
+		size_t last = sorted.size() - 1;
+		stats.p50Ms = sorted[last / 2];
+		stats.p99Ms = sorted[last * 99 / 100];
+		stats.maxMs = sorted[last];
+		stats.fenceWaitMs = fenceWaitMs / frames;
+		stats.sleepMs = sleepMs / frames;
+		stats.spinMs = spinMs / frames;
+		double wall = std::chrono::duration<double>(lastWall - startWall).count();
+		if (wall > 0.0)
+			stats.cpuUsage = (lastCpu - startCpu) / wall;
+		stats.missed = missed;
+		return stats;
+	}
+
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		Stats stats = getStats();
+		std::cout << "FRAME_PACER:: swap interval ";
+		if (settings.swapInterval < 0)
+			std::cout << "default";
+		else
+			std::cout << settings.swapInterval;
+		std::cout << ", frames in flight " << settings.framesInFlight << ", target ";
+		if (settings.targetFps > 0.0)
+			std::cout << settings.targetFps << " fps (spin " << settings.spinMicros << " us)";
+		else
+			std::cout << "none";
+		std::cout << std::endl;
+		std::cout << "FRAME_PACER:: " << stats.frames << " frames, last " << frameTimes.size() << ": mean " << stats.meanMs
+			<< " ms, jitter " << stats.jitterMs << " ms (p99 - p50 " << stats.p99Ms - stats.p50Ms << " ms), max " << stats.maxMs << " ms";
+		if (settings.targetFps > 0.0)
+			std::cout << ", missed " << stats.missed;
+		std::cout << std::endl;
+		std::cout << "FRAME_PACER:: per frame: fence wait " << stats.fenceWaitMs << " ms, sleep " << stats.sleepMs << " ms, spin "
+			<< stats.spinMs << " ms; render thread CPU " << stats.cpuUsage * 100.0 << "%" << std::endl;
+	}
+
+	// Delete the pending fences; needs the context current
+	// -------------------------------------------------------------------
+	void release()
+	{
+		for (int i = 0; i < pendingCount; i++)
+		{
+			glDeleteSync(fences[(firstPending + i) % MAX_FRAMES_IN_FLIGHT]);
+		}
+		firstPending = 0;
+		pendingCount = 0;
+	}
+
+private:
+	Settings settings;
+	GLsync fences[MAX_FRAMES_IN_FLIGHT] = {};
+	int firstPending = 0;
+	int pendingCount = 0;
+	std::chrono::steady_clock::time_point lastFrame;
+	std::chrono::steady_clock::time_point deadline;
+	bool deadlineSet = false;
+	bool cpuSampled = false;
+	std::chrono::steady_clock::time_point startWall; // first endFrame()
+	std::chrono::steady_clock::time_point lastWall;
+	double startCpu = 0.0;
+	double lastCpu = 0.0;
+	std::vector<double> frameTimes;
+	size_t nextFrame = 0;
+	int frames = 0;
+	int missed = 0;
+	double fenceWaitMs = 0.0;
+	double sleepMs = 0.0;
+	double spinMs = 0.0;
+
+	// -------------------------------------------------------------------
+	void limitFramesInFlight()
+	{
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		if (fence == 0)
+			return;
+		fences[(firstPending + pendingCount) % MAX_FRAMES_IN_FLIGHT] = fence;
+		pendingCount++;
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		while (pendingCount > settings.framesInFlight)
+		{
+			GLsync oldest = fences[firstPending];
+			// flush so the fence is sure to be reached; 100 ms steps so a
+			// lost device does not hang the loop forever
+			GLenum result = glClientWaitSync(oldest, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+			if (result == GL_TIMEOUT_EXPIRED)
+				continue;
+			if (result == GL_WAIT_FAILED)
+				std::cout << "ERROR::FRAME_PACER::WAIT_FAILED" << std::endl;
+			glDeleteSync(oldest);
+			firstPending = (firstPending + 1) % MAX_FRAMES_IN_FLIGHT;
+			pendingCount--;
+		}
+		fenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	// Coarse sleep, then spin up to the deadline
+	// -------------------------------------------------------------------
+	void waitForDeadline()
+	{
+		std::chrono::steady_clock::duration period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(1.0 / settings.targetFps));
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (!deadlineSet)
+		{
+			deadline = now;
+			deadlineSet = true;
+		}
+		deadline += period;
+		if (now > deadline)
+		{
+			missed++;
+			// more than a period late: start over rather than run a burst
+			// of short frames to catch up
+			if (now - deadline > period)
+				deadline = now;
+			return;
+		}
+
+		std::chrono::steady_clock::time_point wake = deadline - std::chrono::microseconds(settings.spinMicros);
+		if (now < wake)
+		{
+			std::this_thread::sleep_until(wake);
+			std::chrono::steady_clock::time_point slept = std::chrono::steady_clock::now();
+			sleepMs += std::chrono::duration<double, std::milli>(slept - now).count();
+			now = slept;
+		}
+		std::chrono::steady_clock::time_point spinStart = now;
+		while (now < deadline)
+		{
+			now = std::chrono::steady_clock::now();
+		}
+		spinMs += std::chrono::duration<double, std::milli>(now - spinStart).count();
+	}
+
+	// -------------------------------------------------------------------
+	void readEnvironment()
+	{
+		const char* value = std::getenv("GL_SWAP_INTERVAL");
+		if (value != NULL)
+			settings.swapInterval = std::atoi(value);
+		if ((value = std::getenv("GL_FRAMES_IN_FLIGHT")) != NULL)
+			setFramesInFlight(std::atoi(value));
+		if ((value = std::getenv("GL_TARGET_FPS")) != NULL)
+			setTargetFps(std::atof(value));
+		if ((value = std::getenv("GL_PACING_SPIN")) != NULL)
+			settings.spinMicros = std::max(0, std::atoi(value));
+		value = std::getenv("GL_PACING_STATS");
+		if (value != NULL && value[0] != '\0' && std::strcmp(value, "0") != 0)
+			settings.printStats = true;
+	}
+
+	// -------------------------------------------------------------------
+	void readArguments(int& argc, char** argv)
+	{
+		int kept = 1;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if (arg == "--swap-interval" && hasValue)
+				settings.swapInterval = std::atoi(argv[++i]);
+			else if (arg == "--frames-in-flight" && hasValue)
+				setFramesInFlight(std::atoi(argv[++i]));
+			else if (arg == "--target-fps" && hasValue)
+				setTargetFps(std::atof(argv[++i]));
+			else if (arg == "--pacing-spin" && hasValue)
+				settings.spinMicros = std::max(0, std::atoi(argv[++i]));
+			else if (arg == "--pacing-stats")
+				settings.printStats = true;
+			else
+				argv[kept++] = argv[i];
+		}
+		argc = kept;
+		argv[argc] = NULL;
+	}
+};
+#endif
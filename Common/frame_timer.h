@@ -0,0 +1,82 @@
+#ifndef FRAME_TIMER_H
+#define FRAME_TIMER_H
+
+#include <chrono>
+#include <iostream>
+
+// Frame Timer Declaration
+// Call tick() once per frame. Frames can be flagged with markEvent() (for
+// example the frame a shader reload was applied in) so their times are
+// reported separately from ordinary frames.
+
+class FrameTimer
+{
+public:
+	// Running statistics for a group of frames (milliseconds)
+	struct Stats
+	{
+		unsigned long long frames = 0;
+		double total = 0.0;
+		double worst = 0.0;
+
+		void add(double ms)
+		{
+			frames++;
+			total += ms;
+			if (ms > worst)
+				worst = ms;
+		}
+		double mean() const { return frames ? total / frames : 0.0; }
+	};
+
+	// Ends the current frame and returns its duration in milliseconds
+	// -------------------------------------------------------------------
+	double tick()
+	{
+		auto now = std::chrono::steady_clock::now();
+		double ms = 0.0;
+		if (started)
+		{
+			ms = std::chrono::duration<double, std::milli>(now - last).count();
+			if (eventPending)
+				eventFrames.add(ms);
+			else
+				frames.add(ms);
+		}
+		started = true;
+		eventPending = false;
+		last = now;
+		return ms;
+	}
+
+	// Flag the frame in progress as containing an event
+	// -------------------------------------------------------------------
+	void markEvent()
+	{
+		eventPending = true;
+	}
+
+	const Stats& getFrames() const { return frames; }
+	const Stats& getEventFrames() const { return eventFrames; }
+
+	// Print mean/worst frame time with flagged frames listed separately
+	// -------------------------------------------------------------------
+	void printStats(const char* eventName) const
+	{
+		std::cout << "FRAME_TIMER:: frames: " << frames.frames << " mean: " << frames.mean()
+			<< " ms worst: " << frames.worst << " ms" << std::endl;
+		if (eventFrames.frames > 0)
+		{
+			std::cout << "FRAME_TIMER:: " << eventName << " frames: " << eventFrames.frames
+				<< " mean: " << eventFrames.mean() << " ms worst: " << eventFrames.worst << " ms" << std::endl;
+		}
+	}
+
+private:
+	std::chrono::steady_clock::time_point last;
+	bool started = false;
+	bool eventPending = false;
+	Stats frames;
+	Stats eventFrames;
+};
+#endif
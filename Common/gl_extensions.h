@@ -0,0 +1,106 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <set>
+#include <string>
+
+// GL Extension Helpers
+// GLAD is generated for plain 3.3 core, so optional extensions are detected
+// here at runtime and their entry points fetched through the same loader that
+// was handed to GLAD (glfwGetProcAddress unless changed with setLoader).
+
+class GLExtensions
+{
+public:
+	typedef void* (*LoadProc)(const char* name);
+
+	// Is the extension advertised by the current context?
+	// -------------------------------------------------------------------
+	static bool has(const char* name)
+	{
+		std::set<std::string>& names = extensionNames();
+		if (names.empty())
+		{
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+			for (GLint i = 0; i < count; i++)
+			{
+				const GLubyte* extension = glGetStringi(GL_EXTENSIONS, (GLuint)i);
+				if (extension)
+					names.insert(reinterpret_cast<const char*>(extension));
+			}
+		}
+		return names.count(name) > 0;
+	}
+
+	// Is the context at least version major.minor?
+	// -------------------------------------------------------------------
+	static bool version(int major, int minor)
+	{
+		GLint currentMajor = 0;
+		GLint currentMinor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &currentMajor);
+		glGetIntegerv(GL_MINOR_VERSION, &currentMinor);
+		return currentMajor > major || (currentMajor == major && currentMinor >= minor);
+	}
+
+	// Look up an entry point (NULL if the driver does not export it)
+	// -------------------------------------------------------------------
+	static void* getProcAddress(const char* name)
+	{
+		return loader()(name);
+	}
+
+	// Replace the loader, e.g. with eglGetProcAddress for offscreen contexts
+	// -------------------------------------------------------------------
+	static void setLoader(LoadProc proc)
+	{
+		loader() = proc;
+		extensionNames().clear();
+	}
+
+private:
+	static void* glfwLoader(const char* name)
+	{
+		return (void*)glfwGetProcAddress(name);
+	}
+	static LoadProc& loader()
+	{
+		static LoadProc proc = glfwLoader;
+		return proc;
+	}
+	static std::set<std::string>& extensionNames()
+	{
+		static std::set<std::string> names;
+		return names;
+	}
+};
+
+// KHR_parallel_shader_compile
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// EXT_texture_filter_anisotropic (core in 4.6)
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+
+// ARB_draw_indirect (core in 4.0), ARB_base_instance (4.2), ARB_multi_draw_indirect (4.3)
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+typedef void (APIENTRYP PFNMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount, GLint basevertex, GLuint baseinstance);
+
+#endif
@@ -0,0 +1,544 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+#include "gl_extensions.h"
+
+#include <map>
+#include <algorithm>
+#include <iostream>
+
+// GL State Cache Declaration
+// Remembers what is bound and enabled and drops calls that would not change
+// anything (re-using the same program, re-binding the same VAO, setting the
+// polygon mode every frame ...). Nothing is queried from GL: every slot
+// starts out unknown, so the first call always goes through.
+// Creating and editing resources goes through direct state access
+// (GL 4.5 / ARB_direct_state_access) when available, so it does not touch the
+// bindings at all; otherwise the object is bound through the cache.
+// The cache only stays correct if everything binds through it: after raw GL
+// calls, call invalidate(). Delete objects with the delete* helpers so a
+// recycled name is not mistaken for the object that is still cached.
+// instance() is per thread, i.e. one cache per context-owning thread.
+
+class GLState
+{
+public:
+	enum Category
+	{
+		PROGRAM,
+		VERTEX_ARRAY,
+		BUFFER,
+		TEXTURE,
+		SAMPLER,
+		RASTER,
+		CATEGORY_COUNT
+	};
+
+	struct Counters
+	{
+		unsigned long long issued[CATEGORY_COUNT] = {};
+		unsigned long long filtered[CATEGORY_COUNT] = {};
+
+		unsigned long long totalIssued() const { return sum(issued); }
+		unsigned long long totalFiltered() const { return sum(filtered); }
+
+	private:
+		static unsigned long long sum(const unsigned long long* values)
+		{
+			unsigned long long total = 0;
+			for (int i = 0; i < CATEGORY_COUNT; i++)
+			{
+				total += values[i];
+			}
+			return total;
+		}
+	};
+
+	static const GLuint UNKNOWN = 0xFFFFFFFFu;
+	static const int TRACKED_UNITS = 32;
+
+	// Cache for the calling thread's context
+	// -------------------------------------------------------------------
+	static GLState& instance()
+	{
+		static thread_local GLState state;
+		return state;
+	}
+
+	// Program, vertex array and buffer bindings
+	// -------------------------------------------------------------------
+	void useProgram(GLuint program)
+	{
+		if (program == currentProgram && skip(PROGRAM))
+			return;
+		issue(PROGRAM);
+		currentProgram = program;
+		glUseProgram(program);
+	}
+	// -------------------------------------------------------------------
+	void bindVertexArray(GLuint vertexArray)
+	{
+		if (vertexArray == currentVertexArray && skip(VERTEX_ARRAY))
+			return;
+		issue(VERTEX_ARRAY);
+		currentVertexArray = vertexArray;
+		// the element buffer binding belongs to the vertex array
+		buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+		glBindVertexArray(vertexArray);
+	}
+	// -------------------------------------------------------------------
+	void bindBuffer(GLenum target, GLuint buffer)
+	{
+		int index = bufferIndex(target);
+		if (index >= 0 && buffers[index] == buffer && skip(BUFFER))
+			return;
+		issue(BUFFER);
+		if (index >= 0)
+			buffers[index] = buffer;
+		glBindBuffer(target, buffer);
+	}
+	// Indexed binding (uniform blocks); also sets the generic binding
+	// -------------------------------------------------------------------
+	void bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		bool tracked = target == GL_UNIFORM_BUFFER && index < TRACKED_UNITS;
+		if (tracked && uniformBuffers[index] == buffer && skip(BUFFER))
+			return;
+		issue(BUFFER);
+		if (tracked)
+			uniformBuffers[index] = buffer;
+		int generic = bufferIndex(target);
+		if (generic >= 0)
+			buffers[generic] = buffer;
+		glBindBufferBase(target, index, buffer);
+	}
+	// Indexed binding of a range; ranges change every frame, so it is
+	// always issued and the slot is only remembered as "unknown"
+	// -------------------------------------------------------------------
+	void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		issue(BUFFER);
+		if (target == GL_UNIFORM_BUFFER && index < TRACKED_UNITS)
+			uniformBuffers[index] = UNKNOWN;
+		int generic = bufferIndex(target);
+		if (generic >= 0)
+			buffers[generic] = buffer;
+		glBindBufferRange(target, index, buffer, offset, size);
+	}
+
+	// Textures and samplers. bindTexture is for drawing: with DSA it uses
+	// glBindTextureUnit and leaves the active unit alone.
+	// -------------------------------------------------------------------
+	void activeTexture(GLuint unit)
+	{
+		if (unit == activeUnit && skip(TEXTURE))
+			return;
+		issue(TEXTURE);
+		activeUnit = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	// -------------------------------------------------------------------
+	void bindTexture(GLuint unit, GLenum target, GLuint texture)
+	{
+		int index = textureIndex(target);
+		bool tracked = index >= 0 && unit < TRACKED_UNITS;
+		if (tracked && textures[unit][index] == texture && skip(TEXTURE))
+			return;
+		issue(TEXTURE);
+		if (tracked)
+			textures[unit][index] = texture;
+		if (hasDirectStateAccess() && texture != 0)
+		{
+			// binds to the unit's slot for the texture's own target
+			dsa.bindTextureUnit(unit, texture);
+			return;
+		}
+		activeTexture(unit);
+		glBindTexture(target, texture);
+	}
+	// Bind to the active unit to create or edit a texture without DSA.
+	// Always a real glBindTexture: a new name only gets its target from that.
+	// -------------------------------------------------------------------
+	void bindTextureForEdit(GLenum target, GLuint texture)
+	{
+		if (activeUnit == UNKNOWN)
+			activeTexture(0);
+		int index = textureIndex(target);
+		// never skipped: a recycled name may still be cached from the
+		// texture that had it before
+		issue(TEXTURE);
+		if (index >= 0 && activeUnit < TRACKED_UNITS)
+			textures[activeUnit][index] = texture;
+		glBindTexture(target, texture);
+	}
+	// -------------------------------------------------------------------
+	void bindSampler(GLuint unit, GLuint sampler)
+	{
+		bool tracked = unit < TRACKED_UNITS;
+		if (tracked && samplers[unit] == sampler && skip(SAMPLER))
+			return;
+		issue(SAMPLER);
+		if (tracked)
+			samplers[unit] = sampler;
+		glBindSampler(unit, sampler);
+	}
+
+	// Raster and pixel state
+	// -------------------------------------------------------------------
+	void enable(GLenum capability)
+	{
+		setCapability(capability, true);
+	}
+	// -------------------------------------------------------------------
+	void disable(GLenum capability)
+	{
+		setCapability(capability, false);
+	}
+	// -------------------------------------------------------------------
+	void setCapability(GLenum capability, bool enabled)
+	{
+		std::map<GLenum, bool>::iterator it = capabilities.find(capability);
+		if (it != capabilities.end() && it->second == enabled && skip(RASTER))
+			return;
+		issue(RASTER);
+		capabilities[capability] = enabled;
+		if (enabled)
+			glEnable(capability);
+		else
+			glDisable(capability);
+	}
+	// Core profile only accepts GL_FRONT_AND_BACK
+	// -------------------------------------------------------------------
+	void polygonMode(GLenum mode)
+	{
+		setRaster(GL_POLYGON_MODE, mode, [mode]() { glPolygonMode(GL_FRONT_AND_BACK, mode); });
+	}
+	// -------------------------------------------------------------------
+	void depthFunc(GLenum function)
+	{
+		setRaster(GL_DEPTH_FUNC, function, [function]() { glDepthFunc(function); });
+	}
+	// -------------------------------------------------------------------
+	void depthMask(bool write)
+	{
+		setRaster(GL_DEPTH_WRITEMASK, write ? 1u : 0u, [write]() { glDepthMask(write ? GL_TRUE : GL_FALSE); });
+	}
+	// -------------------------------------------------------------------
+	void cullFace(GLenum face)
+	{
+		setRaster(GL_CULL_FACE_MODE, face, [face]() { glCullFace(face); });
+	}
+	// -------------------------------------------------------------------
+	void blendFunc(GLenum source, GLenum destination)
+	{
+		setRaster(GL_BLEND_SRC_RGB, source << 16 | destination, [source, destination]() { glBlendFunc(source, destination); });
+	}
+	// -------------------------------------------------------------------
+	void pixelStore(GLenum name, GLint value)
+	{
+		setRaster(name, (GLuint)value, [name, value]() { glPixelStorei(name, value); });
+	}
+	// -------------------------------------------------------------------
+	void viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		GLint value[4] = { x, y, width, height };
+		if (viewportKnown && std::equal(value, value + 4, currentViewport) && skip(RASTER))
+			return;
+		issue(RASTER);
+		std::copy(value, value + 4, currentViewport);
+		viewportKnown = true;
+		glViewport(x, y, width, height);
+	}
+	// -------------------------------------------------------------------
+	void clearColor(float r, float g, float b, float a)
+	{
+		float value[4] = { r, g, b, a };
+		if (clearColorKnown && std::equal(value, value + 4, currentClearColor) && skip(RASTER))
+			return;
+		issue(RASTER);
+		std::copy(value, value + 4, currentClearColor);
+		clearColorKnown = true;
+		glClearColor(r, g, b, a);
+	}
+
+	// Resource editing: DSA when available, otherwise bind through the cache
+	// -------------------------------------------------------------------
+	void textureParameter(GLuint texture, GLenum target, GLenum name, GLint value)
+	{
+		if (hasDirectStateAccess())
+		{
+			dsa.textureParameteri(texture, name, value);
+			return;
+		}
+		bindTextureForEdit(target, texture);
+		glTexParameteri(target, name, value);
+	}
+	// -------------------------------------------------------------------
+	void textureSubImage2D(GLuint texture, GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+	{
+		if (hasDirectStateAccess())
+		{
+			dsa.textureSubImage2D(texture, level, x, y, width, height, format, type, pixels);
+			return;
+		}
+		bindTextureForEdit(target, texture);
+		glTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+	}
+	// -------------------------------------------------------------------
+	void bufferData(GLuint buffer, GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		if (hasDirectStateAccess())
+		{
+			dsa.namedBufferData(buffer, size, data, usage);
+			return;
+		}
+		bindBuffer(target, buffer);
+		glBufferData(target, size, data, usage);
+	}
+	// -------------------------------------------------------------------
+	void bufferSubData(GLuint buffer, GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		if (hasDirectStateAccess())
+		{
+			dsa.namedBufferSubData(buffer, offset, size, data);
+			return;
+		}
+		bindBuffer(target, buffer);
+		glBufferSubData(target, offset, size, data);
+	}
+
+	// Deleting drops the name from every cached binding
+	// -------------------------------------------------------------------
+	void deleteProgram(GLuint program)
+	{
+		if (currentProgram == program)
+			currentProgram = UNKNOWN;
+		glDeleteProgram(program);
+	}
+	// -------------------------------------------------------------------
+	void deleteVertexArray(GLuint vertexArray)
+	{
+		if (currentVertexArray == vertexArray)
+		{
+			currentVertexArray = UNKNOWN;
+			buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+		}
+		glDeleteVertexArrays(1, &vertexArray);
+	}
+	// -------------------------------------------------------------------
+	void deleteBuffer(GLuint buffer)
+	{
+		forget(buffers, BUFFER_TARGETS, buffer);
+		forget(uniformBuffers, TRACKED_UNITS, buffer);
+		glDeleteBuffers(1, &buffer);
+	}
+	// -------------------------------------------------------------------
+	void deleteTexture(GLuint texture)
+	{
+		for (int unit = 0; unit < TRACKED_UNITS; unit++)
+		{
+			forget(textures[unit], TEXTURE_TARGETS, texture);
+		}
+		glDeleteTextures(1, &texture);
+	}
+
+	// False after AppWindow::close() destroyed this thread's context: the
+	// objects went with it, so owners (e.g. Shader) skip deleting them
+	bool hasContext() const { return contextAlive; }
+	void setContextAlive(bool alive) { contextAlive = alive; }
+
+	// Forget everything, e.g. after code that binds with raw GL calls
+	// -------------------------------------------------------------------
+	void invalidate()
+	{
+		currentProgram = UNKNOWN;
+		currentVertexArray = UNKNOWN;
+		activeUnit = UNKNOWN;
+		std::fill(buffers, buffers + BUFFER_TARGETS, UNKNOWN);
+		std::fill(uniformBuffers, uniformBuffers + TRACKED_UNITS, UNKNOWN);
+		std::fill(samplers, samplers + TRACKED_UNITS, UNKNOWN);
+		for (int unit = 0; unit < TRACKED_UNITS; unit++)
+		{
+			std::fill(textures[unit], textures[unit] + TEXTURE_TARGETS, UNKNOWN);
+		}
+		capabilities.clear();
+		raster.clear();
+		viewportKnown = false;
+		clearColorKnown = false;
+	}
+
+	// Current program as far as the cache knows (queried if unknown)
+	// -------------------------------------------------------------------
+	GLuint getProgram()
+	{
+		if (currentProgram == UNKNOWN)
+		{
+			GLint program = 0;
+			glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+			currentProgram = (GLuint)program;
+		}
+		return currentProgram;
+	}
+
+	// Is direct state access available? (checked once per cache)
+	// -------------------------------------------------------------------
+	bool hasDirectStateAccess()
+	{
+		if (dsaChecked)
+			return dsa.available;
+		dsaChecked = true;
+		if (!(GLExtensions::version(4, 5) || GLExtensions::has("GL_ARB_direct_state_access")))
+			return false;
+		dsa.bindTextureUnit = (BindTextureUnitProc)GLExtensions::getProcAddress("glBindTextureUnit");
+		dsa.textureParameteri = (TextureParameteriProc)GLExtensions::getProcAddress("glTextureParameteri");
+		dsa.textureSubImage2D = (TextureSubImage2DProc)GLExtensions::getProcAddress("glTextureSubImage2D");
+		dsa.namedBufferData = (NamedBufferDataProc)GLExtensions::getProcAddress("glNamedBufferData");
+		dsa.namedBufferSubData = (NamedBufferSubDataProc)GLExtensions::getProcAddress("glNamedBufferSubData");
+		dsa.available = dsa.bindTextureUnit && dsa.textureParameteri && dsa.textureSubImage2D && dsa.namedBufferData && dsa.namedBufferSubData;
+		return dsa.available;
+	}
+
+	// Per-frame counters: call endFrame() once per frame (e.g. after swapping)
+	// -------------------------------------------------------------------
+	void endFrame()
+	{
+		lastFrame = frame;
+		frame = Counters();
+		frames++;
+	}
+
+	const Counters& getTotals() const { return totals; }
+	const Counters& getLastFrame() const { return lastFrame; }
+
+	// Issued vs. filtered calls, in total and per frame
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		static const char* names[CATEGORY_COUNT] = { "program", "vertex array", "buffer", "texture", "sampler", "raster" };
+		unsigned long long issued = totals.totalIssued();
+		unsigned long long filtered = totals.totalFiltered();
+		std::cout << "GL_STATE:: issued: " << issued << " filtered: " << filtered << " ("
+			<< (issued + filtered ? 100.0 * filtered / (issued + filtered) : 0.0) << "% redundant)";
+		if (frames > 0)
+			std::cout << ", per frame: " << (double)issued / frames << " issued, " << (double)filtered / frames << " filtered";
+		std::cout << (dsa.available ? ", direct state access" : "") << "\n";
+		for (int i = 0; i < CATEGORY_COUNT; i++)
+		{
+			if (totals.issued[i] + totals.filtered[i] == 0)
+				continue;
+			std::cout << "GL_STATE::   " << names[i] << ": " << totals.issued[i] << " issued, " << totals.filtered[i] << " filtered\n";
+		}
+		std::cout << std::flush;
+	}
+
+private:
+	typedef void (APIENTRYP BindTextureUnitProc)(GLuint unit, GLuint texture);
+	typedef void (APIENTRYP TextureParameteriProc)(GLuint texture, GLenum name, GLint value);
+	typedef void (APIENTRYP TextureSubImage2DProc)(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+	typedef void (APIENTRYP NamedBufferDataProc)(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+	typedef void (APIENTRYP NamedBufferSubDataProc)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+
+	static const int BUFFER_TARGETS = 9;
+	static const int TEXTURE_TARGETS = 4;
+
+	struct DirectStateAccess
+	{
+		bool available = false;
+		BindTextureUnitProc bindTextureUnit = NULL;
+		TextureParameteriProc textureParameteri = NULL;
+		TextureSubImage2DProc textureSubImage2D = NULL;
+		NamedBufferDataProc namedBufferData = NULL;
+		NamedBufferSubDataProc namedBufferSubData = NULL;
+	};
+
+	GLuint currentProgram = UNKNOWN;
+	GLuint currentVertexArray = UNKNOWN;
+	GLuint activeUnit = UNKNOWN;
+	GLuint buffers[BUFFER_TARGETS];
+	GLuint uniformBuffers[TRACKED_UNITS];
+	GLuint textures[TRACKED_UNITS][TEXTURE_TARGETS];
+	GLuint samplers[TRACKED_UNITS];
+	std::map<GLenum, bool> capabilities;
+	std::map<GLenum, GLuint> raster;
+	GLint currentViewport[4] = {};
+	float currentClearColor[4] = {};
+	bool viewportKnown = false;
+	bool clearColorKnown = false;
+	DirectStateAccess dsa;
+	bool dsaChecked = false;
+	bool contextAlive = true;
+	Counters totals;
+	Counters frame;
+	Counters lastFrame;
+	unsigned long long frames = 0;
+
+	GLState()
+	{
+		invalidate();
+	}
+
+	// Count a filtered call; returns true so it can end the "unchanged" check
+	bool skip(Category category)
+	{
+		totals.filtered[category]++;
+		frame.filtered[category]++;
+		return true;
+	}
+	void issue(Category category)
+	{
+		totals.issued[category]++;
+		frame.issued[category]++;
+	}
+
+	// Single-value raster state keyed by its GL query name
+	template <typename Apply>
+	void setRaster(GLenum name, GLuint value, Apply apply)
+	{
+		std::map<GLenum, GLuint>::iterator it = raster.find(name);
+		if (it != raster.end() && it->second == value && skip(RASTER))
+			return;
+		issue(RASTER);
+		raster[name] = value;
+		apply();
+	}
+
+	static int bufferIndex(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER: return 0;
+		case GL_ELEMENT_ARRAY_BUFFER: return 1;
+		case GL_UNIFORM_BUFFER: return 2;
+		case GL_PIXEL_UNPACK_BUFFER: return 3;
+		case GL_PIXEL_PACK_BUFFER: return 4;
+		case GL_COPY_READ_BUFFER: return 5;
+		case GL_COPY_WRITE_BUFFER: return 6;
+		case GL_TEXTURE_BUFFER: return 7;
+		case 0x8F3F /* GL_DRAW_INDIRECT_BUFFER */: return 8;
+		default: return -1;
+		}
+	}
+
+	static int textureIndex(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_TEXTURE_2D: return 0;
+		case GL_TEXTURE_2D_ARRAY: return 1;
+		case GL_TEXTURE_CUBE_MAP: return 2;
+		case GL_TEXTURE_3D: return 3;
+		default: return -1;
+		}
+	}
+
+	static void forget(GLuint* slots, int size, GLuint name)
+	{
+		for (int i = 0; i < size; i++)
+		{
+			if (slots[i] == name)
+				slots[i] = UNKNOWN;
+		}
+	}
+};
+#endif
@@ -0,0 +1,564 @@
+#ifndef IMAGE_RESAMPLE_H
+#define IMAGE_RESAMPLE_H
+
+#include "job_system.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_RESAMPLE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define IMAGE_RESAMPLE_AVX2
+#include <immintrin.h>
+#endif
+
+// Image Resampler Declaration
+// CPU resampling of 8-bit images (1-4 interleaved components, the layouts
+// stbi_load returns) to any size, and full mip chain generation from it.
+// The filter is separable: every source row is converted to float and
+// filtered horizontally, then output rows are weighted sums of those rows.
+// Both passes have SSE2 versions for every component count, and AVX2
+// versions for the vertical pass and 4-component horizontal pass (others
+// use SSE2 there); the set is picked at compile time (e.g. /arch:AVX2 or
+// -mavx2) with a scalar fallback. Large images are split into bands of
+// output rows that run on the JobSystem workers.
+// With srgb set, color components are converted to linear before filtering
+// and back afterwards (alpha stays linear), which keeps mips from darkening.
+
+class ImageResample
+{
+public:
+	enum Filter
+	{
+		BOX,    // exact area average, also for non-power-of-two sizes
+		KAISER  // Kaiser-windowed sinc, sharper mips at a higher cost
+	};
+
+	enum Instructions
+	{
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+	struct Options
+	{
+		Filter filter = BOX;
+		bool srgb = false;
+		unsigned int threads = 0; // 0: all JobSystem threads
+		Instructions instructions = best();
+	};
+
+	// One generated mip level
+	struct MipLevel
+	{
+		std::vector<unsigned char> pixels;
+		int width;
+		int height;
+	};
+
+	// Widest instruction set this build can use
+	// -------------------------------------------------------------------
+	static Instructions best()
+	{
+#if defined(IMAGE_RESAMPLE_AVX2)
+		return AVX2;
+#elif defined(IMAGE_RESAMPLE_SSE2)
+		return SSE2;
+#else
+		return SCALAR;
+#endif
+	}
+
+	static const char* name(Instructions instructions)
+	{
+		return instructions == AVX2 ? "AVX2" : instructions == SSE2 ? "SSE2" : "scalar";
+	}
+
+	// Resample 'source' (sourceWidth x sourceHeight) into 'target' (width x height).
+	// Rows are tightly packed.
+	// -------------------------------------------------------------------
+	static void resample(const unsigned char* source, int sourceWidth, int sourceHeight,
+		unsigned char* target, int width, int height, int components)
+	{
+		resample(source, sourceWidth, sourceHeight, target, width, height, components, Options());
+	}
+	// -------------------------------------------------------------------
+	static void resample(const unsigned char* source, int sourceWidth, int sourceHeight,
+		unsigned char* target, int width, int height, int components, const Options& options)
+	{
+		if (source == NULL || target == NULL || components < 1 || components > 4 || sourceWidth < 1 || sourceHeight < 1 || width < 1 || height < 1)
+			return;
+		Instructions instructions = options.instructions > best() ? best() : options.instructions;
+		Weights columns = makeWeights(sourceWidth, width, options.filter);
+		Weights rows = makeWeights(sourceHeight, height, options.filter);
+		const Tables& tables = getTables();
+
+		// bands of output rows; each band filters the source rows it needs itself
+		const int bandRows = 16;
+		int bands = (height + bandRows - 1) / bandRows;
+		unsigned int threads = options.threads;
+		if (threads != 1)
+		{
+			JobSystem& jobs = JobSystem::instance();
+			threads = threads != 0 ? std::min(threads, jobs.threadCount()) : jobs.threadCount();
+		}
+		// not worth a thread below ~64K output texels per thread
+		unsigned int useful = (unsigned int)std::max(1LL, (long long)width * height / (64 * 1024));
+		threads = std::max(1u, std::min(std::min(threads, useful), (unsigned int)bands));
+
+		// one range of bands per job, sharing its row buffers
+		auto work = [&](size_t firstBand, size_t endBand)
+		{
+			// +4 floats so 3-component pixels can be read and written 4 wide
+			size_t sourceFloats = (size_t)sourceWidth * components + 4;
+			size_t rowFloats = (size_t)width * components + 4;
+			std::vector<float> converted(sourceFloats);
+			std::vector<float> filtered;
+			std::vector<float> output(rowFloats);
+			for (int band = (int)firstBand; band < (int)endBand; band++)
+			{
+				int y0 = band * bandRows;
+				int y1 = std::min(height, y0 + bandRows);
+				int first = rows.start[y0];
+				int last = rows.start[y0];
+				for (int y = y0; y < y1; y++)
+				{
+					first = std::min(first, rows.start[y]);
+					last = std::max(last, rows.start[y] + rows.count[y]);
+				}
+				filtered.resize((size_t)(last - first) * rowFloats);
+				for (int sy = first; sy < last; sy++)
+				{
+					toFloat(source + (size_t)sy * sourceWidth * components, sourceWidth * components, components, options.srgb, tables, converted.data(), instructions);
+					horizontal(converted.data(), columns, width, components, &filtered[(size_t)(sy - first) * rowFloats], instructions);
+				}
+				for (int y = y0; y < y1; y++)
+				{
+					const float* weights = &rows.weights[(size_t)y * rows.taps];
+					const float* firstRow = &filtered[(size_t)(rows.start[y] - first) * rowFloats];
+					vertical(firstRow, rowFloats, weights, rows.count[y], width * components, output.data(), instructions);
+					toBytes(output.data(), width * components, components, options.srgb, tables, target + (size_t)y * width * components, instructions);
+				}
+			}
+		};
+
+		if (threads == 1)
+			work(0, (size_t)bands);
+		else
+			JobSystem::instance().parallelFor((size_t)bands, ((size_t)bands + threads * 2 - 1) / (threads * 2), work);
+	}
+
+	// Levels 1..n of the mip chain below 'pixels' (level 0 is not copied),
+	// each half the size of the previous one (rounded down, at least 1)
+	// -------------------------------------------------------------------
+	static std::vector<MipLevel> buildMipChain(const unsigned char* pixels, int width, int height, int components)
+	{
+		return buildMipChain(pixels, width, height, components, Options());
+	}
+	// -------------------------------------------------------------------
+	static std::vector<MipLevel> buildMipChain(const unsigned char* pixels, int width, int height, int components, const Options& options)
+	{
+		std::vector<MipLevel> chain;
+		const unsigned char* previous = pixels;
+		int previousWidth = width;
+		int previousHeight = height;
+		while (previousWidth > 1 || previousHeight > 1)
+		{
+			MipLevel level;
+			level.width = std::max(1, previousWidth / 2);
+			level.height = std::max(1, previousHeight / 2);
+			level.pixels.resize((size_t)level.width * level.height * components);
+			resample(previous, previousWidth, previousHeight, level.pixels.data(), level.width, level.height, components, options);
+			chain.push_back(std::move(level));
+			previous = chain.back().pixels.data();
+			previousWidth = chain.back().width;
+			previousHeight = chain.back().height;
+		}
+		return chain;
+	}
+
+private:
+	// Per output texel: first source texel, tap count and 'taps' weights
+	struct Weights
+	{
+		std::vector<int> start;
+		std::vector<int> count;
+		std::vector<float> weights;
+		int taps = 0;
+	};
+
+	// sRGB <-> linear conversion tables
+	struct Tables
+	{
+		float toLinear[256];
+		unsigned char toSrgb[4096];
+	};
+
+	// -------------------------------------------------------------------
+	static const Tables& getTables()
+	{
+		static const Tables tables = makeTables();
+		return tables;
+	}
+	// -------------------------------------------------------------------
+	static Tables makeTables()
+	{
+		Tables tables;
+		for (int i = 0; i < 256; i++)
+		{
+			float c = i / 255.0f;
+			tables.toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int i = 0; i < 4096; i++)
+		{
+			float l = i / 4095.0f;
+			float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+			tables.toSrgb[i] = (unsigned char)std::min(255.0f, c * 255.0f + 0.5f);
+		}
+		return tables;
+	}
+
+	// Filter weights for one axis, edges clamped into the first/last texel
+	// -------------------------------------------------------------------
+	static Weights makeWeights(int sourceSize, int size, Filter filter)
+	{
+		double scale = (double)sourceSize / size;
+		double filterScale = std::max(1.0, scale);
+		double radius = filter == BOX ? 0.5 * filterScale : KAISER_RADIUS * filterScale;
+
+		Weights result;
+		result.taps = std::min(sourceSize, (int)std::ceil(radius * 2.0) + 2);
+		result.start.resize(size);
+		result.count.resize(size);
+		result.weights.assign((size_t)size * result.taps, 0.0f);
+		std::vector<double> taps;
+		for (int x = 0; x < size; x++)
+		{
+			double center = (x + 0.5) * scale;
+			int lo = (int)std::floor(center - radius);
+			int hi = (int)std::ceil(center + radius);
+			int first = std::max(0, std::min(sourceSize - 1, lo));
+			int last = std::max(0, std::min(sourceSize - 1, hi));
+			taps.assign(last - first + 1, 0.0);
+			double total = 0.0;
+			for (int i = lo; i <= hi; i++)
+			{
+				double weight;
+				if (filter == BOX)
+				{
+					// overlap of texel [i, i + 1) with the footprint
+					weight = std::min(i + 1.0, center + radius) - std::max((double)i, center - radius);
+					if (weight <= 0.0)
+						continue;
+				}
+				else
+				{
+					weight = kaiser((i + 0.5 - center) / filterScale);
+				}
+				int clamped = std::max(first, std::min(last, i));
+				taps[clamped - first] += weight;
+				total += weight;
+			}
+			// trim zero taps at both ends
+			int begin = 0;
+			int end = (int)taps.size();
+			while (begin < end - 1 && taps[begin] == 0.0)
+				begin++;
+			while (end > begin + 1 && taps[end - 1] == 0.0)
+				end--;
+			if (end - begin > result.taps)
+				end = begin + result.taps;
+			result.start[x] = first + begin;
+			result.count[x] = end - begin;
+			for (int i = begin; i < end; i++)
+			{
+				result.weights[(size_t)x * result.taps + (i - begin)] = total != 0.0 ? (float)(taps[i] / total) : 0.0f;
+			}
+		}
+		return result;
+	}
+
+	static constexpr double KAISER_RADIUS = 3.0;
+	static constexpr double KAISER_ALPHA = 4.0;
+
+	// Windowed sinc, t in output texels
+	// -------------------------------------------------------------------
+	static double kaiser(double t)
+	{
+		if (std::fabs(t) >= KAISER_RADIUS)
+			return 0.0;
+		const double pi = 3.14159265358979323846;
+		double sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+		double x = t / KAISER_RADIUS;
+		return sinc * bessel0(KAISER_ALPHA * std::sqrt(1.0 - x * x)) / bessel0(KAISER_ALPHA);
+	}
+	// -------------------------------------------------------------------
+	static double bessel0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+			if (term < sum * 1e-12)
+				break;
+		}
+		return sum;
+	}
+
+	// Components that are color (alpha is the last of 2- and 4-component images)
+	static int colorComponents(int components)
+	{
+		return components == 4 || components == 2 ? components - 1 : components;
+	}
+
+	// 8-bit row -> float row (linear when srgb)
+	// -------------------------------------------------------------------
+	static void toFloat(const unsigned char* source, int count, int components, bool srgb, const Tables& tables, float* target, Instructions instructions)
+	{
+		if (srgb)
+		{
+			int colors = colorComponents(components);
+			for (int i = 0; i < count; i += components)
+			{
+				for (int c = 0; c < colors; c++)
+				{
+					target[i + c] = tables.toLinear[source[i + c]];
+				}
+				if (colors < components)
+					target[i + colors] = source[i + colors] * (1.0f / 255.0f);
+			}
+			return;
+		}
+		int i = 0;
+#ifdef IMAGE_RESAMPLE_AVX2
+		if (instructions == AVX2)
+		{
+			const __m256 factor = _mm256_set1_ps(1.0f / 255.0f);
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256i wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i)));
+				_mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_cvtepi32_ps(wide), factor));
+			}
+		}
+#endif
+#ifdef IMAGE_RESAMPLE_SSE2
+		if (instructions >= SSE2)
+		{
+			const __m128 factor = _mm_set1_ps(1.0f / 255.0f);
+			const __m128i zero = _mm_setzero_si128();
+			for (; i + 16 <= count; i += 16)
+			{
+				__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+				__m128i low = _mm_unpacklo_epi8(bytes, zero);
+				__m128i high = _mm_unpackhi_epi8(bytes, zero);
+				_mm_storeu_ps(target + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), factor));
+				_mm_storeu_ps(target + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), factor));
+				_mm_storeu_ps(target + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), factor));
+				_mm_storeu_ps(target + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), factor));
+			}
+		}
+#endif
+		for (; i < count; i++)
+		{
+			target[i] = source[i] * (1.0f / 255.0f);
+		}
+	}
+
+	// Horizontal pass: one float row -> 'width' filtered texels
+	// -------------------------------------------------------------------
+	static void horizontal(const float* source, const Weights& columns, int width, int components, float* target, Instructions instructions)
+	{
+#ifdef IMAGE_RESAMPLE_AVX2
+		// 4 components: two taps (texels k and k + 1) per register, the
+		// halves added once per texel
+		if (instructions == AVX2 && components == 4)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				const float* weights = &columns.weights[(size_t)x * columns.taps];
+				const float* texel = source + (size_t)columns.start[x] * 4;
+				int count = columns.count[x];
+				__m256 sum = _mm256_setzero_ps();
+				int k = 0;
+				for (; k + 2 <= count; k += 2)
+				{
+					__m256 weight = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weights[k])), _mm_set1_ps(weights[k + 1]), 1);
+					sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(texel + k * 4), weight));
+				}
+				__m128 total = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+				if (k < count)
+					total = _mm_add_ps(total, _mm_mul_ps(_mm_loadu_ps(texel + k * 4), _mm_set1_ps(weights[k])));
+				_mm_storeu_ps(target + (size_t)x * 4, total);
+			}
+			return;
+		}
+#endif
+#ifdef IMAGE_RESAMPLE_SSE2
+		// 1 and 2 components: four taps (or two 2-component texels) per
+		// register, reduced per texel, the last taps scalar
+		if (instructions >= SSE2 && components <= 2)
+		{
+			int perRegister = 4 / components;
+			for (int x = 0; x < width; x++)
+			{
+				const float* weights = &columns.weights[(size_t)x * columns.taps];
+				const float* texel = source + (size_t)columns.start[x] * components;
+				int count = columns.count[x];
+				__m128 sum = _mm_setzero_ps();
+				int k = 0;
+				for (; k + perRegister <= count; k += perRegister)
+				{
+					__m128 weight = components == 1 ? _mm_loadu_ps(weights + k) : _mm_set_ps(weights[k + 1], weights[k + 1], weights[k], weights[k]);
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(texel + k * components), weight));
+				}
+				float lanes[4];
+				_mm_storeu_ps(lanes, sum);
+				float result[2] = { lanes[0] + lanes[2], lanes[1] + lanes[3] };
+				if (components == 1)
+					result[0] += result[1];
+				for (; k < count; k++)
+				{
+					for (int c = 0; c < components; c++)
+					{
+						result[c] += texel[k * components + c] * weights[k];
+					}
+				}
+				for (int c = 0; c < components; c++)
+				{
+					target[(size_t)x * components + c] = result[c];
+				}
+			}
+			return;
+		}
+		// 3 and 4 components: one texel per register; 3-component
+		// texels read and write one float past their end, which the row
+		// padding and the next texel absorb
+		if (instructions >= SSE2 && components >= 3)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				const float* weights = &columns.weights[(size_t)x * columns.taps];
+				const float* texel = source + (size_t)columns.start[x] * components;
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < columns.count[x]; k++)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(texel + k * components), _mm_set1_ps(weights[k])));
+				}
+				_mm_storeu_ps(target + (size_t)x * components, sum);
+			}
+			return;
+		}
+#endif
+		for (int x = 0; x < width; x++)
+		{
+			const float* weights = &columns.weights[(size_t)x * columns.taps];
+			const float* texel = source + (size_t)columns.start[x] * components;
+			for (int c = 0; c < components; c++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < columns.count[x]; k++)
+				{
+					sum += texel[k * components + c] * weights[k];
+				}
+				target[(size_t)x * components + c] = sum;
+			}
+		}
+	}
+
+	// Vertical pass: weighted sum of 'taps' consecutive filtered rows
+	// -------------------------------------------------------------------
+	static void vertical(const float* rows, size_t stride, const float* weights, int taps, int count, float* target, Instructions instructions)
+	{
+		int i = 0;
+#ifdef IMAGE_RESAMPLE_AVX2
+		if (instructions == AVX2)
+		{
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 sum = _mm256_setzero_ps();
+				for (int k = 0; k < taps; k++)
+				{
+					sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows + k * stride + i), _mm256_set1_ps(weights[k])));
+				}
+				_mm256_storeu_ps(target + i, sum);
+			}
+		}
+#endif
+#ifdef IMAGE_RESAMPLE_SSE2
+		if (instructions >= SSE2)
+		{
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < taps; k++)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows + k * stride + i), _mm_set1_ps(weights[k])));
+				}
+				_mm_storeu_ps(target + i, sum);
+			}
+		}
+#endif
+		for (; i < count; i++)
+		{
+			float sum = 0.0f;
+			for (int k = 0; k < taps; k++)
+			{
+				sum += rows[k * stride + i] * weights[k];
+			}
+			target[i] = sum;
+		}
+	}
+
+	// Float row -> 8-bit row, rounded and clamped (back to sRGB when srgb)
+	// -------------------------------------------------------------------
+	static void toBytes(const float* source, int count, int components, bool srgb, const Tables& tables, unsigned char* target, Instructions instructions)
+	{
+		if (srgb)
+		{
+			int colors = colorComponents(components);
+			for (int i = 0; i < count; i += components)
+			{
+				for (int c = 0; c < colors; c++)
+				{
+					float value = std::min(1.0f, std::max(0.0f, source[i + c]));
+					target[i + c] = tables.toSrgb[(int)(value * 4095.0f + 0.5f)];
+				}
+				if (colors < components)
+				{
+					float value = std::min(1.0f, std::max(0.0f, source[i + colors]));
+					target[i + colors] = (unsigned char)(value * 255.0f + 0.5f);
+				}
+			}
+			return;
+		}
+		int i = 0;
+#ifdef IMAGE_RESAMPLE_SSE2
+		if (instructions >= SSE2)
+		{
+			// cvtps rounds to nearest, the packs saturate to 0..255
+			const __m128 factor = _mm_set1_ps(255.0f);
+			for (; i + 16 <= count; i += 16)
+			{
+				__m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(source + i), factor));
+				__m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(source + i + 4), factor));
+				__m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(source + i + 8), factor));
+				__m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(source + i + 12), factor));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+			}
+		}
+#endif
+		for (; i < count; i++)
+		{
+			float value = std::nearbyint(source[i] * 255.0f);
+			target[i] = (unsigned char)std::min(255.0f, std::max(0.0f, value));
+		}
+	}
+};
+#endif
@@ -0,0 +1,291 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <GLFW/glfw3.h>
+#include "app_window.h"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+// Input Queue Declaration
+// Key events arrive through the GLFW key callback instead of being polled
+// with glfwGetKey every frame. Each event is stamped with the steady clock
+// when GLFW delivers it (inside glfwPollEvents, i.e. AppWindow::swapBuffers)
+// and pushed into a lock-free single producer / single consumer queue, so
+// the producer may later move to its own thread. Once per frame the render
+// loop drains the queue: every event is looked up in a key -> action
+// binding table and the handler gets the program's action ids, never keys.
+// markPresented() after the swap closes the frame: the time from each
+// handled event to that point is its input-to-present latency, kept for
+// the last HISTORY events and printed as percentiles.
+// Headless windows have no keyboard; push() injects events there (or
+// replays recorded ones).
+
+// Fixed size lock-free ring for one producer and one consumer thread
+template <typename T, size_t CAPACITY>
+class SpscQueue
+{
+public:
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	// Producer side; false when full
+	bool push(const T& item)
+	{
+		size_t tail = tailIndex.load(std::memory_order_relaxed);
+		if (tail - headIndex.load(std::memory_order_acquire) == CAPACITY)
+			return false;
+		items[tail & (CAPACITY - 1)] = item;
+		tailIndex.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side; false when empty
+	bool pop(T& item)
+	{
+		size_t head = headIndex.load(std::memory_order_relaxed);
+		if (head == tailIndex.load(std::memory_order_acquire))
+			return false;
+		item = items[head & (CAPACITY - 1)];
+		headIndex.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t size() const
+	{
+		return tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire);
+	}
+
+private:
+	// separate cache lines so the two threads do not share one
+	alignas(64) std::atomic<size_t> headIndex{ 0 };
+	alignas(64) std::atomic<size_t> tailIndex{ 0 };
+	T items[CAPACITY];
+};
+
+class InputQueue
+{
+public:
+	static const size_t CAPACITY = 256;
+	static const int HISTORY = 1024; // latency samples kept
+
+	// When a binding fires
+	enum Trigger
+	{
+		PRESS,    // key went down (not on key repeat)
+		RELEASE,  // key went up
+		REPEAT,   // key went down or the OS repeated it
+		HELD      // every frame while the key is down (no latency sample)
+	};
+
+	struct Event
+	{
+		int key = 0;
+		int action = GLFW_RELEASE; // GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+		int mods = 0;
+		long long time = 0;        // nanoseconds, steady clock
+	};
+
+	struct Binding
+	{
+		int key;
+		int action; // the program's action id
+		Trigger trigger;
+	};
+
+	struct Stats
+	{
+		unsigned long long events = 0;
+		unsigned long long actions = 0;
+		unsigned long long dropped = 0; // queue was full
+		unsigned long long frames = 0;
+	};
+
+	InputQueue()
+	{
+		std::fill(down, down + GLFW_KEY_LAST + 1, false);
+	}
+
+	InputQueue(const InputQueue&) = delete;
+	InputQueue& operator=(const InputQueue&) = delete;
+
+	// Receive the window's key events (nothing to attach to when headless).
+	// The queue must outlive the window's event polling, or detach() first.
+	// -------------------------------------------------------------------
+	void attach(AppWindow& window)
+	{
+		attached = window.getWindow();
+		if (attached == NULL)
+			return;
+		glfwSetWindowUserPointer(attached, this);
+		glfwSetKeyCallback(attached, keyCallback);
+	}
+
+	void detach()
+	{
+		if (attached != NULL)
+			glfwSetKeyCallback(attached, NULL);
+		attached = NULL;
+	}
+
+	// -------------------------------------------------------------------
+	void bind(int key, int action, Trigger trigger = PRESS)
+	{
+		bindings.push_back({ key, action, trigger });
+	}
+
+	template <size_t N>
+	void bind(const Binding (&table)[N])
+	{
+		for (size_t i = 0; i < N; i++)
+		{
+			bindings.push_back(table[i]);
+		}
+	}
+
+	// Producer: queue one event, stamped now
+	// -------------------------------------------------------------------
+	bool push(int key, int action, int mods = 0)
+	{
+		Event event;
+		event.key = key;
+		event.action = action;
+		event.mods = mods;
+		event.time = now();
+		if (!queue.push(event))
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		return true;
+	}
+
+	// Consumer, once per frame: handle every queued event, then the HELD
+	// bindings. handler(int action, const Event& event). Returns the number
+	// of actions handled.
+	// -------------------------------------------------------------------
+	template <typename Handler>
+	int drain(Handler handler)
+	{
+		int handled = 0;
+		Event event;
+		while (queue.pop(event))
+		{
+			stats.events++;
+			if (event.key >= 0 && event.key <= GLFW_KEY_LAST)
+				down[event.key] = event.action != GLFW_RELEASE;
+			for (size_t b = 0; b < bindings.size(); b++)
+			{
+				const Binding& binding = bindings[b];
+				if (binding.key != event.key || !fires(binding.trigger, event.action))
+					continue;
+				handler(binding.action, event);
+				handled++;
+				pendingTimes.push_back(event.time);
+			}
+		}
+		Event held;
+		held.time = now();
+		for (size_t b = 0; b < bindings.size(); b++)
+		{
+			const Binding& binding = bindings[b];
+			if (binding.trigger == HELD && isDown(binding.key))
+			{
+				held.key = binding.key;
+				held.action = GLFW_PRESS;
+				handler(binding.action, held);
+				handled++;
+			}
+		}
+		stats.actions += handled;
+		return handled;
+	}
+
+	bool isDown(int key) const
+	{
+		return key >= 0 && key <= GLFW_KEY_LAST && down[key];
+	}
+
+	// After the swap: the frame that reacted to this frame's events is now
+	// presented
+	// -------------------------------------------------------------------
+	void markPresented()
+	{
+		long long presented = now();
+		for (size_t i = 0; i < pendingTimes.size(); i++)
+		{
+			float ms = (float)((presented - pendingTimes[i]) * 1e-6);
+			if (latencies.size() < (size_t)HISTORY)
+				latencies.push_back(ms);
+			else
+				latencies[nextLatency] = ms;
+			nextLatency = (nextLatency + 1) % HISTORY;
+		}
+		pendingTimes.clear();
+		stats.frames++;
+	}
+
+	Stats getStats() const
+	{
+		Stats result = stats;
+		result.dropped = dropped.load(std::memory_order_relaxed);
+		return result;
+	}
+
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		Stats current = getStats();
+		std::cout << "INPUT_QUEUE:: frames: " << current.frames << ", events: " << current.events << ", actions: " << current.actions
+			<< ", dropped: " << current.dropped << std::endl;
+		if (latencies.empty())
+			return;
+		std::vector<float> sorted = latencies;
+		std::sort(sorted.begin(), sorted.end());
+		size_t last = sorted.size() - 1;
+		std::cout << "INPUT_QUEUE:: input to present (" << sorted.size() << " events): p50 " << sorted[last / 2] << " ms, p95 "
+			<< sorted[last * 95 / 100] << " ms, p99 " << sorted[last * 99 / 100] << " ms, max " << sorted[last] << " ms" << std::endl;
+	}
+
+private:
+	SpscQueue<Event, CAPACITY> queue;
+	std::vector<Binding> bindings;
+	bool down[GLFW_KEY_LAST + 1];
+	std::vector<long long> pendingTimes;
+	std::vector<float> latencies;
+	size_t nextLatency = 0;
+	std::atomic<unsigned long long> dropped{ 0 };
+	Stats stats;
+	GLFWwindow* attached = NULL;
+
+	static long long now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static bool fires(Trigger trigger, int action)
+	{
+		switch (trigger)
+		{
+		case PRESS:
+			return action == GLFW_PRESS;
+		case RELEASE:
+			return action == GLFW_RELEASE;
+		case REPEAT:
+			return action == GLFW_PRESS || action == GLFW_REPEAT;
+		default:
+			return false;
+		}
+	}
+
+	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+	{
+		InputQueue* input = static_cast<InputQueue*>(glfwGetWindowUserPointer(window));
+		(void)scancode;
+		if (input != NULL)
+			input->push(key, action, mods);
+	}
+};
+#endif
@@ -0,0 +1,129 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+#include "gl_state.h"
+
+#include <cstddef>
+
+// Instance Buffer Declaration
+// Per-instance data for glDraw*Instanced: a vertex buffer whose attributes
+// advance once per instance (glVertexAttribDivisor 1) instead of per vertex.
+//   MATRIX  a full model matrix per instance, 64 bytes, read as a mat4 from
+//           four consecutive attribute locations
+//   PACKED  position + uniform scale and axis + angle, 32 bytes, turned into
+//           a matrix in the shader with instanceMatrix() from instancing.glsl
+// upload() replaces the contents every frame; the storage is orphaned first
+// so the driver never waits for draws that still read last frame's data.
+
+class InstanceBuffer
+{
+public:
+	enum Layout
+	{
+		MATRIX,
+		PACKED
+	};
+
+	// Column-major, as glm::mat4 / glm::value_ptr lays it out
+	struct Matrix
+	{
+		float m[16];
+	};
+
+	struct Packed
+	{
+		float position[3];
+		float scale;
+		float axis[3];  // unit length
+		float angle;    // radians
+	};
+
+	InstanceBuffer(Layout layout = MATRIX)
+		: layout(layout)
+	{
+	}
+
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+	// Add the instance attributes to 'vertexArray' at firstLocation (4
+	// locations for MATRIX, 2 for PACKED). Leaves the vertex array bound.
+	// -------------------------------------------------------------------
+	void attach(GLuint vertexArray, GLuint firstLocation)
+	{
+		create();
+		point(layout, vertexArray, firstLocation, buffer, 0);
+	}
+
+	// Point the instance attributes of 'vertexArray' at instances stored
+	// somewhere else, e.g. an UploadRing allocation (re-point every frame,
+	// as the offset moves)
+	// -------------------------------------------------------------------
+	static void point(Layout layout, GLuint vertexArray, GLuint firstLocation, GLuint source, size_t offset)
+	{
+		GLState& state = GLState::instance();
+		state.bindVertexArray(vertexArray);
+		state.bindBuffer(GL_ARRAY_BUFFER, source);
+		GLsizei size = (GLsizei)(layout == MATRIX ? sizeof(Matrix) : sizeof(Packed));
+		GLuint locations = layout == MATRIX ? 4 : 2;
+		for (GLuint i = 0; i < locations; i++)
+		{
+			glVertexAttribPointer(firstLocation + i, 4, GL_FLOAT, GL_FALSE, size, (void*)(offset + i * 4 * sizeof(float)));
+			glEnableVertexAttribArray(firstLocation + i);
+			glVertexAttribDivisor(firstLocation + i, 1);
+		}
+	}
+
+	// Replace the contents with 'count' instances (Matrix or Packed)
+	// -------------------------------------------------------------------
+	void upload(const void* instances, size_t count)
+	{
+		GLState& state = GLState::instance();
+		create();
+		size_t bytes = count * stride();
+		if (bytes > capacity)
+		{
+			// grow by half again so a slowly rising count does not realloc every frame
+			capacity = bytes + bytes / 2;
+		}
+		// orphan, then fill: the old storage stays with draws in flight
+		state.bufferData(buffer, GL_ARRAY_BUFFER, (GLsizeiptr)capacity, NULL, GL_STREAM_DRAW);
+		if (bytes > 0)
+			state.bufferSubData(buffer, GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytes, instances);
+		instanceCount = count;
+	}
+
+	// Delete the buffer. Call while the context is still current.
+	// -------------------------------------------------------------------
+	void release()
+	{
+		if (buffer)
+			GLState::instance().deleteBuffer(buffer);
+		buffer = 0;
+		capacity = 0;
+		instanceCount = 0;
+	}
+
+	size_t stride() const { return layout == MATRIX ? sizeof(Matrix) : sizeof(Packed); }
+	GLuint locationCount() const { return layout == MATRIX ? 4 : 2; }
+	Layout getLayout() const { return layout; }
+	GLuint getBuffer() const { return buffer; }
+	size_t getInstanceCount() const { return instanceCount; }
+
+private:
+	Layout layout;
+	GLuint buffer = 0;
+	size_t capacity = 0;
+	size_t instanceCount = 0;
+
+	// A name only becomes a buffer once bound (DSA calls need the object)
+	void create()
+	{
+		if (buffer != 0)
+			return;
+		glGenBuffers(1, &buffer);
+		GLState::instance().bindBuffer(GL_ARRAY_BUFFER, buffer);
+	}
+};
+#endif
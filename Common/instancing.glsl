@@ -0,0 +1,18 @@
+// Per-instance transform helpers, shared by shaders that draw with
+// InstanceBuffer (Common/instance_buffer.h). Include after #version.
+
+// Model matrix from a PACKED instance: position and uniform scale in
+// positionScale, a unit rotation axis and an angle (radians) in axisAngle
+mat4 instanceMatrix(vec4 positionScale, vec4 axisAngle)
+{
+	vec3 axis = axisAngle.xyz;
+	float s = sin(axisAngle.w);
+	float c = cos(axisAngle.w);
+	float t = 1.0f - c;
+	mat3 rotation = mat3(
+		t * axis.x * axis.x + c,          t * axis.x * axis.y + s * axis.z, t * axis.x * axis.z - s * axis.y,
+		t * axis.x * axis.y - s * axis.z, t * axis.y * axis.y + c,          t * axis.y * axis.z + s * axis.x,
+		t * axis.x * axis.z + s * axis.y, t * axis.y * axis.z - s * axis.x, t * axis.z * axis.z + c);
+	rotation *= positionScale.w;
+	return mat4(vec4(rotation[0], 0.0f), vec4(rotation[1], 0.0f), vec4(rotation[2], 0.0f), vec4(positionScale.xyz, 1.0f));
+}
@@ -0,0 +1,470 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <condition_variable>
+
+// Job System Declaration
+// A fixed set of worker threads, started once, that run small jobs so
+// per-frame CPU work (transforms, culling, sorting, decoding) can go wide
+// without creating threads every frame. Every worker and the thread that
+// created the system own a work-stealing deque (Chase-Lev): they push and
+// pop jobs at the bottom, idle threads steal from the top of the others.
+// Jobs submitted from any other thread go through a locked queue.
+//   submit()       one job, optionally started only after other jobs finished
+//   wait()         until a job is done; the waiting thread runs jobs meanwhile
+//   parallelFor()  split [0, count) into ranges and wait for all of them
+//   endFrame()     wait for every job submitted so far (frame-scoped wait)
+// Handles stay valid as long as they are held. printStats() reports per
+// thread jobs run, steals and utilization (time in jobs / time since reset).
+
+class JobSystem
+{
+	struct Job;
+
+public:
+	typedef std::shared_ptr<Job> Handle;
+
+	struct Settings
+	{
+		unsigned int workers = 0; // 0: one less than the hardware threads
+	};
+
+	// Shared system, created on first use by the rendering thread
+	// -------------------------------------------------------------------
+	static JobSystem& instance()
+	{
+		static JobSystem system;
+		return system;
+	}
+
+	JobSystem()
+		: JobSystem(Settings())
+	{
+	}
+
+	explicit JobSystem(const Settings& settings)
+	{
+		unsigned int count = settings.workers;
+		if (count == 0)
+		{
+			unsigned int hardware = std::thread::hardware_concurrency();
+			count = hardware > 1 ? hardware - 1 : 1;
+		}
+		// slot 0 belongs to the creating thread, 1..count to the workers
+		slots.reserve(count + 1);
+		for (unsigned int i = 0; i <= count; i++)
+		{
+			slots.push_back(std::unique_ptr<Slot>(new Slot()));
+		}
+		current() = Identity{ this, 0 };
+		statsStart = std::chrono::steady_clock::now();
+		for (unsigned int i = 1; i <= count; i++)
+		{
+			threads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+		}
+	}
+
+	~JobSystem()
+	{
+		endFrame();
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < threads.size(); i++)
+		{
+			threads[i].join();
+		}
+		if (current().system == this)
+			current() = Identity{ NULL, -1 };
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Queue 'work'; with 'after' it starts once those jobs have finished
+	// -------------------------------------------------------------------
+	Handle submit(std::function<void()> work)
+	{
+		return submit(std::move(work), {});
+	}
+	// -------------------------------------------------------------------
+	Handle submit(std::function<void()> work, std::initializer_list<Handle> after)
+	{
+		Handle job = std::make_shared<Job>();
+		job->work = std::move(work);
+		job->self = job;
+		outstanding++;
+		// one extra dependency while the list is walked, so nothing finishing
+		// meanwhile can start the job early
+		job->dependencies = 1;
+		for (const Handle& dependency : after)
+		{
+			if (!dependency)
+				continue;
+			std::lock_guard<std::mutex> lock(dependency->mutex);
+			if (dependency->done)
+				continue;
+			job->dependencies++;
+			dependency->continuations.push_back(job);
+		}
+		if (--job->dependencies == 0)
+			schedule(job.get());
+		return job;
+	}
+
+	// Block until 'job' has run, running other jobs meanwhile
+	// -------------------------------------------------------------------
+	void wait(const Handle& job)
+	{
+		if (!job)
+			return;
+		int spins = 0;
+		while (!job->finished.load(std::memory_order_acquire))
+		{
+			if (!runOne())
+				idle(spins);
+		}
+	}
+
+	static bool isDone(const Handle& job)
+	{
+		return !job || job->finished.load(std::memory_order_acquire);
+	}
+
+	// Call fn(begin, end) for ranges of about 'grain' items covering
+	// [0, count), on the workers and the calling thread. Returns when all
+	// ranges are done.
+	// -------------------------------------------------------------------
+	template <typename Function>
+	void parallelFor(size_t count, size_t grain, const Function& fn)
+	{
+		if (count == 0)
+			return;
+		grain = std::max((size_t)1, grain);
+		size_t ranges = (count + grain - 1) / grain;
+		if (ranges == 1 || slots.size() == 1)
+		{
+			fn((size_t)0, count);
+			return;
+		}
+		std::atomic<size_t> remaining(ranges - 1);
+		for (size_t r = 1; r < ranges; r++)
+		{
+			size_t begin = r * grain;
+			size_t end = std::min(count, begin + grain);
+			submit([&fn, &remaining, begin, end]()
+			{
+				fn(begin, end);
+				remaining--;
+			});
+		}
+		// the first range on this thread, then help with the rest
+		fn((size_t)0, std::min(count, grain));
+		int spins = 0;
+		while (remaining.load(std::memory_order_acquire) > 0)
+		{
+			if (!runOne())
+				idle(spins);
+		}
+	}
+
+	// Wait for every job submitted so far (call once per frame, before the
+	// frame's results are used)
+	// -------------------------------------------------------------------
+	void endFrame()
+	{
+		int spins = 0;
+		while (outstanding.load(std::memory_order_acquire) > 0)
+		{
+			if (!runOne())
+				idle(spins);
+		}
+		frames++;
+	}
+
+	// Threads that run jobs, including the one that created the system
+	unsigned int threadCount() const { return (unsigned int)slots.size(); }
+
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - statsStart).count();
+		std::cout << "JOB_SYSTEM:: " << slots.size() - 1 << " workers, " << frames << " frames, " << elapsed << " ms" << std::endl;
+		for (size_t i = 0; i < slots.size(); i++)
+		{
+			const Slot& slot = *slots[i];
+			double busy = slot.busy.load(std::memory_order_relaxed) * 1e-6;
+			std::cout << "JOB_SYSTEM::   " << (i == 0 ? std::string("main") : "worker " + std::to_string(i)) << ": jobs " << slot.jobs.load(std::memory_order_relaxed)
+				<< ", steals " << slot.steals.load(std::memory_order_relaxed) << ", busy " << busy << " ms ("
+				<< (elapsed > 0.0 ? busy / elapsed * 100.0 : 0.0) << "%)" << std::endl;
+		}
+	}
+	// -------------------------------------------------------------------
+	void resetStats()
+	{
+		for (size_t i = 0; i < slots.size(); i++)
+		{
+			slots[i]->jobs = 0;
+			slots[i]->steals = 0;
+			slots[i]->busy = 0;
+		}
+		frames = 0;
+		statsStart = std::chrono::steady_clock::now();
+	}
+
+private:
+	struct Job
+	{
+		std::function<void()> work;
+		std::atomic<int> dependencies{ 0 };
+		std::atomic<bool> finished{ false };
+		std::mutex mutex; // guards done and continuations
+		bool done = false;
+		std::vector<Handle> continuations;
+		Handle self;      // keeps a queued job alive until it has run
+	};
+
+	// Chase-Lev deque of a fixed size: the owner pushes and pops at the
+	// bottom, any thread steals from the top
+	class Deque
+	{
+	public:
+		static const int64_t CAPACITY = 4096;
+
+		// Owner only. False when full.
+		bool push(Job* job)
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= CAPACITY)
+				return false;
+			buffer[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// Owner only
+		Job* pop()
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+			if (t > b)
+			{
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return NULL;
+			}
+			Job* job = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+			if (t == b)
+			{
+				// last one: race the thieves for it
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					job = NULL;
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+		// Any thread
+		Job* steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+				return NULL;
+			Job* job = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return NULL;
+			return job;
+		}
+
+	private:
+		alignas(64) std::atomic<int64_t> top{ 0 };
+		alignas(64) std::atomic<int64_t> bottom{ 0 };
+		std::atomic<Job*> buffer[CAPACITY] = {};
+	};
+
+	struct alignas(64) Slot
+	{
+		Deque deque;
+		std::atomic<unsigned long long> jobs{ 0 };
+		std::atomic<unsigned long long> steals{ 0 };
+		std::atomic<unsigned long long> busy{ 0 }; // nanoseconds in jobs
+	};
+
+	// Which system and slot the calling thread is (-1: not one of ours)
+	struct Identity
+	{
+		const JobSystem* system;
+		int slot;
+	};
+
+	std::vector<std::unique_ptr<Slot>> slots;
+	std::vector<std::thread> threads;
+	std::mutex queueMutex;
+	std::deque<Job*> injected;            // jobs from threads without a slot
+	std::atomic<long long> queued{ 0 };   // jobs waiting to start
+	std::atomic<long long> outstanding{ 0 }; // jobs submitted and not finished
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<int> sleeping{ 0 };
+	bool stopping = false;
+	unsigned long long frames = 0;
+	std::chrono::steady_clock::time_point statsStart;
+
+	static Identity& current()
+	{
+		static thread_local Identity identity = { NULL, -1 };
+		return identity;
+	}
+
+	int slotOfThisThread() const
+	{
+		return current().system == this ? current().slot : -1;
+	}
+
+	// A job whose dependencies are done: onto this thread's deque, or the
+	// shared queue for other threads (and when the deque is full)
+	// -------------------------------------------------------------------
+	void schedule(Job* job)
+	{
+		queued++;
+		int slot = slotOfThisThread();
+		if (slot < 0 || !slots[slot]->deque.push(job))
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			injected.push_back(job);
+		}
+		if (sleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wake.notify_one();
+		}
+	}
+
+	// Run one job if there is any: own deque, then the others, then the shared queue
+	// -------------------------------------------------------------------
+	bool runOne()
+	{
+		int slot = slotOfThisThread();
+		Job* job = NULL;
+		bool stolen = false;
+		if (slot >= 0)
+			job = slots[slot]->deque.pop();
+		if (job == NULL)
+		{
+			size_t count = slots.size();
+			size_t start = slot >= 0 ? (size_t)slot + 1 : 0;
+			for (size_t i = 0; i < count && job == NULL; i++)
+			{
+				size_t victim = (start + i) % count;
+				if ((int)victim != slot)
+					job = slots[victim]->deque.steal();
+			}
+			stolen = job != NULL;
+		}
+		if (job == NULL && queued.load(std::memory_order_relaxed) > 0)
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (!injected.empty())
+			{
+				job = injected.front();
+				injected.pop_front();
+			}
+		}
+		if (job == NULL)
+			return false;
+		queued--;
+		execute(job, slot, stolen);
+		return true;
+	}
+
+	// -------------------------------------------------------------------
+	void execute(Job* job, int slot, bool stolen)
+	{
+		auto start = std::chrono::steady_clock::now();
+		job->work();
+		if (slot >= 0)
+		{
+			Slot& stats = *slots[slot];
+			stats.busy.fetch_add((unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+			stats.jobs.fetch_add(1, std::memory_order_relaxed);
+			if (stolen)
+				stats.steals.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		std::vector<Handle> continuations;
+		{
+			std::lock_guard<std::mutex> lock(job->mutex);
+			job->done = true;
+			continuations.swap(job->continuations);
+		}
+		for (size_t i = 0; i < continuations.size(); i++)
+		{
+			if (--continuations[i]->dependencies == 0)
+				schedule(continuations[i].get());
+		}
+		job->work = nullptr;
+		job->finished.store(true, std::memory_order_release);
+		// last use of the job here: a waiter may drop its handle right after
+		Handle self;
+		self.swap(job->self);
+		outstanding--;
+	}
+
+	// Nothing to run: spin a little, then yield
+	// -------------------------------------------------------------------
+	static void idle(int& spins)
+	{
+		if (++spins > 64)
+		{
+			std::this_thread::yield();
+			spins = 0;
+		}
+	}
+
+	// -------------------------------------------------------------------
+	void workerLoop(unsigned int slot)
+	{
+		current() = Identity{ this, (int)slot };
+		int spins = 0;
+		for (;;)
+		{
+			if (runOne())
+			{
+				spins = 0;
+				continue;
+			}
+			if (++spins < 256)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			spins = 0;
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleeping++;
+			wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+			sleeping--;
+			if (stopping && queued.load() == 0)
+				return;
+		}
+	}
+};
+#endif
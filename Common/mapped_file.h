@@ -0,0 +1,89 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Read-only file mapping
+class MappedFile
+{
+public:
+	MappedFile(const std::string& path)
+	{
+#ifdef _WIN32
+		// sharing flags let editors that save by replacing the file keep working
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+		LARGE_INTEGER fileSize;
+		open = GetFileSizeEx(file, &fileSize) != 0;
+		length = open ? (size_t)fileSize.QuadPart : 0;
+		if (length > 0)
+		{
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping != NULL)
+			{
+				view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+			open = view != NULL;
+		}
+		CloseHandle(file);
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return;
+		struct stat info;
+		open = fstat(fd, &info) == 0;
+		length = open ? (size_t)info.st_size : 0;
+		if (length > 0)
+		{
+			view = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view == MAP_FAILED)
+				view = NULL;
+			open = view != NULL;
+		}
+		::close(fd);
+#endif
+		if (!open)
+			length = 0;
+	}
+
+	~MappedFile()
+	{
+		if (view == NULL)
+			return;
+#ifdef _WIN32
+		UnmapViewOfFile(view);
+#else
+		munmap(view, length);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data() const { return static_cast<const char*>(view); }
+	size_t size() const { return length; }
+	bool isOpen() const { return open; }
+
+private:
+	void* view = NULL;
+	size_t length = 0;
+	bool open = false;
+};
+#endif
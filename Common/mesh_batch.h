@@ -0,0 +1,336 @@
+#ifndef MESH_BATCH_H
+#define MESH_BATCH_H
+
+#include <glad/glad.h>
+#include "gl_extensions.h"
+#include "gl_state.h"
+#include "instance_buffer.h"
+#include "mesh_optimizer.h"
+#include "upload_ring.h"
+
+#include <vector>
+#include <cstring>
+#include <iostream>
+
+// Mesh Batch Declaration
+// Many different meshes drawn from one vertex buffer, one index buffer and
+// one vertex array, so a whole pass needs no buffer or vertex array changes
+// between objects. Meshes are added once (same vertex layout for all) and
+// uploaded; then every frame draw() records a mesh + model matrix and
+// submit() issues them:
+//   MULTI_DRAW_INDIRECT  the draw commands go into a GL_DRAW_INDIRECT_BUFFER
+//                        and one glMultiDrawElementsIndirect draws the pass
+//                        (GL 4.3 / ARB_multi_draw_indirect)
+//   DIRECT               one glDrawElementsInstancedBaseVertex(BaseInstance)
+//                        per command, for drivers without it
+// Model matrices are per-instance attributes (InstanceBuffer MATRIX layout),
+// and each command's baseInstance says where its matrices start, so the
+// shader reads its per-draw data as plain vertex inputs, without gl_DrawID.
+// Consecutive draws of the same mesh share one instanced command; sort the
+// draws by mesh (where order does not matter) to get the fewest commands.
+
+class MeshBatch
+{
+public:
+	enum Path
+	{
+		DIRECT,
+		MULTI_DRAW_INDIRECT
+	};
+
+	// GL's DrawElementsIndirectCommand
+	struct Command
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// Where a mesh lives in the shared buffers
+	struct Range
+	{
+		GLuint firstIndex = 0;
+		GLuint indexCount = 0;
+		GLint baseVertex = 0;
+		GLuint vertexCount = 0;
+	};
+
+	struct Stats
+	{
+		unsigned long long frames = 0;
+		unsigned long long draws = 0;    // draw() calls
+		unsigned long long commands = 0; // commands after merging
+		unsigned long long calls = 0;    // GL draw calls issued
+	};
+
+	// 'stride' floats per vertex, for every mesh in the batch
+	MeshBatch(int stride)
+		: stride(stride)
+	{
+	}
+
+	MeshBatch(const MeshBatch&) = delete;
+	MeshBatch& operator=(const MeshBatch&) = delete;
+
+	// Append a mesh (indices relative to its own vertices). Returns its id.
+	// -------------------------------------------------------------------
+	int add(const float* meshVertices, size_t vertexCount, const unsigned int* meshIndices, size_t indexCount)
+	{
+		Range range;
+		range.firstIndex = (GLuint)indices.size();
+		range.indexCount = (GLuint)indexCount;
+		range.baseVertex = (GLint)(vertices.size() / stride);
+		range.vertexCount = (GLuint)vertexCount;
+		vertices.insert(vertices.end(), meshVertices, meshVertices + vertexCount * stride);
+		indices.insert(indices.end(), meshIndices, meshIndices + indexCount);
+		ranges.push_back(range);
+		return (int)ranges.size() - 1;
+	}
+	// -------------------------------------------------------------------
+	int add(const MeshOptimizer::Mesh& mesh)
+	{
+		if (mesh.stride != stride)
+		{
+			std::cout << "ERROR::MESH_BATCH::STRIDE_MISMATCH " << mesh.stride << " floats, batch has " << stride << std::endl;
+			return -1;
+		}
+		return add(mesh.vertices.data(), mesh.vertexCount(), mesh.indices.data(), mesh.indices.size());
+	}
+
+	// Float attribute at 'offset' floats into each vertex (set before upload)
+	// -------------------------------------------------------------------
+	void attribute(GLuint location, GLint components, int offset)
+	{
+		Attribute attribute = { location, components, offset };
+		attributes.push_back(attribute);
+	}
+
+	// Create the shared buffers and the vertex array; the model matrix goes
+	// to locations instanceLocation .. instanceLocation + 3. Needs a context.
+	// -------------------------------------------------------------------
+	void upload(GLuint instanceLocation)
+	{
+		GLState& state = GLState::instance();
+		matrixLocation = instanceLocation;
+		glGenVertexArrays(1, &vertexArray);
+		state.bindVertexArray(vertexArray);
+		glGenBuffers(1, &vertexBuffer);
+		state.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+		glGenBuffers(1, &indexBuffer);
+		state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+		for (size_t i = 0; i < attributes.size(); i++)
+		{
+			const Attribute& attribute = attributes[i];
+			glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, stride * sizeof(float), (void*)(attribute.offset * sizeof(float)));
+			glEnableVertexAttribArray(attribute.location);
+		}
+		instances.attach(vertexArray, matrixLocation);
+		matrixSource = instances.getBuffer();
+		matrixOffset = 0;
+
+		if (GLExtensions::version(4, 3) || GLExtensions::has("GL_ARB_multi_draw_indirect"))
+			multiDrawElementsIndirect = (PFNMULTIDRAWELEMENTSINDIRECTPROC)GLExtensions::getProcAddress("glMultiDrawElementsIndirect");
+		if (GLExtensions::version(4, 2) || GLExtensions::has("GL_ARB_base_instance"))
+			drawElementsInstancedBaseVertexBaseInstance = (PFNDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)GLExtensions::getProcAddress("glDrawElementsInstancedBaseVertexBaseInstance");
+		// MDI commands need baseInstance honoured (4.2 / ARB_base_instance)
+		if (drawElementsInstancedBaseVertexBaseInstance == NULL)
+			multiDrawElementsIndirect = NULL;
+	}
+
+	// Can this context take a path? (after upload)
+	// -------------------------------------------------------------------
+	bool supports(Path path) const
+	{
+		return path == DIRECT || multiDrawElementsIndirect != NULL;
+	}
+	// -------------------------------------------------------------------
+	Path best() const
+	{
+		return supports(MULTI_DRAW_INDIRECT) ? MULTI_DRAW_INDIRECT : DIRECT;
+	}
+
+	// Start recording a frame
+	// -------------------------------------------------------------------
+	void begin()
+	{
+		commands.clear();
+		matrices.clear();
+	}
+
+	// Draw mesh 'mesh' with a column-major model matrix
+	// -------------------------------------------------------------------
+	void draw(int mesh, const float matrix[16])
+	{
+		if (mesh < 0 || mesh >= (int)ranges.size())
+			return;
+		GLuint instance = (GLuint)(matrices.size() / 16);
+		matrices.insert(matrices.end(), matrix, matrix + 16);
+		stats.draws++;
+		const Range& range = ranges[mesh];
+		if (!commands.empty())
+		{
+			Command& last = commands.back();
+			if (last.firstIndex == range.firstIndex && last.baseVertex == range.baseVertex && last.baseInstance + last.instanceCount == instance)
+			{
+				last.instanceCount++;
+				return;
+			}
+		}
+		Command command = { range.indexCount, 1, range.firstIndex, range.baseVertex, instance };
+		commands.push_back(command);
+	}
+
+	// Upload this frame's matrices and commands and draw them (the program
+	// must be in use). Uses the batch's own buffers, orphaned every frame.
+	// -------------------------------------------------------------------
+	void submit(Path path)
+	{
+		GLState& state = GLState::instance();
+		instances.upload(matrices.data(), matrices.size() / 16);
+		if (path == MULTI_DRAW_INDIRECT && supports(path))
+		{
+			if (commandBuffer == 0)
+			{
+				glGenBuffers(1, &commandBuffer);
+				state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+			}
+			state.bufferData(commandBuffer, GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)(commands.size() * sizeof(Command)), NULL, GL_STREAM_DRAW);
+			state.bufferSubData(commandBuffer, GL_DRAW_INDIRECT_BUFFER, 0, (GLsizeiptr)(commands.size() * sizeof(Command)), commands.data());
+			issue(path, commandBuffer, 0, instances.getBuffer(), 0);
+		}
+		else
+		{
+			issue(DIRECT, 0, 0, instances.getBuffer(), 0);
+		}
+	}
+
+	// Same, with the matrices and commands written into this frame's part
+	// of an UploadRing (call between ring.beginFrame() and endFrame())
+	// -------------------------------------------------------------------
+	void submit(Path path, UploadRing& ring)
+	{
+		UploadRing::Allocation matrixAllocation = ring.write(matrices.data(), matrices.size() * sizeof(float), sizeof(InstanceBuffer::Matrix));
+		UploadRing::Allocation commandAllocation;
+		if (path == MULTI_DRAW_INDIRECT && supports(path))
+			commandAllocation = ring.write(commands.data(), commands.size() * sizeof(Command), sizeof(Command));
+		if (!matrixAllocation.valid() || (path == MULTI_DRAW_INDIRECT && supports(path) && !commandAllocation.valid()))
+		{
+			// ring full: fall back to the batch's own buffers
+			submit(path);
+			return;
+		}
+		if (commandAllocation.valid())
+			issue(MULTI_DRAW_INDIRECT, ring.getBuffer(), commandAllocation.offset, ring.getBuffer(), matrixAllocation.offset);
+		else
+			issue(DIRECT, 0, 0, ring.getBuffer(), matrixAllocation.offset);
+	}
+
+	const Range& getRange(int mesh) const { return ranges[mesh]; }
+	size_t meshCount() const { return ranges.size(); }
+	size_t commandCount() const { return commands.size(); }
+	GLuint getVertexArray() const { return vertexArray; }
+	const Stats& getStats() const { return stats; }
+
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		std::cout << "MESH_BATCH:: meshes: " << ranges.size() << ", " << vertices.size() / stride << " vertices, " << indices.size() << " indices, frames: "
+			<< stats.frames << ", draws: " << stats.draws << ", commands: " << stats.commands << ", GL draw calls: " << stats.calls
+			<< (multiDrawElementsIndirect ? " (multi-draw indirect available)" : " (no multi-draw indirect)") << std::endl;
+	}
+
+	// Delete the GL objects. Call while the context is still current.
+	// -------------------------------------------------------------------
+	void release()
+	{
+		GLState& state = GLState::instance();
+		instances.release();
+		if (commandBuffer)
+			state.deleteBuffer(commandBuffer);
+		if (vertexBuffer)
+			state.deleteBuffer(vertexBuffer);
+		if (indexBuffer)
+			state.deleteBuffer(indexBuffer);
+		if (vertexArray)
+			state.deleteVertexArray(vertexArray);
+		commandBuffer = vertexBuffer = indexBuffer = vertexArray = 0;
+	}
+
+private:
+	struct Attribute
+	{
+		GLuint location;
+		GLint components;
+		int offset;
+	};
+
+	int stride;
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<Range> ranges;
+	std::vector<Attribute> attributes;
+	GLuint vertexArray = 0;
+	GLuint vertexBuffer = 0;
+	GLuint indexBuffer = 0;
+	GLuint commandBuffer = 0;
+	GLuint matrixLocation = 0;
+	GLuint matrixSource = 0;   // buffer + offset the instance attributes point at
+	size_t matrixOffset = 0;
+	InstanceBuffer instances{ InstanceBuffer::MATRIX };
+	std::vector<Command> commands;
+	std::vector<float> matrices;
+	PFNMULTIDRAWELEMENTSINDIRECTPROC multiDrawElementsIndirect = NULL;
+	PFNDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC drawElementsInstancedBaseVertexBaseInstance = NULL;
+	Stats stats;
+
+	// Draw the recorded commands, matrices at matrixBuffer + offset
+	// -------------------------------------------------------------------
+	void issue(Path path, GLuint indirectBuffer, GLintptr indirectOffset, GLuint matrixBuffer, GLintptr offset)
+	{
+		GLState& state = GLState::instance();
+		stats.frames++;
+		stats.commands += commands.size();
+		if (commands.empty())
+			return;
+		pointMatrices(matrixBuffer, (size_t)offset);
+		if (path == MULTI_DRAW_INDIRECT)
+		{
+			state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+			multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)indirectOffset, (GLsizei)commands.size(), 0);
+			stats.calls++;
+			return;
+		}
+		for (size_t i = 0; i < commands.size(); i++)
+		{
+			const Command& command = commands[i];
+			void* first = (void*)(command.firstIndex * sizeof(unsigned int));
+			if (drawElementsInstancedBaseVertexBaseInstance != NULL)
+			{
+				drawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, first, command.instanceCount, command.baseVertex, command.baseInstance);
+			}
+			else
+			{
+				// GL 3.3: move the instance attributes to this command's matrices
+				pointMatrices(matrixBuffer, (size_t)offset + command.baseInstance * sizeof(InstanceBuffer::Matrix));
+				glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, first, command.instanceCount, command.baseVertex);
+			}
+			stats.calls++;
+		}
+	}
+
+	// Instance attributes at 'buffer' + 'offset', only re-specified on change
+	void pointMatrices(GLuint buffer, size_t offset)
+	{
+		GLState::instance().bindVertexArray(vertexArray);
+		if (buffer == matrixSource && offset == matrixOffset)
+			return;
+		InstanceBuffer::point(InstanceBuffer::MATRIX, vertexArray, matrixLocation, buffer, offset);
+		matrixSource = buffer;
+		matrixOffset = offset;
+	}
+};
+#endif
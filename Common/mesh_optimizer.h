@@ -0,0 +1,319 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+// Mesh Optimizer Declaration
+// Turns unindexed triangle lists (the vertex arrays the projects draw with
+// glDrawArrays) into indexed meshes that the GPU transforms fewer vertices for:
+//   weld                 merges bit-identical vertices into an index buffer
+//   optimizeVertexCache  reorders triangles for the post-transform vertex
+//                        cache (Tom Forsyth's linear-speed algorithm)
+//   optimizeVertexFetch  reorders vertices by first use, so the vertex
+//                        fetch walks the buffer front to back
+//   analyzeVertexCache   simulates a FIFO cache and reports ACMR (vertices
+//                        transformed per triangle) and ATVR (per vertex)
+// Vertices are any interleaved float layout, 'stride' floats each (5 for
+// position + uv, 8 for position + color + uv).
+
+class MeshOptimizer
+{
+public:
+	struct Mesh
+	{
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		int stride = 0; // floats per vertex
+
+		size_t vertexCount() const { return stride > 0 ? vertices.size() / stride : 0; }
+		size_t triangleCount() const { return indices.size() / 3; }
+	};
+
+	struct CacheStats
+	{
+		size_t vertices = 0;
+		size_t triangles = 0;
+		size_t transformed = 0; // cache misses
+		float acmr = 0.0f;      // transformed / triangles, 0.5 .. 3
+		float atvr = 0.0f;      // transformed / vertices, 1 is ideal
+	};
+
+	// Cache size the analysis assumes; small enough for older hardware
+	static const int ANALYZE_CACHE_SIZE = 16;
+
+	// Merge bit-identical vertices (-0.0 and 0.0 count as different)
+	// -------------------------------------------------------------------
+	static Mesh weld(const float* vertices, size_t vertexCount, int stride)
+	{
+		Mesh mesh;
+		mesh.stride = stride;
+		mesh.indices.reserve(vertexCount);
+		std::unordered_map<VertexKey, unsigned int, VertexHash> unique;
+		unique.reserve(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			const float* vertex = vertices + i * stride;
+			VertexKey key = { vertex, stride };
+			std::pair<std::unordered_map<VertexKey, unsigned int, VertexHash>::iterator, bool> inserted =
+				unique.insert(std::make_pair(key, (unsigned int)mesh.vertexCount()));
+			if (inserted.second)
+				mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + stride);
+			mesh.indices.push_back(inserted.first->second);
+		}
+		return mesh;
+	}
+
+	// Reorder triangles so recently transformed vertices are reused while
+	// they are still in the post-transform cache
+	// -------------------------------------------------------------------
+	static void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+	{
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		// triangles using each vertex
+		std::vector<unsigned int> remaining(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			remaining[indices[i]]++;
+		}
+		std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+		}
+		std::vector<unsigned int> adjacency(triangleCount * 3);
+		std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				adjacency[filled[indices[t * 3 + k]]++] = (unsigned int)t;
+			}
+		}
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			vertexScore[v] = score(-1, remaining[v]);
+		}
+		std::vector<float> triangleScore(triangleCount);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		}
+		std::vector<bool> emitted(triangleCount, false);
+
+		std::vector<unsigned int> result;
+		result.reserve(triangleCount * 3);
+		std::vector<unsigned int> cache;
+		std::vector<unsigned int> newCache;
+		size_t nextInput = 0;
+		long best = 0;
+		while (result.size() < triangleCount * 3)
+		{
+			if (best < 0)
+			{
+				// nothing in the cache has triangles left: continue in input order
+				while (emitted[nextInput])
+				{
+					nextInput++;
+				}
+				best = (long)nextInput;
+			}
+			const unsigned int* triangle = &indices[best * 3];
+			emitted[best] = true;
+			newCache.assign(triangle, triangle + 3);
+			for (int k = 0; k < 3; k++)
+			{
+				// drop the triangle from its vertices' lists
+				unsigned int v = triangle[k];
+				unsigned int* begin = &adjacency[firstTriangle[v]];
+				unsigned int* end = begin + remaining[v];
+				*std::find(begin, end, (unsigned int)best) = *(end - 1);
+				remaining[v]--;
+				result.push_back(v);
+			}
+			for (size_t i = 0; i < cache.size(); i++)
+			{
+				if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+					newCache.push_back(cache[i]);
+			}
+
+			// rescore what is in the cache (and what just fell out of it)
+			for (size_t i = 0; i < newCache.size(); i++)
+			{
+				unsigned int v = newCache[i];
+				cachePosition[v] = i < (size_t)CACHE_SIZE ? (int)i : -1;
+				float updated = score(cachePosition[v], remaining[v]);
+				float delta = updated - vertexScore[v];
+				vertexScore[v] = updated;
+				for (unsigned int j = 0; j < remaining[v]; j++)
+				{
+					triangleScore[adjacency[firstTriangle[v] + j]] += delta;
+				}
+			}
+			if (newCache.size() > (size_t)CACHE_SIZE)
+				newCache.resize(CACHE_SIZE);
+			cache.swap(newCache);
+
+			// the next triangle comes from the vertices still in the cache
+			best = -1;
+			float bestScore = -1.0f;
+			for (size_t i = 0; i < cache.size(); i++)
+			{
+				unsigned int v = cache[i];
+				for (unsigned int j = 0; j < remaining[v]; j++)
+				{
+					unsigned int t = adjacency[firstTriangle[v] + j];
+					if (triangleScore[t] > bestScore)
+					{
+						bestScore = triangleScore[t];
+						best = (long)t;
+					}
+				}
+			}
+		}
+		indices.swap(result);
+	}
+
+	// Renumber vertices in the order the indices first use them (unused
+	// vertices are dropped)
+	// -------------------------------------------------------------------
+	static void optimizeVertexFetch(Mesh& mesh)
+	{
+		const unsigned int unassigned = 0xFFFFFFFFu;
+		std::vector<unsigned int> remap(mesh.vertexCount(), unassigned);
+		std::vector<float> vertices;
+		vertices.reserve(mesh.vertices.size());
+		unsigned int next = 0;
+		for (size_t i = 0; i < mesh.indices.size(); i++)
+		{
+			unsigned int& index = mesh.indices[i];
+			if (remap[index] == unassigned)
+			{
+				remap[index] = next++;
+				const float* vertex = &mesh.vertices[(size_t)index * mesh.stride];
+				vertices.insert(vertices.end(), vertex, vertex + mesh.stride);
+			}
+			index = remap[index];
+		}
+		mesh.vertices.swap(vertices);
+	}
+
+	// Weld, then order for the vertex cache and for fetch
+	// -------------------------------------------------------------------
+	static Mesh optimize(const float* vertices, size_t vertexCount, int stride)
+	{
+		Mesh mesh = weld(vertices, vertexCount, stride);
+		optimizeVertexCache(mesh.indices, mesh.vertexCount());
+		optimizeVertexFetch(mesh);
+		return mesh;
+	}
+
+	// FIFO post-transform cache simulation
+	// -------------------------------------------------------------------
+	static CacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, int cacheSize = ANALYZE_CACHE_SIZE)
+	{
+		CacheStats stats;
+		stats.vertices = vertexCount;
+		stats.triangles = indexCount / 3;
+		std::vector<unsigned int> fifo(cacheSize, 0xFFFFFFFFu);
+		size_t head = 0;
+		for (size_t i = 0; i < stats.triangles * 3; i++)
+		{
+			if (std::find(fifo.begin(), fifo.end(), indices[i]) != fifo.end())
+				continue;
+			fifo[head] = indices[i];
+			head = (head + 1) % cacheSize;
+			stats.transformed++;
+		}
+		stats.acmr = stats.triangles ? (float)stats.transformed / stats.triangles : 0.0f;
+		stats.atvr = vertexCount ? (float)stats.transformed / vertexCount : 0.0f;
+		return stats;
+	}
+
+	static CacheStats analyzeVertexCache(const Mesh& mesh, int cacheSize = ANALYZE_CACHE_SIZE)
+	{
+		return analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount(), cacheSize);
+	}
+
+	// Unindexed glDrawArrays of the same triangles, for comparison
+	// -------------------------------------------------------------------
+	static CacheStats analyzeUnindexed(size_t vertexCount)
+	{
+		CacheStats stats;
+		stats.vertices = vertexCount;
+		stats.triangles = vertexCount / 3;
+		stats.transformed = stats.triangles * 3;
+		stats.acmr = stats.triangles ? 3.0f : 0.0f;
+		stats.atvr = stats.triangles ? 1.0f : 0.0f;
+		return stats;
+	}
+
+	// One line per stats, e.g. before and after optimizing
+	// -------------------------------------------------------------------
+	static void printStats(const char* label, const CacheStats& stats)
+	{
+		std::cout << "MESH_OPTIMIZER:: " << label << ": " << stats.vertices << " vertices, " << stats.triangles << " triangles, "
+			<< stats.transformed << " transformed, ACMR " << stats.acmr << ", ATVR " << stats.atvr << std::endl;
+	}
+
+private:
+	// Cache the optimizer models (larger than the analysis cache on purpose:
+	// it tracks scores for vertices that may still be resident)
+	static const int CACHE_SIZE = 32;
+
+	struct VertexKey
+	{
+		const float* data;
+		int stride;
+
+		bool operator==(const VertexKey& other) const
+		{
+			return std::memcmp(data, other.data, stride * sizeof(float)) == 0;
+		}
+	};
+
+	struct VertexHash
+	{
+		size_t operator()(const VertexKey& key) const
+		{
+			// FNV-1a over the vertex bytes
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.data);
+			size_t hash = 2166136261u;
+			for (size_t i = 0; i < key.stride * sizeof(float); i++)
+			{
+				hash = (hash ^ bytes[i]) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	// Forsyth's vertex score: recently used vertices score high (the last
+	// triangle's three a little lower, to avoid strips), and vertices with
+	// few triangles left get a boost so they are finished off
+	// -------------------------------------------------------------------
+	static float score(int cachePosition, unsigned int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+		float value = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+				value = 0.75f;
+			else
+				value = std::pow(1.0f - (float)(cachePosition - 3) / (CACHE_SIZE - 3), 1.5f);
+		}
+		return value + 2.0f / std::sqrt((float)remainingTriangles);
+	}
+};
+#endif
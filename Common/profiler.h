@@ -0,0 +1,666 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+
+// Profiler Declaration
+// Scoped zones that time where a frame goes, on the CPU and on the GPU:
+//   PROFILE_SCOPE("draw");      CPU time of the enclosing block (any thread)
+//   PROFILE_GPU_SCOPE("draw");  GPU time of the GL commands issued in it
+//                               (rendering thread only)
+// GPU zones write GL_TIMESTAMP queries (glQueryCounter) at both ends, so they
+// may nest. Each frame has its own set of queries and results are collected
+// a few frames later, only once available: reading them never stalls, and a
+// set still pending when the ring comes back around is dropped and counted.
+// Every zone keeps a rolling history of its per-frame time (printStats
+// shows mean, percentiles and a histogram of it), and startCapture() records
+// frames as Chrome trace events (chrome://tracing, ui.perfetto.dev) for
+// writeChromeTrace().
+// Disabled (the default; LEARNOPENGL_PROFILE=1 or setEnabled(true) turns it
+// on) a zone costs one relaxed atomic load and a branch. Defining
+// PROFILER_DISABLED compiles the macros out completely.
+// LEARNOPENGL_PROFILE_TRACE=trace.json enables it, captures the first
+// LEARNOPENGL_PROFILE_FRAMES frames (default 300) and writes them at shutdown().
+
+// A named zone, registered once per call site by the macros
+struct ProfileZone
+{
+	const char* name;
+	int id;
+
+	explicit ProfileZone(const char* name);
+};
+
+class Profiler
+{
+public:
+	static const int HISTORY = 240;    // frames of history per zone
+	static const int GPU_LATENCY = 4;  // frames before GPU results are dropped
+
+	struct Stats
+	{
+		unsigned long long frames = 0;
+		unsigned long long cpuEvents = 0;
+		unsigned long long gpuEvents = 0;
+		unsigned long long gpuFramesRead = 0;
+		unsigned long long gpuFramesDropped = 0; // results not ready in time
+		unsigned long long traceEvents = 0;
+	};
+
+	// Per-frame times of one zone (milliseconds), most recent HISTORY frames
+	struct History
+	{
+		std::vector<float> samples;
+		size_t next = 0;
+		unsigned long long frames = 0; // frames the zone ran in
+		unsigned long long calls = 0;
+
+		void add(float ms)
+		{
+			if (samples.size() < (size_t)HISTORY)
+				samples.push_back(ms);
+			else
+				samples[next] = ms;
+			next = (next + 1) % HISTORY;
+			frames++;
+		}
+	};
+
+	// Shared profiler for all threads
+	// -------------------------------------------------------------------
+	static Profiler& instance()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	static bool enabled()
+	{
+		return enabledFlag().load(std::memory_order_relaxed);
+	}
+
+	// -------------------------------------------------------------------
+	void setEnabled(bool value)
+	{
+		enabledFlag().store(value, std::memory_order_relaxed);
+	}
+
+	// Skip GPU zones and timer queries, for programs without a GL context
+	// -------------------------------------------------------------------
+	void disableGpu()
+	{
+		gpuSupported = 0;
+	}
+
+	// Frame boundaries, on the rendering thread around everything in the
+	// frame (including the swap). beginFrame() collects finished GPU results.
+	// -------------------------------------------------------------------
+	void beginFrame()
+	{
+		if (!enabled())
+			return;
+		frameStart = now();
+		frameOpen = true;
+		mainTrack = threadBuffer().index;
+		if (gpuSupported < 0)
+			initGpu();
+		if (gpuSupported > 0)
+		{
+			if (frameIndex % 120 == 0)
+				calibrate();
+			collectGpu(false);
+			GpuFrame& slot = gpuFrames[frameIndex % GPU_LATENCY];
+			if (slot.pending)
+			{
+				// still not finished GPU_LATENCY frames later: drop it rather than wait
+				stats.gpuFramesDropped++;
+				glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+				slot.queries.clear();
+				slot.zones.clear();
+				slot.pending = false;
+			}
+			slot.used = 0;
+			slot.zones.clear();
+			slot.last = 0;
+			slot.frame = frameIndex;
+			slot.captured = capturing();
+		}
+	}
+
+	// -------------------------------------------------------------------
+	void endFrame()
+	{
+		if (!enabled() || !frameOpen)
+			return;
+		frameOpen = false;
+		long long end = now();
+		bool capture = capturing();
+		std::vector<double> totals(zoneCount(), 0.0);
+		std::vector<unsigned> calls(zoneCount(), 0);
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (size_t t = 0; t < threads.size(); t++)
+		{
+			ThreadBuffer& thread = *threads[t];
+			std::vector<CpuEvent> events;
+			{
+				std::lock_guard<std::mutex> threadLock(thread.mutex);
+				events.swap(thread.events);
+			}
+			for (size_t e = 0; e < events.size(); e++)
+			{
+				const CpuEvent& event = events[e];
+				if ((size_t)event.zone >= totals.size())
+				{
+					// registered by another thread during this frame
+					totals.resize(event.zone + 1, 0.0);
+					calls.resize(event.zone + 1, 0);
+				}
+				totals[event.zone] += (event.end - event.start) * 1e-6;
+				calls[event.zone]++;
+				if (capture)
+					addTrace(zoneName(event.zone), "cpu", (int)t, event.start, event.end);
+			}
+			stats.cpuEvents += events.size();
+		}
+		addFrameTotals(cpu, totals, calls);
+		frameHistory.add((float)((end - frameStart) * 1e-6));
+		if (capture)
+			addTrace("frame", "cpu", mainTrack, frameStart, end);
+		if (gpuSupported > 0)
+		{
+			GpuFrame& slot = gpuFrames[frameIndex % GPU_LATENCY];
+			slot.pending = !slot.zones.empty();
+		}
+		if (captureFrames > 0 && --captureFrames == 0)
+			std::cout << "PROFILER:: capture finished, " << stats.traceEvents << " events" << std::endl;
+		frameIndex++;
+		stats.frames++;
+	}
+
+	// Record the next 'frames' frames for writeChromeTrace()
+	// -------------------------------------------------------------------
+	void startCapture(int frames)
+	{
+		std::lock_guard<std::mutex> lock(traceMutex);
+		trace.clear();
+		stats.traceEvents = 0;
+		captureFrames = frames;
+	}
+
+	bool capturing() const { return captureFrames > 0; }
+
+	// Write the captured events as Chrome trace JSON. GPU events of the last
+	// few frames arrive later; shutdown() collects them first.
+	// -------------------------------------------------------------------
+	bool writeChromeTrace(const std::string& path)
+	{
+		FILE* file = std::fopen(path.c_str(), "w");
+		if (file == NULL)
+		{
+			std::cout << "ERROR::PROFILER::TRACE_WRITE_FAILED " << path << std::endl;
+			return false;
+		}
+		int threadCount = 0;
+		{
+			std::lock_guard<std::mutex> threadsLock(threadsMutex);
+			threadCount = (int)threads.size();
+		}
+		std::lock_guard<std::mutex> lock(traceMutex);
+		std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"LearnOpenGL\"}}");
+		for (int t = 0; t < threadCount; t++)
+		{
+			std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}", t,
+				t == mainTrack ? "main" : "thread", t);
+		}
+		std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", GPU_TRACK);
+		for (size_t i = 0; i < trace.size(); i++)
+		{
+			const TraceEvent& event = trace[i];
+			std::fprintf(file, ",\n{\"name\":\"");
+			for (const char* c = event.name; *c; c++)
+			{
+				if (*c == '"' || *c == '\\')
+					std::fputc('\\', file);
+				std::fputc(*c, file);
+			}
+			std::fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event.category, event.track,
+				event.start * 1e-3, (event.end - event.start) * 1e-3);
+		}
+		std::fprintf(file, "\n]}\n");
+		std::fclose(file);
+		std::cout << "PROFILER:: " << trace.size() << " trace events written to " << path << std::endl;
+		return true;
+	}
+
+	// Mean, percentiles and histogram of each zone's per-frame time
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		std::cout << "PROFILER:: frames: " << stats.frames << ", cpu events: " << stats.cpuEvents << ", gpu events: " << stats.gpuEvents
+			<< ", gpu frames read: " << stats.gpuFramesRead << ", dropped: " << stats.gpuFramesDropped;
+		if (gpuSupported == 0)
+			std::cout << " (no timer queries)";
+		std::cout << std::endl;
+		printHistory("frame", "cpu", frameHistory);
+		for (size_t z = 0; z < cpu.size(); z++)
+		{
+			if (cpu[z].frames > 0)
+				printHistory(zoneName((int)z), "cpu", cpu[z]);
+		}
+		for (size_t z = 0; z < gpu.size(); z++)
+		{
+			if (gpu[z].frames > 0)
+				printHistory(zoneName((int)z), "gpu", gpu[z]);
+		}
+	}
+
+	const Stats& getStats() const { return stats; }
+
+	// History of a zone's CPU or GPU time, NULL if it never ran
+	// -------------------------------------------------------------------
+	const History* getHistory(const char* name, bool gpuTime) const
+	{
+		const std::vector<History>& histories = gpuTime ? gpu : cpu;
+		std::lock_guard<std::mutex> lock(zonesMutex());
+		for (size_t z = 0; z < zoneNames().size() && z < histories.size(); z++)
+		{
+			if (std::string(zoneNames()[z]) == name)
+				return &histories[z];
+		}
+		return NULL;
+	}
+
+	// End of the program, while the context is current: wait for the last
+	// GPU results, print, write the trace if LEARNOPENGL_PROFILE_TRACE is
+	// set, and delete the queries
+	// -------------------------------------------------------------------
+	void shutdown()
+	{
+		if (stats.frames == 0)
+			return;
+		if (gpuSupported > 0)
+			collectGpu(true);
+		printStats();
+		if (!tracePath.empty())
+			writeChromeTrace(tracePath);
+		for (int i = 0; i < GPU_LATENCY; i++)
+		{
+			if (!gpuFrames[i].queries.empty())
+				glDeleteQueries((GLsizei)gpuFrames[i].queries.size(), gpuFrames[i].queries.data());
+			gpuFrames[i] = GpuFrame();
+		}
+		gpuSupported = -1;
+	}
+
+	// Used by ProfileScope / GpuProfileScope
+	// -------------------------------------------------------------------
+	void addCpu(int zone, long long start, long long end)
+	{
+		ThreadBuffer& thread = threadBuffer();
+		std::lock_guard<std::mutex> lock(thread.mutex);
+		thread.events.push_back({ zone, start, end });
+	}
+
+	int beginGpu(int zone)
+	{
+		if (gpuSupported <= 0 || !frameOpen)
+			return -1;
+		GpuFrame& slot = gpuFrames[frameIndex % GPU_LATENCY];
+		GpuZone entry;
+		entry.zone = zone;
+		entry.begin = query(slot);
+		entry.end = query(slot);
+		glQueryCounter(entry.begin, GL_TIMESTAMP);
+		slot.last = entry.begin;
+		slot.zones.push_back(entry);
+		return (int)slot.zones.size() - 1;
+	}
+
+	void endGpu(int index)
+	{
+		if (index < 0 || !frameOpen)
+			return;
+		GpuFrame& slot = gpuFrames[frameIndex % GPU_LATENCY];
+		glQueryCounter(slot.zones[index].end, GL_TIMESTAMP);
+		slot.last = slot.zones[index].end;
+	}
+
+	// Nanoseconds since the profiler started
+	static long long now()
+	{
+		static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	// Zone registry (ProfileZone)
+	// -------------------------------------------------------------------
+	static int registerZone(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(zonesMutex());
+		zoneNames().push_back(name);
+		return (int)zoneNames().size() - 1;
+	}
+
+private:
+	static const int GPU_TRACK = 1000; // trace track of GPU zones
+
+	struct CpuEvent
+	{
+		int zone;
+		long long start;
+		long long end;
+	};
+	struct ThreadBuffer
+	{
+		int index = 0; // trace track
+		std::mutex mutex;
+		std::vector<CpuEvent> events;
+	};
+	struct GpuZone
+	{
+		int zone;
+		GLuint begin;
+		GLuint end;
+	};
+	struct GpuFrame
+	{
+		std::vector<GLuint> queries;
+		size_t used = 0;
+		std::vector<GpuZone> zones;     // in begin order: an outer zone ends after its inner ones
+		GLuint last = 0;                // query written last in the frame
+		unsigned long long frame = 0;
+		bool pending = false;
+		bool captured = false;
+	};
+	struct TraceEvent
+	{
+		const char* name;
+		const char* category;
+		int track;
+		long long start;
+		long long end;
+	};
+
+	Stats stats;
+	std::vector<History> cpu;
+	std::vector<History> gpu;
+	History frameHistory;
+	std::vector<std::unique_ptr<ThreadBuffer>> threads;
+	mutable std::mutex threadsMutex;
+	std::vector<TraceEvent> trace;
+	std::mutex traceMutex;
+	GpuFrame gpuFrames[GPU_LATENCY];
+	int gpuSupported = -1;      // -1 not checked yet
+	long long gpuOffset = 0;    // GL_TIMESTAMP - now()
+	unsigned long long frameIndex = 0;
+	long long frameStart = 0;
+	bool frameOpen = false;
+	int mainTrack = 0;
+	int captureFrames = 0;
+	std::string tracePath;
+
+	Profiler()
+	{
+		const char* value = std::getenv("LEARNOPENGL_PROFILE");
+		if (value != NULL && value[0] != '\0' && std::string(value) != "0")
+			setEnabled(true);
+		value = std::getenv("LEARNOPENGL_PROFILE_TRACE");
+		if (value != NULL && value[0] != '\0')
+		{
+			tracePath = value;
+			const char* frames = std::getenv("LEARNOPENGL_PROFILE_FRAMES");
+			startCapture(frames != NULL ? std::max(1, std::atoi(frames)) : 300);
+			setEnabled(true);
+		}
+	}
+
+	static std::atomic<bool>& enabledFlag()
+	{
+		static std::atomic<bool> flag{ false };
+		return flag;
+	}
+	static std::mutex& zonesMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+	static std::vector<const char*>& zoneNames()
+	{
+		static std::vector<const char*> names;
+		return names;
+	}
+	static size_t zoneCount()
+	{
+		std::lock_guard<std::mutex> lock(zonesMutex());
+		return zoneNames().size();
+	}
+	static const char* zoneName(int zone)
+	{
+		std::lock_guard<std::mutex> lock(zonesMutex());
+		return zoneNames()[zone];
+	}
+
+	// This thread's event buffer, registered on first use
+	// -------------------------------------------------------------------
+	ThreadBuffer& threadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = NULL;
+		if (buffer == NULL)
+		{
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			threads.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+			buffer = threads.back().get();
+			buffer->index = (int)threads.size() - 1;
+		}
+		return *buffer;
+	}
+
+	// -------------------------------------------------------------------
+	void addFrameTotals(std::vector<History>& histories, const std::vector<double>& totals, const std::vector<unsigned>& calls)
+	{
+		if (histories.size() < totals.size())
+			histories.resize(totals.size());
+		for (size_t z = 0; z < totals.size(); z++)
+		{
+			if (calls[z] == 0)
+				continue;
+			histories[z].add((float)totals[z]);
+			histories[z].calls += calls[z];
+		}
+	}
+
+	void addTrace(const char* name, const char* category, int track, long long start, long long end)
+	{
+		std::lock_guard<std::mutex> lock(traceMutex);
+		trace.push_back({ name, category, track, start, end });
+		stats.traceEvents++;
+	}
+
+	// Timer queries need GL_QUERY_COUNTER_BITS > 0 for GL_TIMESTAMP
+	// -------------------------------------------------------------------
+	void initGpu()
+	{
+		GLint bits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+		gpuSupported = bits > 0 ? 1 : 0;
+	}
+
+	// Line up GPU timestamps with now() for the trace
+	// -------------------------------------------------------------------
+	void calibrate()
+	{
+		GLint64 gpuNow = 0;
+		long long cpuNow = now();
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		gpuOffset = (long long)gpuNow - cpuNow;
+	}
+
+	GLuint query(GpuFrame& slot)
+	{
+		if (slot.used == slot.queries.size())
+		{
+			size_t grow = std::max<size_t>(16, slot.queries.size());
+			slot.queries.resize(slot.queries.size() + grow);
+			glGenQueries((GLsizei)grow, slot.queries.data() + slot.used);
+		}
+		return slot.queries[slot.used++];
+	}
+
+	// Read back every finished frame; with 'wait' also the unfinished ones
+	// -------------------------------------------------------------------
+	void collectGpu(bool wait)
+	{
+		for (int i = 0; i < GPU_LATENCY; i++)
+		{
+			// oldest first, so the histories stay in frame order
+			GpuFrame& slot = gpuFrames[(frameIndex + i) % GPU_LATENCY];
+			if (!slot.pending)
+				continue;
+			// timestamps complete in order: the last one written done means
+			// all are (not zones.back(), nested zones end after it)
+			GLint available = 0;
+			glGetQueryObjectiv(slot.last, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available && !wait)
+				continue;
+			readGpu(slot);
+		}
+	}
+
+	void readGpu(GpuFrame& slot)
+	{
+		std::vector<double> totals(zoneCount(), 0.0);
+		std::vector<unsigned> calls(zoneCount(), 0);
+		for (size_t z = 0; z < slot.zones.size(); z++)
+		{
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(slot.zones[z].begin, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(slot.zones[z].end, GL_QUERY_RESULT, &end);
+			int zone = slot.zones[z].zone;
+			totals[zone] += (double)(end - begin) * 1e-6;
+			calls[zone]++;
+			if (slot.captured)
+				addTrace(zoneName(zone), "gpu", GPU_TRACK, (long long)begin - gpuOffset, (long long)end - gpuOffset);
+		}
+		addFrameTotals(gpu, totals, calls);
+		stats.gpuEvents += slot.zones.size();
+		stats.gpuFramesRead++;
+		slot.pending = false;
+	}
+
+	// -------------------------------------------------------------------
+	static void printHistory(const char* name, const char* kind, const History& history)
+	{
+		static const float edges[] = { 0.05f, 0.1f, 0.25f, 0.5f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 33.0f };
+		static const int BUCKETS = sizeof(edges) / sizeof(edges[0]) + 1;
+		std::vector<float> sorted = history.samples;
+		if (sorted.empty())
+			return;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0.0;
+		int counts[BUCKETS] = {};
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			total += sorted[i];
+			int bucket = (int)(std::upper_bound(edges, edges + BUCKETS - 1, sorted[i]) - edges);
+			counts[bucket]++;
+		}
+		size_t last = sorted.size() - 1;
+		std::cout << "PROFILER::   " << kind << " " << name << ": mean " << total / sorted.size() << " ms, p50 " << sorted[last / 2]
+			<< ", p95 " << sorted[last * 95 / 100] << ", p99 " << sorted[last * 99 / 100] << ", max " << sorted[last];
+		if (history.calls > 0)
+			std::cout << ", " << (double)history.calls / history.frames << " calls/frame";
+		std::cout << std::endl << "PROFILER::     ";
+		for (int b = 0; b < BUCKETS; b++)
+		{
+			if (counts[b] == 0)
+				continue;
+			if (b < BUCKETS - 1)
+				std::cout << "<" << edges[b] << ":" << counts[b] << " ";
+			else
+				std::cout << ">=" << edges[b - 1] << ":" << counts[b];
+		}
+		std::cout << "(last " << sorted.size() << " frames)" << std::endl;
+	}
+};
+
+inline ProfileZone::ProfileZone(const char* name)
+	: name(name), id(Profiler::registerZone(name))
+{
+}
+
+// CPU zone: times the enclosing scope when the profiler is enabled
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const ProfileZone& zone)
+	{
+		if (Profiler::enabled())
+		{
+			id = zone.id;
+			start = Profiler::now();
+		}
+	}
+
+	~ProfileScope()
+	{
+		if (id >= 0)
+			Profiler::instance().addCpu(id, start, Profiler::now());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	int id = -1;
+	long long start = 0;
+};
+
+// GPU zone: timestamps around the GL commands of the enclosing scope
+class GpuProfileScope
+{
+public:
+	explicit GpuProfileScope(const ProfileZone& zone)
+	{
+		if (Profiler::enabled())
+			index = Profiler::instance().beginGpu(zone.id);
+	}
+
+	~GpuProfileScope()
+	{
+		if (index >= 0)
+			Profiler::instance().endGpu(index);
+	}
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+	int index = -1;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#ifndef PROFILER_DISABLED
+#define PROFILE_SCOPE(name) \
+	static const ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name); \
+	ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileZone, __LINE__))
+#define PROFILE_GPU_SCOPE(name) \
+	static const ProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(name); \
+	GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(PROFILE_CONCAT(gpuProfileZone, __LINE__))
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#endif
+#endif
@@ -0,0 +1,245 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+#include "shader_source.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+// Program Binary Cache Declaration
+// Linked programs are written to disk with glGetProgramBinary and read back
+// with glProgramBinary on the next launch. Entries are keyed by a hash of the
+// shader sources, the defines they were built with and the GL vendor/renderer/
+// version strings, so a driver update simply turns into a cache miss.
+// Set LEARNOPENGL_SHADER_CACHE=0 to turn the cache off.
+
+class ProgramCache
+{
+public:
+	// Cache counters (times are in milliseconds)
+	struct Stats
+	{
+		unsigned int hits = 0;
+		unsigned int misses = 0;
+		unsigned int rejected = 0;
+		unsigned int stores = 0;
+		double loadTime = 0.0;
+		double compileTime = 0.0;
+		double timeSaved = 0.0;
+	};
+
+	// Shared cache used by the Shader class
+	// -------------------------------------------------------------------
+	static ProgramCache& instance()
+	{
+		static ProgramCache cache("shader_cache");
+		return cache;
+	}
+
+	// ProgramCache Constructor: directory is created on the first store
+	// -------------------------------------------------------------------
+	ProgramCache(const std::string& directory)
+		: directory(directory)
+	{
+		const char* env = std::getenv("LEARNOPENGL_SHADER_CACHE");
+		enabled = !(env && std::strcmp(env, "0") == 0);
+	}
+
+	// Returns true when the current context can save and restore program binaries
+	// -------------------------------------------------------------------
+	bool isSupported()
+	{
+		if (!enabled)
+			return false;
+		if (supported < 0)
+		{
+			GLint formats = 0;
+			if (glGetProgramBinary != NULL && glProgramBinary != NULL && glProgramParameteri != NULL)
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			supported = formats > 0 ? 1 : 0;
+		}
+		return supported == 1;
+	}
+
+	// Combine the stage hashes (which already cover their defines, see
+	// ShaderSource::getHash) with the driver identity
+	// -------------------------------------------------------------------
+	uint64_t makeKey(uint64_t vertexHash, uint64_t fragmentHash)
+	{
+		if (driverInfo.empty())
+		{
+			driverInfo += glString(GL_VENDOR);
+			driverInfo += '\n';
+			driverInfo += glString(GL_RENDERER);
+			driverInfo += '\n';
+			driverInfo += glString(GL_VERSION);
+		}
+		uint64_t hash = hashSource(driverInfo.data(), driverInfo.size());
+		hash = hashSource(&vertexHash, sizeof(vertexHash), hash);
+		return hashSource(&fragmentHash, sizeof(fragmentHash), hash);
+	}
+
+	// Try to restore 'program' from disk. Returns false on a miss or when the
+	// driver rejects the blob; the caller then compiles from source as usual.
+	// -------------------------------------------------------------------
+	bool load(uint64_t key, unsigned int program)
+	{
+		if (!isSupported())
+			return false;
+
+		auto start = std::chrono::steady_clock::now();
+		std::ifstream file(entryPath(key), std::ios::binary | std::ios::ate);
+		if (!file)
+		{
+			stats.misses++;
+			return false;
+		}
+		std::streamoff fileSize = file.tellg();
+		file.seekg(0);
+
+		Header header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		bool valid = file && std::memcmp(header.magic, "GLPB", 4) == 0 && header.version == FORMAT_VERSION && header.key == key;
+		// a corrupt length must not size the read past the end of the file
+		if (valid && (header.length == 0 || (std::streamoff)header.length > fileSize - (std::streamoff)sizeof(header)))
+			valid = false;
+		std::vector<char> binary;
+		if (valid)
+		{
+			binary.resize(header.length);
+			file.read(binary.data(), header.length);
+			valid = (bool)file;
+		}
+		file.close();
+
+		GLint success = 0;
+		if (valid)
+		{
+			glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+		}
+		if (!success)
+		{
+			// stale or corrupt entry: drop it so the next store replaces it
+			stats.rejected++;
+			stats.misses++;
+			std::error_code ec;
+			std::filesystem::remove(entryPath(key), ec);
+			return false;
+		}
+
+		double elapsed = millisecondsSince(start);
+		stats.hits++;
+		stats.loadTime += elapsed;
+		if (header.compileTime > elapsed)
+			stats.timeSaved += header.compileTime - elapsed;
+		return true;
+	}
+
+	// Save a freshly linked program. compileTime is what it took to build
+	// from source and is kept in the entry to report the time saved on a hit.
+	// -------------------------------------------------------------------
+	void store(uint64_t key, unsigned int program, double compileTime)
+	{
+		stats.compileTime += compileTime;
+		if (!isSupported())
+			return;
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+			return;
+
+		Header header;
+		std::memcpy(header.magic, "GLPB", 4);
+		header.version = FORMAT_VERSION;
+		header.key = key;
+		header.compileTime = compileTime;
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(program, length, NULL, &format, binary.data());
+		header.format = format;
+		header.length = (uint32_t)length;
+
+		std::error_code ec;
+		std::filesystem::create_directories(directory, ec);
+		// write to a temporary name first so a crash never leaves a torn entry
+		std::string path = entryPath(key);
+		std::string temporary = path + ".tmp";
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::SHADER_CACHE::FAILED_TO_WRITE " << temporary << std::endl;
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), binary.size());
+		file.close();
+		std::filesystem::rename(temporary, path, ec);
+		if (!ec)
+			stats.stores++;
+	}
+
+	// Report hits, misses and the startup time the cache saved
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		std::cout << "SHADER_CACHE:: hits: " << stats.hits << " misses: " << stats.misses
+			<< " (rejected: " << stats.rejected << ") stored: " << stats.stores << "\n"
+			<< "SHADER_CACHE:: compile: " << stats.compileTime << " ms, load: " << stats.loadTime
+			<< " ms, saved: " << stats.timeSaved << " ms" << std::endl;
+	}
+
+	const Stats& getStats() const { return stats; }
+	void setEnabled(bool value) { enabled = value; }
+
+	// Helper for timing the compile path
+	// -------------------------------------------------------------------
+	static double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	static const uint32_t FORMAT_VERSION = 1;
+
+	// On-disk entry header, followed by 'length' bytes of program binary
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+		uint32_t format;
+		uint32_t length;
+		double compileTime;
+	};
+
+	std::string directory;
+	std::string driverInfo;
+	Stats stats;
+	int supported = -1;
+	bool enabled = true;
+
+	std::string entryPath(uint64_t key) const
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+		return (std::filesystem::path(directory) / name).string();
+	}
+
+	static std::string glString(GLenum name)
+	{
+		const GLubyte* value = glGetString(name);
+		return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+	}
+};
+#endif
@@ -0,0 +1,243 @@
+#ifndef RENDER_COMMANDS_H
+#define RENDER_COMMANDS_H
+
+#include <glad/glad.h>
+#include "gl_state.h"
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+// Render Command List Declaration
+// One frame of GL work recorded as plain data, so it can be built on one
+// thread and replayed on the thread that owns the context (RenderThread).
+// Every command is a fixed 24 byte record; uniform values and buffer
+// contents are copied into a byte arena next to the commands, so the list
+// holds no pointers into the recording thread's memory and nothing that
+// needs a destructor. Both arrays keep their capacity across clear(), so
+// after the first frames recording allocates nothing.
+// Objects (programs, vertex arrays, textures, buffers) are referenced by
+// their GL names and must be created before they are used in a list, e.g.
+// through RenderThread::invoke(). Bindings go through the replaying
+// thread's GLState, so redundant ones are still dropped.
+
+class RenderCommandList
+{
+public:
+	enum Op : uint32_t
+	{
+		CLEAR,                   // a: mask, payload: float[4] color
+		VIEWPORT,                // a, b: width, height (origin 0, 0)
+		SET_CAPABILITY,          // a: capability, b: enabled
+		USE_PROGRAM,             // a: program
+		BIND_VERTEX_ARRAY,       // a: vertex array
+		BIND_TEXTURE,            // a: unit, b: target, c: texture
+		UNIFORM_INT,             // a: location, b: value
+		UNIFORM_FLOAT,           // a: location, payload: float
+		UNIFORM_VEC4,            // a: location, payload: float[4]
+		UNIFORM_MAT4,            // a: location, payload: float[16]
+		UPLOAD_BUFFER,           // a: target, b: buffer, c: usage, payload: data
+		DRAW_ARRAYS,             // a: mode, b: first, c: count
+		DRAW_ELEMENTS,           // a: mode, b: count, c: byte offset (unsigned int indices)
+		DRAW_ELEMENTS_INSTANCED  // a: mode, b: count, c: instances (offset 0)
+	};
+
+	struct Command
+	{
+		uint32_t op;
+		uint32_t a;
+		uint32_t b;
+		uint32_t c;
+		uint32_t payload; // byte offset into the arena
+		uint32_t size;    // payload bytes
+	};
+	static_assert(std::is_trivially_copyable<Command>::value && sizeof(Command) == 24, "RenderCommandList::Command must stay a 24 byte POD");
+
+	// Start a new frame (keeps the memory)
+	// -------------------------------------------------------------------
+	void clear()
+	{
+		commands.clear();
+		used = 0;
+	}
+
+	size_t commandCount() const { return commands.size(); }
+	size_t payloadBytes() const { return used; }
+	size_t memoryBytes() const { return commands.capacity() * sizeof(Command) + arena.capacity(); }
+
+	// Recording
+	// -------------------------------------------------------------------
+	void clearTarget(GLbitfield mask, float r, float g, float b, float a)
+	{
+		const float color[4] = { r, g, b, a };
+		push(CLEAR, mask, 0, 0, color, sizeof(color));
+	}
+
+	void viewport(GLsizei width, GLsizei height)
+	{
+		push(VIEWPORT, (uint32_t)width, (uint32_t)height);
+	}
+
+	void setCapability(GLenum capability, bool enabled)
+	{
+		push(SET_CAPABILITY, capability, enabled ? 1 : 0);
+	}
+
+	void useProgram(GLuint program)
+	{
+		push(USE_PROGRAM, program);
+	}
+
+	void bindVertexArray(GLuint vertexArray)
+	{
+		push(BIND_VERTEX_ARRAY, vertexArray);
+	}
+
+	void bindTexture(GLuint unit, GLenum target, GLuint texture)
+	{
+		push(BIND_TEXTURE, unit, target, texture);
+	}
+
+	// -------------------------------------------------------------------
+	void setInt(GLint location, int value)
+	{
+		push(UNIFORM_INT, (uint32_t)location, (uint32_t)value);
+	}
+
+	void setFloat(GLint location, float value)
+	{
+		push(UNIFORM_FLOAT, (uint32_t)location, 0, 0, &value, sizeof(value));
+	}
+
+	void setVec4(GLint location, float x, float y, float z, float w)
+	{
+		const float value[4] = { x, y, z, w };
+		push(UNIFORM_VEC4, (uint32_t)location, 0, 0, value, sizeof(value));
+	}
+
+	void setMat4(GLint location, const float* value)
+	{
+		push(UNIFORM_MAT4, (uint32_t)location, 0, 0, value, 16 * sizeof(float));
+	}
+
+	// Replace a buffer's contents (glBufferData, so the old storage is
+	// orphaned); 'data' is copied into the list now
+	// -------------------------------------------------------------------
+	void uploadBuffer(GLenum target, GLuint buffer, const void* data, size_t size, GLenum usage = GL_STREAM_DRAW)
+	{
+		push(UPLOAD_BUFFER, target, buffer, usage, data, size);
+	}
+
+	// Room for 'size' bytes of buffer contents, written by the caller
+	// before submitting the list (saves a copy for data built per frame).
+	// The pointer is only good until the next command is recorded.
+	// -------------------------------------------------------------------
+	void* uploadBuffer(GLenum target, GLuint buffer, size_t size, GLenum usage = GL_STREAM_DRAW)
+	{
+		push(UPLOAD_BUFFER, target, buffer, usage, NULL, size);
+		return arena.data() + commands.back().payload;
+	}
+
+	// -------------------------------------------------------------------
+	void drawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		push(DRAW_ARRAYS, mode, (uint32_t)first, (uint32_t)count);
+	}
+
+	void drawElements(GLenum mode, GLsizei count, size_t offset = 0)
+	{
+		push(DRAW_ELEMENTS, mode, (uint32_t)count, (uint32_t)offset);
+	}
+
+	void drawElementsInstanced(GLenum mode, GLsizei count, GLsizei instances)
+	{
+		push(DRAW_ELEMENTS_INSTANCED, mode, (uint32_t)count, (uint32_t)instances);
+	}
+
+	// Replay on the thread the context is current on
+	// -------------------------------------------------------------------
+	void execute() const
+	{
+		GLState& state = GLState::instance();
+		const unsigned char* data = arena.data();
+		for (size_t i = 0; i < commands.size(); i++)
+		{
+			const Command& command = commands[i];
+			const float* values = reinterpret_cast<const float*>(data + command.payload);
+			switch (command.op)
+			{
+			case CLEAR:
+				state.clearColor(values[0], values[1], values[2], values[3]);
+				glClear(command.a);
+				break;
+			case VIEWPORT:
+				state.viewport(0, 0, (GLsizei)command.a, (GLsizei)command.b);
+				break;
+			case SET_CAPABILITY:
+				state.setCapability(command.a, command.b != 0);
+				break;
+			case USE_PROGRAM:
+				state.useProgram(command.a);
+				break;
+			case BIND_VERTEX_ARRAY:
+				state.bindVertexArray(command.a);
+				break;
+			case BIND_TEXTURE:
+				state.bindTexture(command.a, command.b, command.c);
+				break;
+			case UNIFORM_INT:
+				glUniform1i((GLint)command.a, (GLint)command.b);
+				break;
+			case UNIFORM_FLOAT:
+				glUniform1f((GLint)command.a, values[0]);
+				break;
+			case UNIFORM_VEC4:
+				glUniform4fv((GLint)command.a, 1, values);
+				break;
+			case UNIFORM_MAT4:
+				glUniformMatrix4fv((GLint)command.a, 1, GL_FALSE, values);
+				break;
+			case UPLOAD_BUFFER:
+				state.bufferData(command.b, command.a, command.size, data + command.payload, command.c);
+				break;
+			case DRAW_ARRAYS:
+				glDrawArrays(command.a, (GLint)command.b, (GLsizei)command.c);
+				break;
+			case DRAW_ELEMENTS:
+				glDrawElements(command.a, (GLsizei)command.b, GL_UNSIGNED_INT, (void*)(uintptr_t)command.c);
+				break;
+			case DRAW_ELEMENTS_INSTANCED:
+				glDrawElementsInstanced(command.a, (GLsizei)command.b, GL_UNSIGNED_INT, 0, (GLsizei)command.c);
+				break;
+			}
+		}
+	}
+
+private:
+	// payloads start 16 byte aligned, so matrices can be read in place
+	static const size_t ALIGNMENT = 16;
+
+	std::vector<Command> commands;
+	std::vector<unsigned char> arena; // only grows: resize() would clear the bytes every frame
+	size_t used = 0;
+
+	// -------------------------------------------------------------------
+	void push(uint32_t op, uint32_t a, uint32_t b = 0, uint32_t c = 0, const void* payload = NULL, size_t size = 0)
+	{
+		Command command = { op, a, b, c, 0, (uint32_t)size };
+		if (size > 0)
+		{
+			size_t offset = (used + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+			used = offset + size;
+			if (used > arena.size())
+				arena.resize(std::max(used, arena.size() * 2));
+			if (payload != NULL)
+				std::memcpy(arena.data() + offset, payload, size);
+			command.payload = (uint32_t)offset;
+		}
+		commands.push_back(command);
+	}
+};
+#endif
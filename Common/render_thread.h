@@ -0,0 +1,271 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "app_window.h"
+#include "render_commands.h"
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <functional>
+#include <condition_variable>
+
+// Render Thread Declaration
+// Moves GL submission off the main thread. start() hands the window's
+// context to a thread of its own; from then on the main thread only
+// records RenderCommandLists and the render thread replays each one and
+// presents it (AppWindow::present). There are two lists: while the render
+// thread submits frame N the main thread records frame N+1 into the other
+// one, so a spike in update no longer delays the swap of the frame before
+// it, and beginFrame() only blocks when the main thread is a whole frame
+// ahead. stop() waits for the submitted frames and gives the context back
+// to the calling thread.
+//   RenderThread renderer(window);
+//   renderer.start();
+//   while (!window.shouldClose())
+//   {
+//       RenderCommandList& commands = renderer.beginFrame();
+//       ... update, record into 'commands'
+//       renderer.submit();
+//       window.endFrame(); // events, next frame
+//   }
+//   renderer.stop();
+// Creating or deleting GL objects while it runs goes through invoke(),
+// which runs a function on the render thread between frames and waits
+// for it. GLState::instance() is per thread, so the render thread starts
+// with its own (empty) cache and the caller's is invalidated by stop().
+
+class RenderThread
+{
+public:
+	static const int LISTS = 2;
+
+	struct Stats
+	{
+		unsigned long long frames = 0;
+		double waitMs = 0.0;     // main thread blocked in beginFrame() for a free list
+		double executeMs = 0.0;  // render thread replaying lists
+		double presentMs = 0.0;  // render thread swapping / pacing
+		double idleMs = 0.0;     // render thread waiting for a list
+		size_t commands = 0;     // last frame
+		size_t payloadBytes = 0; // last frame
+	};
+
+	explicit RenderThread(AppWindow& window) : window(window)
+	{
+	}
+
+	~RenderThread()
+	{
+		stop();
+	}
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	bool isRunning() const { return running; }
+
+	// Hand the context (current on the calling thread) to the render thread
+	// -------------------------------------------------------------------
+	bool start()
+	{
+		if (running)
+			return true;
+		submitted = 0;
+		completed = 0;
+		stopping = false;
+		started = false;
+		failed = false;
+		window.doneCurrent();
+		thread = std::thread(&RenderThread::threadLoop, this);
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this] { return started; });
+		}
+		if (failed)
+		{
+			std::cout << "ERROR::RENDER_THREAD::MAKE_CURRENT_FAILED" << std::endl;
+			thread.join();
+			window.makeCurrent();
+			return false;
+		}
+		running = true;
+		return true;
+	}
+
+	// The list to record the next frame into; waits while the render thread
+	// still replays the frame that used it before
+	// -------------------------------------------------------------------
+	RenderCommandList& beginFrame()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (submitted - completed >= LISTS)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			done.wait(lock, [this] { return submitted - completed < LISTS; });
+			stats.waitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+		RenderCommandList& list = lists[submitted % LISTS];
+		list.clear();
+		return list;
+	}
+
+	// Hand the recorded list to the render thread, as the window's current
+	// frame
+	// -------------------------------------------------------------------
+	void submit()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			frameIndices[submitted % LISTS] = window.getFrame();
+			submitted++;
+		}
+		work.notify_one();
+	}
+
+	// Wait until every submitted frame has been presented
+	// -------------------------------------------------------------------
+	void finish()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return completed == submitted; });
+	}
+
+	// Run 'task' on the render thread after the submitted frames and wait
+	// for it (creating, updating or deleting GL objects)
+	// -------------------------------------------------------------------
+	void invoke(std::function<void()> task)
+	{
+		if (!running)
+		{
+			task();
+			return;
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return completed == submitted; });
+		pendingTask = task;
+		hasTask = true;
+		work.notify_one();
+		done.wait(lock, [this] { return !hasTask; });
+	}
+
+	// Finish, end the thread and make the context current on the caller
+	// -------------------------------------------------------------------
+	void stop()
+	{
+		if (!running)
+			return;
+		finish();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		work.notify_one();
+		thread.join();
+		running = false;
+		window.makeCurrent();
+		// the render thread changed the bindings behind this thread's cache
+		GLState::instance().invalidate();
+	}
+
+	Stats getStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		Stats current = getStats();
+		double frames = current.frames > 0 ? (double)current.frames : 1.0;
+		std::cout << "RENDER_THREAD:: " << current.frames << " frames, per frame: main thread waited " << current.waitMs / frames
+			<< " ms, execute " << current.executeMs / frames << " ms, present " << current.presentMs / frames << " ms, idle "
+			<< current.idleMs / frames << " ms" << std::endl;
+		std::cout << "RENDER_THREAD:: last list: " << current.commands << " commands, " << current.payloadBytes << " payload bytes" << std::endl;
+	}
+
+	void resetStats()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stats = Stats();
+	}
+
+private:
+	AppWindow& window;
+	std::thread thread;
+	RenderCommandList lists[LISTS];
+	int frameIndices[LISTS] = {};
+	mutable std::mutex mutex;
+	std::condition_variable work; // to the render thread
+	std::condition_variable done; // to the main thread
+	unsigned long long submitted = 0;
+	unsigned long long completed = 0;
+	std::function<void()> pendingTask;
+	bool hasTask = false;
+	bool stopping = false;
+	bool started = false;
+	bool failed = false;
+	bool running = false;
+	Stats stats;
+
+	// -------------------------------------------------------------------
+	void threadLoop()
+	{
+		bool current = window.makeCurrent();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			started = true;
+			failed = !current;
+		}
+		done.notify_all();
+		if (!current)
+			return;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			std::chrono::steady_clock::time_point idleStart = std::chrono::steady_clock::now();
+			work.wait(lock, [this] { return stopping || hasTask || completed < submitted; });
+			stats.idleMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - idleStart).count();
+			if (hasTask)
+			{
+				std::function<void()> task = pendingTask;
+				lock.unlock();
+				task();
+				lock.lock();
+				pendingTask = NULL;
+				hasTask = false;
+				done.notify_all();
+			}
+			else if (completed < submitted)
+			{
+				// the main thread does not touch this list until completed moves on
+				const RenderCommandList& list = lists[completed % LISTS];
+				int frameIndex = frameIndices[completed % LISTS];
+				lock.unlock();
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				list.execute();
+				std::chrono::steady_clock::time_point executed = std::chrono::steady_clock::now();
+				window.present(frameIndex);
+				std::chrono::steady_clock::time_point presented = std::chrono::steady_clock::now();
+				lock.lock();
+				stats.executeMs += std::chrono::duration<double, std::milli>(executed - start).count();
+				stats.presentMs += std::chrono::duration<double, std::milli>(presented - executed).count();
+				stats.commands = list.commandCount();
+				stats.payloadBytes = list.payloadBytes();
+				stats.frames++;
+				completed++;
+				done.notify_all();
+			}
+			else if (stopping)
+			{
+				break;
+			}
+		}
+		lock.unlock();
+		window.doneCurrent();
+	}
+};
+#endif
@@ -0,0 +1,78 @@
+#ifndef SAMPLER_CACHE_H
+#define SAMPLER_CACHE_H
+
+#include <glad/glad.h>
+#include "gl_extensions.h"
+
+#include <map>
+#include <tuple>
+
+// Sampler Cache Declaration
+// Filtering and wrapping live in sampler objects (core since 3.3) shared by
+// every texture that wants the same state, instead of glTexParameteri on each
+// texture. Binding a sampler to a unit overrides the texture's own parameters.
+// Call clear() before the context goes away.
+
+class SamplerCache
+{
+public:
+	// Shared cache for the current context
+	// -------------------------------------------------------------------
+	static SamplerCache& instance()
+	{
+		static SamplerCache cache;
+		return cache;
+	}
+
+	// Sampler with the given state, created on first use. anisotropy > 1 is
+	// clamped to what the driver supports and ignored without the extension.
+	// -------------------------------------------------------------------
+	unsigned int get(GLint minFilter, GLint magFilter, GLint wrap, float anisotropy = 1.0f)
+	{
+		Key key(minFilter, magFilter, wrap, anisotropy);
+		std::map<Key, unsigned int>::const_iterator it = samplers.find(key);
+		if (it != samplers.end())
+			return it->second;
+
+		unsigned int sampler = 0;
+		glGenSamplers(1, &sampler);
+		glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter);
+		glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, wrap);
+		if (anisotropy > 1.0f && (GLExtensions::version(4, 6) || GLExtensions::has("GL_EXT_texture_filter_anisotropic") || GLExtensions::has("GL_ARB_texture_filter_anisotropic")))
+		{
+			GLfloat maximum = 1.0f;
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maximum);
+			glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy < maximum ? anisotropy : maximum);
+		}
+		samplers[key] = sampler;
+		return sampler;
+	}
+
+	// Trilinear sampler, the usual choice for mipmapped textures
+	// -------------------------------------------------------------------
+	unsigned int trilinear(GLint wrap = GL_REPEAT)
+	{
+		return get(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, wrap);
+	}
+
+	size_t size() const { return samplers.size(); }
+
+	// Delete every sampler. Call while the context is still current.
+	// -------------------------------------------------------------------
+	void clear()
+	{
+		for (std::map<Key, unsigned int>::iterator it = samplers.begin(); it != samplers.end(); ++it)
+		{
+			glDeleteSamplers(1, &it->second);
+		}
+		samplers.clear();
+	}
+
+private:
+	typedef std::tuple<GLint, GLint, GLint, float> Key;
+	std::map<Key, unsigned int> samplers;
+};
+#endif
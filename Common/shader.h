@@ -0,0 +1,427 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "program_cache.h"
+#include "shader_source.h"
+#include "gl_state.h"
+#include "uniform_blocks.h"
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <iostream>
+
+// Uniform handle: index into the Shader's reflected uniform table, -1 when
+// the uniform is not active in the program (setters ignore it like GL does)
+typedef int UniformHandle;
+
+// Shader Declaration
+
+class Shader 
+{
+public:
+	// the program ID
+	unsigned int ID;
+
+	// Uniform call counters: calls that reached the driver vs. calls skipped
+	// because the value matched the shadow copy
+	struct UniformStats
+	{
+		unsigned long long issued = 0;
+		unsigned long long skipped = 0;
+	};
+
+	// Shader Constuctor: Reads and builds relevant shaders
+	// 'defines' is a list like "USE_TEXTURE;LIGHTS=4" (see shader_source.h)
+	// -------------------------------------------------------------------
+	Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = "")
+		: vertexPath(vertexPath), fragmentPath(fragmentPath), defines(defines)
+	{
+		// 1. map the vertex/fragment source files and expand #includes
+		ShaderSourceCache& sources = ShaderSourceCache::instance();
+		ShaderSource vertexSource = sources.load(vertexPath, defines);
+		ShaderSource fragmentSource = sources.load(fragmentPath, defines);
+
+		// 2. reuse a cached program binary when the driver accepts it
+		ProgramCache& cache = ProgramCache::instance();
+		uint64_t cacheKey = cache.makeKey(vertexSource.getHash(), fragmentSource.getHash());
+		ID = glCreateProgram();
+		if (cache.load(cacheKey, ID))
+		{
+			reflectUniforms();
+			return;
+		}
+		// start from a fresh program object, a rejected binary can leave it unusable
+		glDeleteProgram(ID);
+		auto compileStart = std::chrono::steady_clock::now();
+
+		// 3. compile and link
+		ID = buildProgram(vertexSource, fragmentSource, cache.isSupported());
+		if (ID != 0)
+			cache.store(cacheKey, ID, ProgramCache::millisecondsSince(compileStart));
+
+		// 4. build the uniform table
+		reflectUniforms();
+	}
+
+	// Shader Constructor: adopts an already linked program (see ShaderLibrary)
+	// -------------------------------------------------------------------
+	Shader(unsigned int program, const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines = "")
+		: ID(program), vertexPath(vertexPath), fragmentPath(fragmentPath), defines(defines)
+	{
+		reflectUniforms();
+	}
+
+	// Shader Destructor: deletes the program, unless the window was closed
+	// first and the program went with the context
+	// -------------------------------------------------------------------
+	~Shader()
+	{
+		GLState& state = GLState::instance();
+		if (ID != 0 && state.hasContext())
+			state.deleteProgram(ID);
+	}
+
+	// Shader objects own their program, copying one would delete it twice
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+
+	// Source files this program was built from (used by ShaderWatcher)
+	const std::string& getVertexPath() const { return vertexPath; }
+	const std::string& getFragmentPath() const { return fragmentPath; }
+	const std::string& getDefines() const { return defines; }
+
+	// Compile both stages and link them. Returns 0 (after printing the
+	// logs) when compiling or linking fails. Only needs a current context,
+	// so it can also run on a worker thread with a shared context.
+	// -------------------------------------------------------------------
+	static unsigned int buildProgram(const ShaderSource& vertexSource, const ShaderSource& fragmentSource, bool retrievable)
+	{
+		if (!vertexSource.isValid() || !fragmentSource.isValid())
+			return 0;
+		unsigned int vertex;
+		unsigned int fragment;
+
+		// vertex shader
+		vertex = glCreateShader(GL_VERTEX_SHADER);
+		vertexSource.upload(vertex);
+		glCompileShader(vertex);
+		checkCompileErrors(vertex, "VERTEX");
+
+		// fragment shader
+		fragment = glCreateShader(GL_FRAGMENT_SHADER);
+		fragmentSource.upload(fragment);
+		glCompileShader(fragment);
+		checkCompileErrors(fragment, "FRAGMENT");
+
+		// shader program
+		unsigned int program = glCreateProgram();
+		if (retrievable)
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glAttachShader(program, vertex);
+		glAttachShader(program, fragment);
+		glLinkProgram(program);
+		bool linked = checkCompileErrors(program, "PROGRAM");
+		// delete shaders as they're linked into our program now and no longer necessary
+		glDeleteShader(vertex);
+		glDeleteShader(fragment);
+		if (!linked)
+		{
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	// Swap in a program built elsewhere (hot reload). Call between frames on
+	// the thread that renders. Uniform values set through this Shader are
+	// carried over to the new program where name and type still match.
+	// -------------------------------------------------------------------
+	void replaceProgram(unsigned int program)
+	{
+		std::vector<UniformSlot> previous;
+		previous.swap(uniforms);
+		unsigned int old = ID;
+		ID = program;
+		reflectUniforms();
+
+		GLState& state = GLState::instance();
+		GLuint current = state.getProgram();
+		state.useProgram(ID);
+		for (size_t i = 0; i < previous.size(); i++)
+		{
+			UniformHandle handle = getUniform(previous[i].name);
+			if (!previous[i].valid || handle < 0 || uniforms[handle].type != previous[i].type)
+				continue;
+			restoreUniform(uniforms[handle], previous[i].shadow);
+		}
+		state.useProgram(current == old ? ID : current);
+		state.deleteProgram(old);
+	}
+
+	// Shader Activation Function (skipped by GLState if already in use)
+	// -------------------------------------------------------------------
+	void use()
+	{
+		GLState::instance().useProgram(ID);
+	}
+
+	// Uniform Handle Lookup: do this once (e.g. before the render loop) and
+	// pass the handle to the setters below
+	// -------------------------------------------------------------------
+	UniformHandle getUniform(const std::string& name) const
+	{
+		for (size_t i = 0; i < uniforms.size(); i++)
+		{
+			if (uniforms[i].name == name)
+				return (UniformHandle)i;
+		}
+		return -1;
+	}
+
+	// GL location behind a handle (-1 if invalid), for code that sets the
+	// uniform itself, e.g. a RenderCommandList
+	// -------------------------------------------------------------------
+	GLint getLocation(UniformHandle handle) const
+	{
+		if (handle < 0 || handle >= (UniformHandle)uniforms.size())
+			return -1;
+		return uniforms[handle].location;
+	}
+
+	// Utility Uniform Functions
+	// The program must be in use, as with plain glUniform* calls. Values equal
+	// to the last one set through this Shader never reach the driver.
+	// -------------------------------------------------------------------
+	void setBool(UniformHandle handle, bool value)
+	{
+		setInt(handle, (int)value);
+	}
+	// -------------------------------------------------------------------
+	void setInt(UniformHandle handle, int value)
+	{
+		if (updateShadow(handle, &value, sizeof(value)))
+			glUniform1i(uniforms[handle].location, value);
+	}
+	// -------------------------------------------------------------------
+	void setFloat(UniformHandle handle, float value)
+	{
+		if (updateShadow(handle, &value, sizeof(value)))
+			glUniform1f(uniforms[handle].location, value);
+	}
+	// -------------------------------------------------------------------
+	void setVec2(UniformHandle handle, float x, float y)
+	{
+		float value[2] = { x, y };
+		if (updateShadow(handle, value, sizeof(value)))
+			glUniform2fv(uniforms[handle].location, 1, value);
+	}
+	// -------------------------------------------------------------------
+	void setVec3(UniformHandle handle, float x, float y, float z)
+	{
+		float value[3] = { x, y, z };
+		if (updateShadow(handle, value, sizeof(value)))
+			glUniform3fv(uniforms[handle].location, 1, value);
+	}
+	// -------------------------------------------------------------------
+	void setVec4(UniformHandle handle, float x, float y, float z, float w)
+	{
+		float value[4] = { x, y, z, w };
+		if (updateShadow(handle, value, sizeof(value)))
+			glUniform4fv(uniforms[handle].location, 1, value);
+	}
+	// -------------------------------------------------------------------
+	void setMat4(UniformHandle handle, const float* value)
+	{
+		if (updateShadow(handle, value, 16 * sizeof(float)))
+			glUniformMatrix4fv(uniforms[handle].location, 1, GL_FALSE, value);
+	}
+
+	// Name based setters (one table search per call, no driver round trip)
+	// -------------------------------------------------------------------
+	void setBool(const std::string& name, bool value)
+	{
+		setBool(getUniform(name), value);
+	}
+	// -------------------------------------------------------------------
+	void setInt(const std::string& name, int value)
+	{
+		setInt(getUniform(name), value);
+	}
+	// -------------------------------------------------------------------
+	void setFloat(const std::string& name, float value)
+	{
+		setFloat(getUniform(name), value);
+	}
+	// -------------------------------------------------------------------
+	void setMat4(const std::string& name, const float* value)
+	{
+		setMat4(getUniform(name), value);
+	}
+
+	const UniformStats& getUniformStats() const { return uniformStats; }
+	// -------------------------------------------------------------------
+	//void setVec2(const std::string& name, const glm::vec2& value) const
+	//{
+	//	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	//}
+	//void setVec2(const std::string& name, float x, float y) const
+	//{
+	//	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+	//}
+	//// ------------------------------------------------------------------------
+	//void setVec3(const std::string& name, const glm::vec3& value) const
+	//{
+	//	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	//}
+	//void setVec3(const std::string& name, float x, float y, float z) const
+	//{
+	//	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	//}
+	//// ------------------------------------------------------------------------
+	//void setVec4(const std::string& name, const glm::vec4& value) const
+	//{
+	//	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	//}
+	//void setVec4(const std::string& name, float x, float y, float z, float w)
+	//{
+	//	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+	//}
+	//// ------------------------------------------------------------------------
+	//void setMat2(const std::string& name, const glm::mat2& mat) const
+	//{
+	//	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	//}
+	//// ------------------------------------------------------------------------
+	//void setMat3(const std::string& name, const glm::mat3& mat) const
+	//{
+	//	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	//}
+	//// ------------------------------------------------------------------------
+	//void setMat4(const std::string& name, const glm::mat4& mat) const
+	//{
+	//	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	//}
+
+private:
+	// One entry per active uniform, with a CPU copy of the last value set
+	struct UniformSlot
+	{
+		std::string name;
+		GLint location;
+		GLenum type;
+		GLint size;
+		bool valid;
+		float shadow[16];
+	};
+	std::vector<UniformSlot> uniforms;
+	UniformStats uniformStats;
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::string defines;
+
+	// Query every active uniform once after linking
+	// -------------------------------------------------------------------
+	void reflectUniforms()
+	{
+		// shared uniform blocks (Camera, Frame ...) get their common binding points
+		UniformBlocks::instance().attach(ID);
+		uniforms.clear();
+		GLint count = 0;
+		GLint maxLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		std::vector<GLchar> nameBuffer(maxLength > 0 ? maxLength : 1);
+		for (GLint i = 0; i < count; i++)
+		{
+			UniformSlot slot;
+			GLsizei length = 0;
+			glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &slot.size, &slot.type, nameBuffer.data());
+			slot.name.assign(nameBuffer.data(), length);
+			slot.location = glGetUniformLocation(ID, slot.name.c_str());
+			// uniform block members have no location and are not set through here
+			if (slot.location < 0)
+				continue;
+			// arrays are reported as "name[0]", look them up by their plain name
+			if (slot.name.size() > 3 && slot.name.compare(slot.name.size() - 3, 3, "[0]") == 0)
+				slot.name.resize(slot.name.size() - 3);
+			slot.valid = false;
+			std::memset(slot.shadow, 0, sizeof(slot.shadow));
+			uniforms.push_back(slot);
+		}
+	}
+
+	// Returns true when the value differs from the shadow copy (and stores it)
+	// -------------------------------------------------------------------
+	bool updateShadow(UniformHandle handle, const void* value, size_t size)
+	{
+		if (handle < 0 || handle >= (UniformHandle)uniforms.size())
+			return false;
+		UniformSlot& slot = uniforms[handle];
+		if (slot.valid && std::memcmp(slot.shadow, value, size) == 0)
+		{
+			uniformStats.skipped++;
+			return false;
+		}
+		std::memcpy(slot.shadow, value, size);
+		slot.valid = true;
+		uniformStats.issued++;
+		return true;
+	}
+
+	// Re-issue a shadowed value on the (bound) new program
+	// -------------------------------------------------------------------
+	void restoreUniform(UniformSlot& slot, const float* value)
+	{
+		const GLint* ints = reinterpret_cast<const GLint*>(value);
+		switch (slot.type)
+		{
+		case GL_FLOAT:       glUniform1fv(slot.location, 1, value); break;
+		case GL_FLOAT_VEC2:  glUniform2fv(slot.location, 1, value); break;
+		case GL_FLOAT_VEC3:  glUniform3fv(slot.location, 1, value); break;
+		case GL_FLOAT_VEC4:  glUniform4fv(slot.location, 1, value); break;
+		case GL_FLOAT_MAT4:  glUniformMatrix4fv(slot.location, 1, GL_FALSE, value); break;
+		case GL_INT:
+		case GL_BOOL:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE: glUniform1iv(slot.location, 1, ints); break;
+		default: return;
+		}
+		std::memcpy(slot.shadow, value, sizeof(slot.shadow));
+		slot.valid = true;
+	}
+
+	friend class ShaderLibrary;
+
+	// Utility function for checking shader compilation/linking errors
+	// -------------------------------------------------------------------
+	static bool checkCompileErrors(GLuint shader, std::string type)
+	{
+		GLint success;
+		GLchar infoLog[1024];
+		if (type != "PROGRAM")
+		{
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+				std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n" << "***" << std::endl;
+			}
+		}
+		else
+		{
+			glGetProgramiv(shader, GL_LINK_STATUS, &success);
+			if (!success)
+			{
+				glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+				std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n" << "***" << std::endl;
+			}
+		}
+		return success != 0;
+	}
+};
+#endif
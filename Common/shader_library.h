@@ -0,0 +1,230 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include "shader.h"
+#include "gl_extensions.h"
+
+#include <map>
+#include <memory>
+#include <thread>
+
+// Shader Library Declaration
+// Builds many programs in one batch. Every compile and link is issued before
+// any status is queried, so the driver is free to work on them in parallel
+// (KHR_parallel_shader_compile makes that explicit: we ask for as many
+// compiler threads as it has and poll GL_COMPLETION_STATUS_KHR instead of
+// blocking). Status and logs are read only once everything was submitted.
+// Programs found in the ProgramCache skip compilation entirely.
+
+class ShaderLibrary
+{
+public:
+	// Results of the last build() (times are in milliseconds)
+	struct Stats
+	{
+		unsigned int programs = 0;
+		unsigned int cached = 0;
+		unsigned int failed = 0;
+		bool parallelExtension = false;
+		double submitTime = 0.0;
+		double totalTime = 0.0;
+	};
+
+	// Queue a program from files, optionally with defines ("A;B=2"), which
+	// is how shader variants share their mapped and expanded sources.
+	// Returns its index for get().
+	// -------------------------------------------------------------------
+	int add(const std::string& name, const char* vertexPath, const char* fragmentPath, const std::string& defines = "")
+	{
+		ShaderSourceCache& sources = ShaderSourceCache::instance();
+		Entry entry;
+		entry.name = name;
+		entry.vertexPath = vertexPath;
+		entry.fragmentPath = fragmentPath;
+		entry.defines = defines;
+		entry.vertexSource = sources.load(vertexPath, defines);
+		entry.fragmentSource = sources.load(fragmentPath, defines);
+		return push(entry);
+	}
+
+	// Queue a program from source strings (generated code etc.)
+	// -------------------------------------------------------------------
+	int addSource(const std::string& name, const std::string& vertexCode, const std::string& fragmentCode)
+	{
+		Entry entry;
+		entry.name = name;
+		entry.vertexSource = ShaderSource::fromString(vertexCode);
+		entry.fragmentSource = ShaderSource::fromString(fragmentCode);
+		return push(entry);
+	}
+
+	// Build everything queued since the last call
+	// -------------------------------------------------------------------
+	void build()
+	{
+		auto start = std::chrono::steady_clock::now();
+		stats = Stats();
+		ProgramCache& cache = ProgramCache::instance();
+
+		static PFNMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = NULL;
+		stats.parallelExtension = GLExtensions::has("GL_KHR_parallel_shader_compile") || GLExtensions::has("GL_ARB_parallel_shader_compile");
+		if (stats.parallelExtension && maxShaderCompilerThreads == NULL)
+		{
+			maxShaderCompilerThreads = (PFNMAXSHADERCOMPILERTHREADSKHRPROC)GLExtensions::getProcAddress("glMaxShaderCompilerThreadsKHR");
+			if (maxShaderCompilerThreads == NULL)
+				maxShaderCompilerThreads = (PFNMAXSHADERCOMPILERTHREADSKHRPROC)GLExtensions::getProcAddress("glMaxShaderCompilerThreadsARB");
+		}
+		if (maxShaderCompilerThreads != NULL)
+			maxShaderCompilerThreads(0xFFFFFFFF);
+
+		// 1. cache lookups, then issue every compile without checking it
+		std::vector<Entry*> pending;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			Entry& entry = entries[i];
+			if (entry.shader || !entry.vertexSource.isValid() || !entry.fragmentSource.isValid())
+				continue;
+			stats.programs++;
+			entry.cacheKey = cache.makeKey(entry.vertexSource.getHash(), entry.fragmentSource.getHash());
+			entry.program = glCreateProgram();
+			if (cache.load(entry.cacheKey, entry.program))
+			{
+				stats.cached++;
+				continue;
+			}
+			glDeleteProgram(entry.program);
+			entry.program = 0;
+
+			entry.vertex = glCreateShader(GL_VERTEX_SHADER);
+			entry.vertexSource.upload(entry.vertex);
+			glCompileShader(entry.vertex);
+			entry.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+			entry.fragmentSource.upload(entry.fragment);
+			glCompileShader(entry.fragment);
+			pending.push_back(&entry);
+		}
+
+		// 2. issue every link, still without checking anything
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			Entry& entry = *pending[i];
+			entry.program = glCreateProgram();
+			if (cache.isSupported())
+				glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glAttachShader(entry.program, entry.vertex);
+			glAttachShader(entry.program, entry.fragment);
+			glLinkProgram(entry.program);
+		}
+		stats.submitTime = ProgramCache::millisecondsSince(start);
+
+		// 3. with the extension, wait for completion without blocking in the driver
+		if (stats.parallelExtension)
+		{
+			size_t done = 0;
+			while (done < pending.size())
+			{
+				done = 0;
+				for (size_t i = 0; i < pending.size(); i++)
+				{
+					GLint complete = GL_FALSE;
+					glGetProgramiv(pending[i]->program, GL_COMPLETION_STATUS_KHR, &complete);
+					if (complete)
+						done++;
+				}
+				if (done < pending.size())
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+		}
+
+		// 4. now read status and logs
+		double buildTime = ProgramCache::millisecondsSince(start);
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			Entry& entry = *pending[i];
+			Shader::checkCompileErrors(entry.vertex, "VERTEX");
+			Shader::checkCompileErrors(entry.fragment, "FRAGMENT");
+			bool linked = Shader::checkCompileErrors(entry.program, "PROGRAM");
+			glDeleteShader(entry.vertex);
+			glDeleteShader(entry.fragment);
+			entry.vertex = 0;
+			entry.fragment = 0;
+			if (!linked)
+			{
+				std::cout << "ERROR::SHADER_LIBRARY::FAILED_TO_BUILD " << entry.name << std::endl;
+				glDeleteProgram(entry.program);
+				entry.program = 0;
+				stats.failed++;
+				continue;
+			}
+			// the batch shares one compile time, spread it over its programs
+			cache.store(entry.cacheKey, entry.program, buildTime / pending.size());
+		}
+
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			Entry& entry = entries[i];
+			if (!entry.shader && entry.program != 0)
+			{
+				entry.shader.reset(new Shader(entry.program, entry.vertexPath, entry.fragmentPath, entry.defines));
+				// the mapped sources are no longer needed
+				entry.vertexSource = ShaderSource();
+				entry.fragmentSource = ShaderSource();
+			}
+		}
+		stats.totalTime = ProgramCache::millisecondsSince(start);
+	}
+
+	// Lookup by index (from add) or by name; NULL if it failed to build
+	// -------------------------------------------------------------------
+	Shader* get(int index)
+	{
+		if (index < 0 || index >= (int)entries.size())
+			return NULL;
+		return entries[index].shader.get();
+	}
+	// -------------------------------------------------------------------
+	Shader* get(const std::string& name)
+	{
+		std::map<std::string, int>::const_iterator it = names.find(name);
+		return it == names.end() ? NULL : get(it->second);
+	}
+
+	size_t size() const { return entries.size(); }
+	const Stats& getStats() const { return stats; }
+
+	// Report the last build
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		std::cout << "SHADER_LIBRARY:: built " << stats.programs << " programs (" << stats.cached << " from cache, "
+			<< stats.failed << " failed) in " << stats.totalTime << " ms, submit: " << stats.submitTime << " ms"
+			<< (stats.parallelExtension ? ", parallel shader compile" : "") << std::endl;
+	}
+
+private:
+	struct Entry
+	{
+		std::string name;
+		std::string vertexPath;
+		std::string fragmentPath;
+		std::string defines;
+		ShaderSource vertexSource;
+		ShaderSource fragmentSource;
+		uint64_t cacheKey = 0;
+		unsigned int vertex = 0;
+		unsigned int fragment = 0;
+		unsigned int program = 0;
+		std::unique_ptr<Shader> shader;
+	};
+	std::vector<Entry> entries;
+	std::map<std::string, int> names;
+	Stats stats;
+
+	int push(Entry& entry)
+	{
+		names[entry.name] = (int)entries.size();
+		entries.push_back(std::move(entry));
+		return (int)entries.size() - 1;
+	}
+};
+#endif
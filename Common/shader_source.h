@@ -0,0 +1,425 @@
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <glad/glad.h>
+#include "mapped_file.h"
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <filesystem>
+
+// Shader Source Loading
+// Shader files are memory mapped and handed to glShaderSource as
+// pointer/length pairs, so the text is never copied on our side.
+// A small preprocessor runs first:
+//   #include "file"  pastes another file (relative to the including file,
+//                    each file at most once per shader)
+//   defines          "NAME;NAME=VALUE" strings become #define lines right
+//                    after #version
+// Expanded files are cached by content hash, so building many variants of
+// one shader (different defines) maps and expands its files only once.
+
+// 64-bit FNV-1a, continued from 'hash'
+// -------------------------------------------------------------------
+inline uint64_t hashSource(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// One shader stage ready for glShaderSource: a list of pieces that point
+// into mapped files plus the few generated lines (#define, #line)
+// -------------------------------------------------------------------
+class ShaderSource
+{
+public:
+	struct Piece
+	{
+		const char* text;
+		GLint length;
+	};
+
+	// Wrap text that did not come from a file
+	static ShaderSource fromString(const std::string& code)
+	{
+		ShaderSource source;
+		std::shared_ptr<std::string> text = std::make_shared<std::string>(code);
+		source.generated.push_back(text);
+		source.pieces.push_back(Piece{ text->data(), (GLint)text->size() });
+		source.hash = hashSource(code.data(), code.size());
+		source.valid = true;
+		return source;
+	}
+
+	// Hand the pieces to GL (no copy on our side)
+	void upload(GLuint shader) const
+	{
+		std::vector<const GLchar*> strings(pieces.size());
+		std::vector<GLint> lengths(pieces.size());
+		for (size_t i = 0; i < pieces.size(); i++)
+		{
+			strings[i] = pieces[i].text;
+			lengths[i] = pieces[i].length;
+		}
+		glShaderSource(shader, (GLsizei)pieces.size(), strings.data(), lengths.data());
+	}
+
+	// Flattened text (for logs and tools, not needed to compile)
+	std::string text() const
+	{
+		std::string result;
+		for (size_t i = 0; i < pieces.size(); i++)
+		{
+			result.append(pieces[i].text, pieces[i].length);
+		}
+		return result;
+	}
+
+	bool isValid() const { return valid; }
+	uint64_t getHash() const { return hash; }
+	const std::vector<std::string>& getFiles() const { return files; }
+
+private:
+	friend class ShaderSourceCache;
+
+	std::vector<Piece> pieces;
+	// keeps the mappings and generated lines the pieces point into alive
+	std::vector<std::shared_ptr<const void>> owners;
+	std::vector<std::shared_ptr<std::string>> generated;
+	std::vector<std::string> files;
+	uint64_t hash = 0;
+	bool valid = false;
+};
+
+// Cache of mapped files and expanded (include-resolved) translation units
+// -------------------------------------------------------------------
+class ShaderSourceCache
+{
+public:
+	struct Stats
+	{
+		unsigned int filesMapped = 0;
+		unsigned int unitsExpanded = 0;
+		unsigned int unitsReused = 0;
+	};
+
+	static ShaderSourceCache& instance()
+	{
+		static ShaderSourceCache cache;
+		return cache;
+	}
+
+	// Load 'path' with the given defines. Safe to call from several threads.
+	// -------------------------------------------------------------------
+	ShaderSource load(const std::string& path, const std::string& defines = "")
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ShaderSource source;
+		std::shared_ptr<Unit> unit = getUnit(path);
+		if (!unit)
+		{
+			std::cout << "ERROR::SHADER::FILE_FAILED_TO_READ " << path << std::endl;
+			return source;
+		}
+
+		source.owners.push_back(unit);
+		source.files = unit->files;
+		size_t first = 0;
+		if (unit->hasVersion)
+		{
+			source.pieces.push_back(unit->pieces[0]);
+			first = 1;
+		}
+		if (!defines.empty())
+		{
+			std::shared_ptr<std::string> text = std::make_shared<std::string>(defineLines(defines));
+			// keep compiler line numbers matching the file
+			*text += "#line " + std::to_string(unit->hasVersion ? 2 : 1) + " 0\n";
+			source.generated.push_back(text);
+			source.pieces.push_back(ShaderSource::Piece{ text->data(), (GLint)text->size() });
+		}
+		source.pieces.insert(source.pieces.end(), unit->pieces.begin() + first, unit->pieces.end());
+		source.hash = hashSource(defines.data(), defines.size(), unit->hash);
+		source.valid = true;
+		return source;
+	}
+
+	// Drop every mapping (e.g. before files are edited in place on Windows)
+	// -------------------------------------------------------------------
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		files.clear();
+		units.clear();
+	}
+
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct File
+	{
+		std::shared_ptr<MappedFile> mapping;
+		std::filesystem::file_time_type stamp;
+		uintmax_t size = 0;
+		uint64_t hash = 0;
+	};
+	struct Unit
+	{
+		std::vector<ShaderSource::Piece> pieces;
+		std::vector<std::shared_ptr<MappedFile>> mappings;
+		std::vector<std::shared_ptr<std::string>> generated;
+		std::vector<std::string> files;
+		std::vector<uint64_t> fileHashes;
+		bool hasVersion = false;
+		uint64_t hash = 0;
+	};
+
+	std::map<std::string, File> files;
+	std::map<std::string, std::shared_ptr<Unit>> units; // by canonical root path
+	std::mutex mutex;
+	Stats stats;
+
+	// Mapped file for 'path', remapped when its size or timestamp changed
+	// -------------------------------------------------------------------
+	File* getFile(const std::string& path)
+	{
+		std::error_code ec;
+		std::filesystem::file_time_type stamp = std::filesystem::last_write_time(path, ec);
+		uintmax_t size = ec ? 0 : std::filesystem::file_size(path, ec);
+		if (ec)
+			return NULL;
+
+		File& file = files[path];
+		if (file.mapping && file.stamp == stamp && file.size == size)
+			return &file;
+
+		std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(path);
+		if (!mapping->isOpen())
+		{
+			files.erase(path);
+			return NULL;
+		}
+		file.mapping = mapping;
+		file.stamp = stamp;
+		file.size = size;
+		file.hash = hashSource(mapping->data(), mapping->size());
+		stats.filesMapped++;
+		return &file;
+	}
+
+	// Expanded unit for a root file, reused while no file it touches changed.
+	// One unit per root: a re-expansion replaces the old one, and files no
+	// unit includes any more are unmapped, so hot reloading does not grow
+	// the cache (sources already handed out keep their own references).
+	// -------------------------------------------------------------------
+	std::shared_ptr<Unit> getUnit(const std::string& path)
+	{
+		// includes resolve relative to the file, so the location is the key
+		std::string canonical = canonicalPath(path);
+		std::map<std::string, std::shared_ptr<Unit>>::iterator it = units.find(canonical);
+		if (it != units.end() && isCurrent(*it->second))
+		{
+			stats.unitsReused++;
+			return it->second;
+		}
+		if (getFile(canonical) == NULL)
+			return NULL;
+
+		std::shared_ptr<Unit> unit = std::make_shared<Unit>();
+		unit->hash = 14695981039346656037ull;
+		bool expanded = expand(*unit, canonical, 0);
+		if (it != units.end())
+			units.erase(it);
+		if (expanded)
+		{
+			splitVersion(*unit);
+			units[canonical] = unit;
+			stats.unitsExpanded++;
+		}
+		dropUnusedFiles();
+		return expanded ? unit : NULL;
+	}
+
+	// Unmap files that no cached unit uses
+	// -------------------------------------------------------------------
+	void dropUnusedFiles()
+	{
+		std::map<std::string, File>::iterator it = files.begin();
+		while (it != files.end())
+		{
+			bool used = false;
+			for (std::map<std::string, std::shared_ptr<Unit>>::iterator unit = units.begin(); unit != units.end() && !used; ++unit)
+			{
+				const std::vector<std::string>& unitFiles = unit->second->files;
+				used = std::find(unitFiles.begin(), unitFiles.end(), it->first) != unitFiles.end();
+			}
+			if (used)
+				++it;
+			else
+				it = files.erase(it);
+		}
+	}
+
+	// Are all files of the unit unchanged?
+	// -------------------------------------------------------------------
+	bool isCurrent(const Unit& unit)
+	{
+		for (size_t i = 0; i < unit.files.size(); i++)
+		{
+			File* file = getFile(unit.files[i]);
+			if (file == NULL || file->hash != unit.fileHashes[i])
+				return false;
+		}
+		return true;
+	}
+
+	// Append 'path' to the unit, resolving #include lines recursively
+	// -------------------------------------------------------------------
+	bool expand(Unit& unit, const std::string& path, int depth)
+	{
+		for (size_t i = 0; i < unit.files.size(); i++)
+		{
+			// every file is pasted once per unit
+			if (unit.files[i] == path)
+				return true;
+		}
+		File* file = getFile(path);
+		if (file == NULL || depth > 32)
+		{
+			std::cout << "ERROR::SHADER::INCLUDE_FAILED " << path << std::endl;
+			return false;
+		}
+		std::shared_ptr<MappedFile> mapping = file->mapping;
+		int fileIndex = (int)unit.files.size();
+		unit.files.push_back(path);
+		unit.fileHashes.push_back(file->hash);
+		unit.mappings.push_back(mapping);
+		unit.hash = hashSource(&file->hash, sizeof(file->hash), unit.hash);
+
+		const char* begin = mapping->data();
+		const char* end = begin + mapping->size();
+		const char* pending = begin;
+		int line = 1;
+		for (const char* cursor = begin; cursor < end; line++)
+		{
+			const char* lineEnd = cursor;
+			while (lineEnd < end && *lineEnd != '\n')
+				lineEnd++;
+			const char* next = lineEnd < end ? lineEnd + 1 : end;
+
+			std::string included;
+			if (parseInclude(cursor, lineEnd, included))
+			{
+				addPiece(unit, pending, cursor);
+				std::string target = canonicalPath((std::filesystem::path(path).parent_path() / included).string());
+				addLine(unit, "#line 1 " + std::to_string(unit.files.size()) + "\n");
+				if (!expand(unit, target, depth + 1))
+					return false;
+				addLine(unit, "\n#line " + std::to_string(line + 1) + " " + std::to_string(fileIndex) + "\n");
+				pending = next;
+			}
+			cursor = next;
+		}
+		addPiece(unit, pending, end);
+		return true;
+	}
+
+	// Is [begin, end) an #include "file" line?
+	// -------------------------------------------------------------------
+	static bool parseInclude(const char* begin, const char* end, std::string& name)
+	{
+		while (begin < end && (*begin == ' ' || *begin == '\t'))
+			begin++;
+		if (end - begin < 8 || std::string(begin, 8) != "#include")
+			return false;
+		const char* open = begin + 8;
+		while (open < end && *open != '"')
+			open++;
+		const char* close = open + 1;
+		while (close < end && *close != '"')
+			close++;
+		if (open >= end || close >= end)
+			return false;
+		name.assign(open + 1, close);
+		return true;
+	}
+
+	// Pieces are split so the #version line can be followed by the defines
+	// -------------------------------------------------------------------
+	static void splitVersion(Unit& unit)
+	{
+		if (unit.pieces.empty())
+			return;
+		ShaderSource::Piece first = unit.pieces[0];
+		const char* begin = first.text;
+		const char* end = first.text + first.length;
+		while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r' || *begin == '\n'))
+			begin++;
+		if (end - begin < 8 || std::string(begin, 8) != "#version")
+			return;
+		const char* lineEnd = begin;
+		while (lineEnd < end && *lineEnd != '\n')
+			lineEnd++;
+		if (lineEnd < end)
+			lineEnd++;
+		ShaderSource::Piece version = { first.text, (GLint)(lineEnd - first.text) };
+		ShaderSource::Piece rest = { lineEnd, (GLint)(end - lineEnd) };
+		unit.pieces[0] = rest;
+		unit.pieces.insert(unit.pieces.begin(), version);
+		unit.hasVersion = true;
+	}
+
+	static void addPiece(Unit& unit, const char* begin, const char* end)
+	{
+		if (end > begin)
+			unit.pieces.push_back(ShaderSource::Piece{ begin, (GLint)(end - begin) });
+	}
+
+	static void addLine(Unit& unit, const std::string& line)
+	{
+		std::shared_ptr<std::string> text = std::make_shared<std::string>(line);
+		unit.generated.push_back(text);
+		unit.pieces.push_back(ShaderSource::Piece{ text->data(), (GLint)text->size() });
+	}
+
+	// "A;B=2" -> "#define A\n#define B 2\n"
+	// -------------------------------------------------------------------
+	static std::string defineLines(const std::string& defines)
+	{
+		std::string result;
+		size_t start = 0;
+		while (start < defines.size())
+		{
+			size_t stop = defines.find(';', start);
+			if (stop == std::string::npos)
+				stop = defines.size();
+			std::string define = defines.substr(start, stop - start);
+			size_t equals = define.find('=');
+			if (equals != std::string::npos)
+				define[equals] = ' ';
+			if (!define.empty())
+				result += "#define " + define + "\n";
+			start = stop + 1;
+		}
+		return result;
+	}
+
+	static std::string canonicalPath(const std::string& path)
+	{
+		std::error_code ec;
+		std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+		return ec ? path : canonical.string();
+	}
+};
+#endif
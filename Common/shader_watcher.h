@@ -0,0 +1,370 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include "shader.h"
+#include "app_window.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// Shader Watcher Declaration
+// Watches the source files of registered Shaders and rebuilds changed
+// programs on a worker thread that owns a second context sharing objects with
+// the main one (AppWindow::createSharedContext, windowed or headless). Finished programs are swapped into their Shader by
+// applyPending(), which the render loop calls once per frame and which never
+// waits on the compiler. A program that fails to build is thrown away and the
+// old one stays in use.
+// Uses inotify on Linux and polls file timestamps elsewhere.
+
+class ShaderWatcher
+{
+public:
+	// ShaderWatcher Constructor: must run on the main thread (GLFW creates
+	// windows there only) after the window's context exists
+	// -------------------------------------------------------------------
+	ShaderWatcher(AppWindow& window)
+	{
+		workerContext = window.createSharedContext();
+		if (!workerContext.valid())
+		{
+			std::cout << "ERROR::SHADER_WATCHER::FAILED_TO_CREATE_SHARED_CONTEXT" << std::endl;
+		}
+	}
+
+	~ShaderWatcher()
+	{
+		stop();
+	}
+
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	// Register a Shader (before start()). The Shader must outlive the watcher.
+	// -------------------------------------------------------------------
+	void watch(Shader& shader)
+	{
+		Entry entry;
+		entry.shader = &shader;
+		entry.vertexPath = shader.getVertexPath();
+		entry.fragmentPath = shader.getFragmentPath();
+		entry.defines = shader.getDefines();
+		// watch #included files as well
+		ShaderSourceCache& sources = ShaderSourceCache::instance();
+		entry.files = sources.load(entry.vertexPath, entry.defines).getFiles();
+		std::vector<std::string> fragmentFiles = sources.load(entry.fragmentPath, entry.defines).getFiles();
+		entry.files.insert(entry.files.end(), fragmentFiles.begin(), fragmentFiles.end());
+		entry.stamp = currentStamp(entry);
+		entries.push_back(entry);
+	}
+
+	// Start the worker thread
+	// -------------------------------------------------------------------
+	void start()
+	{
+		if (!workerContext.valid() || running)
+			return;
+		running = true;
+		worker = std::thread(&ShaderWatcher::run, this);
+	}
+
+	// Stop the worker and release its context. Call before AppWindow::close().
+	// -------------------------------------------------------------------
+	void stop()
+	{
+		running = false;
+		if (worker.joinable())
+			worker.join();
+		for (size_t i = 0; i < ready.size(); i++)
+		{
+			glDeleteProgram(ready[i].program);
+		}
+		ready.clear();
+		workerContext.release();
+	}
+
+	// Swap finished programs into their Shaders. Call at a frame boundary on
+	// the rendering thread; returns how many programs were replaced.
+	// -------------------------------------------------------------------
+	int applyPending()
+	{
+		std::vector<Ready> swapped;
+		{
+			// skip this frame rather than wait if the worker holds the lock
+			std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+			if (!lock.owns_lock() || ready.empty())
+				return 0;
+			swapped.swap(ready);
+		}
+		for (size_t i = 0; i < swapped.size(); i++)
+		{
+			swapped[i].shader->replaceProgram(swapped[i].program);
+		}
+		return (int)swapped.size();
+	}
+
+private:
+	struct Entry
+	{
+		Shader* shader;
+		std::string vertexPath;
+		std::string fragmentPath;
+		std::string defines;
+		std::vector<std::string> files;
+		std::filesystem::file_time_type stamp;
+		bool changed = false;
+	};
+	struct Ready
+	{
+		Shader* shader;
+		unsigned int program;
+	};
+
+	AppWindow::SharedContext workerContext;
+	std::vector<Entry> entries;
+	std::vector<Ready> ready;
+	std::mutex mutex;
+	std::thread worker;
+	std::atomic<bool> running{ false };
+#ifdef __linux__
+	// worker thread only
+	int notifyFd = -1;
+	std::vector<std::pair<int, std::filesystem::path>> directories;
+#endif
+
+	// Worker thread body
+	// -------------------------------------------------------------------
+	void run()
+	{
+		workerContext.makeCurrent();
+#ifdef __linux__
+		notifyFd = inotify_init1(IN_NONBLOCK);
+		updateWatches();
+#endif
+		while (running)
+		{
+#ifdef __linux__
+			bool changed = waitForEvents();
+#else
+			bool changed = pollStamps();
+#endif
+			if (!changed)
+				continue;
+			// editors often save in several writes, let them finish
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+#ifdef __linux__
+			waitForEvents();
+#endif
+			bool dependenciesChanged = false;
+			for (size_t i = 0; i < entries.size(); i++)
+			{
+				if (entries[i].changed)
+				{
+					entries[i].changed = false;
+					if (rebuild(entries[i]))
+						dependenciesChanged = true;
+				}
+			}
+#ifdef __linux__
+			if (dependenciesChanged)
+				updateWatches();
+#endif
+		}
+#ifdef __linux__
+		close(notifyFd);
+		notifyFd = -1;
+		directories.clear();
+#endif
+		workerContext.doneCurrent();
+	}
+
+	// Compile one program on the worker context and queue it for the swap.
+	// Returns true if the entry's set of files changed.
+	// -------------------------------------------------------------------
+	bool rebuild(Entry& entry)
+	{
+		auto start = std::chrono::steady_clock::now();
+		ShaderSourceCache& sources = ShaderSourceCache::instance();
+		ShaderSource vertexSource = sources.load(entry.vertexPath, entry.defines);
+		ShaderSource fragmentSource = sources.load(entry.fragmentPath, entry.defines);
+		bool dependenciesChanged = false;
+		if (vertexSource.isValid() && fragmentSource.isValid())
+		{
+			// the edit may have added or removed #includes
+			std::vector<std::string> files = vertexSource.getFiles();
+			files.insert(files.end(), fragmentSource.getFiles().begin(), fragmentSource.getFiles().end());
+			if (files != entry.files)
+			{
+				entry.files = files;
+				entry.stamp = currentStamp(entry);
+				dependenciesChanged = true;
+			}
+		}
+		unsigned int program = Shader::buildProgram(vertexSource, fragmentSource, false);
+		if (program == 0)
+		{
+			std::cout << "SHADER_WATCHER:: keeping previous program for " << entry.vertexPath << " / " << entry.fragmentPath << std::endl;
+			return dependenciesChanged;
+		}
+		// the program has to be complete before the other context uses it
+		glFinish();
+		std::cout << "SHADER_WATCHER:: rebuilt " << entry.vertexPath << " / " << entry.fragmentPath
+			<< " in " << ProgramCache::millisecondsSince(start) << " ms" << std::endl;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t i = 0; i < ready.size(); i++)
+		{
+			// a newer build supersedes one that was never applied
+			if (ready[i].shader == entry.shader)
+			{
+				glDeleteProgram(ready[i].program);
+				ready[i].program = program;
+				return dependenciesChanged;
+			}
+		}
+		Ready item;
+		item.shader = entry.shader;
+		item.program = program;
+		ready.push_back(item);
+		return dependenciesChanged;
+	}
+
+	// Flag entries that use 'path'; returns false if none do
+	// -------------------------------------------------------------------
+	bool markChanged(const std::filesystem::path& path)
+	{
+		bool found = false;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			for (size_t j = 0; j < entries[i].files.size(); j++)
+			{
+				std::error_code ec;
+				if (std::filesystem::equivalent(path, entries[i].files[j], ec))
+				{
+					entries[i].changed = true;
+					found = true;
+				}
+			}
+		}
+		return found;
+	}
+
+#ifdef __linux__
+	// Watch the directory of every file the entries use (editors often
+	// replace files rather than write them) and drop watches on directories
+	// no file needs any more, e.g. after an #include was added or removed
+	// -------------------------------------------------------------------
+	void updateWatches()
+	{
+		std::vector<std::filesystem::path> needed;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			for (size_t j = 0; j < entries[i].files.size(); j++)
+			{
+				std::filesystem::path directory = std::filesystem::absolute(entries[i].files[j]).parent_path();
+				if (std::find(needed.begin(), needed.end(), directory) == needed.end())
+					needed.push_back(directory);
+			}
+		}
+		for (size_t i = 0; i < directories.size();)
+		{
+			if (std::find(needed.begin(), needed.end(), directories[i].second) == needed.end())
+			{
+				inotify_rm_watch(notifyFd, directories[i].first);
+				directories.erase(directories.begin() + i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+		for (size_t i = 0; i < needed.size(); i++)
+		{
+			bool watched = false;
+			for (size_t j = 0; j < directories.size() && !watched; j++)
+			{
+				watched = directories[j].second == needed[i];
+			}
+			if (watched)
+				continue;
+			int wd = inotify_add_watch(notifyFd, needed[i].c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+			if (wd >= 0)
+				directories.push_back(std::make_pair(wd, needed[i]));
+		}
+	}
+
+	// Wait up to 100 ms for inotify events; returns true if a watched file changed
+	// -------------------------------------------------------------------
+	bool waitForEvents()
+	{
+		pollfd descriptor;
+		descriptor.fd = notifyFd;
+		descriptor.events = POLLIN;
+		if (poll(&descriptor, 1, 100) <= 0)
+			return false;
+
+		alignas(inotify_event) char buffer[4096];
+		bool changed = false;
+		ssize_t length;
+		while ((length = read(notifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+				if (event->len == 0)
+					continue;
+				for (size_t i = 0; i < directories.size(); i++)
+				{
+					if (directories[i].first == event->wd && markChanged(directories[i].second / event->name))
+						changed = true;
+				}
+			}
+		}
+		return changed;
+	}
+#endif
+
+	// Timestamp fallback for platforms without inotify
+	// -------------------------------------------------------------------
+	bool pollStamps()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		bool changed = false;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			std::filesystem::file_time_type stamp = currentStamp(entries[i]);
+			if (stamp != entries[i].stamp)
+			{
+				entries[i].stamp = stamp;
+				entries[i].changed = true;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	// Newest modification time of the entry's files
+	// -------------------------------------------------------------------
+	static std::filesystem::file_time_type currentStamp(const Entry& entry)
+	{
+		std::filesystem::file_time_type newest = std::filesystem::file_time_type::min();
+		for (size_t i = 0; i < entry.files.size(); i++)
+		{
+			std::error_code ec;
+			std::filesystem::file_time_type stamp = std::filesystem::last_write_time(entry.files[i], ec);
+			if (!ec && stamp > newest)
+				newest = stamp;
+		}
+		return newest;
+	}
+};
+#endif
@@ -0,0 +1,601 @@
+#ifndef TEXTURE_PACKER_H
+#define TEXTURE_PACKER_H
+
+#include <glad/glad.h>
+#include "gl_state.h"
+#include "image_resample.h"
+#include "job_system.h"
+#include "sampler_cache.h"
+#include "stb_image.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+// Texture Packer Declaration
+// Packs same-format textures into one GL_TEXTURE_2D_ARRAY so a whole scene
+// samples them through a single bind (plus one shared sampler object).
+//   ARRAY  one texture per layer. Layers take the size of the largest
+//          texture; smaller ones sit in the corner and the rest of the layer
+//          repeats their edge texels.
+//   ATLAS  textures are shelf packed into pageSize x pageSize layers with
+//          'padding' texels of repeated edge around each one. Regions start
+//          on multiples of the padding and the mip chain stops where the
+//          padding would shrink below one texel, so mips never bleed.
+// Every texture gets a Region: sample layer 'layer' at uv * scale + offset.
+// Only ARRAY mode with equal sizes can use GL_REPEAT outside 0..1.
+// Sizes are planned from the file headers (stbi_info), images are decoded and
+// their layers composed and mipmapped (ImageResample) on worker threads.
+// stbi_set_flip_vertically_on_load is honoured as set before build().
+// build() returns once everything is uploaded. buildAsync() plans and
+// allocates only, so the regions are known at once, and decodes the layers
+// in the background; call update() once per frame to upload the finished
+// ones. Layers show a grey placeholder until then.
+
+class TexturePacker
+{
+public:
+	enum Mode
+	{
+		ARRAY,
+		ATLAS
+	};
+
+	struct Settings
+	{
+		Mode mode = ARRAY;
+		int channels = 4;       // every texture is converted to this
+		int pageSize = 2048;    // ATLAS layer size (clamped to GL_MAX_TEXTURE_SIZE)
+		int padding = 8;        // ATLAS texels around each texture
+		bool srgb = false;      // GL_SRGB8(_ALPHA8) storage and linear filtering
+		GLint wrap = GL_REPEAT; // wrap mode of the shared sampler
+	};
+
+	// Where a texture ended up
+	struct Region
+	{
+		int layer = 0;
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+		float scale[2] = { 1.0f, 1.0f };
+		float offset[2] = { 0.0f, 0.0f };
+		bool valid = false;
+	};
+
+	struct Stats
+	{
+		unsigned int textures = 0;
+		unsigned int failed = 0;
+		unsigned int layers = 0;
+		unsigned int levels = 0;
+		unsigned long long usedTexels = 0;    // texels of the packed images
+		unsigned long long paddingTexels = 0; // edge copies around them
+		unsigned long long totalTexels = 0;   // level 0 of every layer
+		unsigned long long bytes = 0;         // every level of every layer
+		double buildTime = 0.0;
+
+		double occupancy() const { return totalTexels ? (double)usedTexels / totalTexels : 0.0; }
+		unsigned long long wastedTexels() const { return totalTexels - usedTexels; }
+	};
+
+	// TexturePacker Constructor
+	// -------------------------------------------------------------------
+	TexturePacker()
+		: TexturePacker(Settings())
+	{
+	}
+	// -------------------------------------------------------------------
+	TexturePacker(const Settings& settings)
+		: settings(settings)
+	{
+	}
+
+	~TexturePacker()
+	{
+		// the layer jobs point into this object
+		waitForJobs();
+	}
+
+	TexturePacker(const TexturePacker&) = delete;
+	TexturePacker& operator=(const TexturePacker&) = delete;
+
+	// Queue an image file; returns its index for getRegion()
+	// -------------------------------------------------------------------
+	int add(const std::string& path)
+	{
+		Entry entry;
+		entry.path = path;
+		entries.push_back(entry);
+		return (int)entries.size() - 1;
+	}
+
+	// Plan the layout, decode, compose and upload everything queued.
+	// Needs a current context; returns false if nothing could be packed.
+	// -------------------------------------------------------------------
+	bool build()
+	{
+		if (!plan())
+			return false;
+		composeAndUpload(stats.levels);
+		finish();
+		return true;
+	}
+
+	// Plan the layout and allocate the array now, decode and compose the
+	// layers on the JobSystem workers; update() uploads them. Needs a
+	// current context; returns false if nothing can be packed.
+	// -------------------------------------------------------------------
+	bool buildAsync()
+	{
+		if (!plan())
+			return false;
+		fillPlaceholder(stats.levels);
+		for (size_t i = 0; i < layers.size(); i++)
+		{
+			streaming.push_back(std::unique_ptr<PendingLayer>(new PendingLayer()));
+		}
+		nextJob = 0;
+		uploaded = 0;
+		update();
+		return true;
+	}
+
+	// Upload the layers whose jobs finished and start new ones, at most one
+	// per worker at a time (bounds the decoded memory). Once per frame.
+	// -------------------------------------------------------------------
+	void update()
+	{
+		if (streaming.empty())
+			return;
+		JobSystem& jobs = JobSystem::instance();
+		size_t running = 0;
+		for (size_t i = uploaded; i < nextJob; i++)
+		{
+			PendingLayer& layer = *streaming[i];
+			if (!layer.done && JobSystem::isDone(layer.job))
+			{
+				uploadLayer((GLint)i, layer.pixels, layer.mips, stats.levels);
+				layer.done = true;
+				layer.job = NULL;
+				layer.pixels = std::vector<unsigned char>();
+				layer.mips.clear();
+			}
+			if (!layer.done)
+				running++;
+		}
+		while (uploaded < nextJob && streaming[uploaded]->done)
+		{
+			uploaded++;
+		}
+		while (nextJob < layers.size() && running < jobs.threadCount())
+		{
+			PendingLayer* layer = streaming[nextJob].get();
+			size_t index = nextJob;
+			layer->job = jobs.submit([this, layer, index]()
+			{
+				composeAndMip(layers[index], layer->pixels, layer->mips);
+			});
+			nextJob++;
+			running++;
+		}
+		if (uploaded == layers.size())
+		{
+			streaming.clear();
+			finish();
+		}
+	}
+
+	// Every layer uploaded (always true after build())
+	bool isComplete() const { return streaming.empty(); }
+
+	// Bind the array and the shared sampler to a texture unit
+	// -------------------------------------------------------------------
+	void bind(unsigned int unit) const
+	{
+		GLState& state = GLState::instance();
+		state.bindTexture(unit, GL_TEXTURE_2D_ARRAY, texture);
+		state.bindSampler(unit, sampler);
+	}
+
+	const Region& getRegion(int index) const { return entries[index].region; }
+	unsigned int getTexture() const { return texture; }
+	unsigned int getSampler() const { return sampler; }
+	const Stats& getStats() const { return stats; }
+
+	// Report occupancy and wasted texels
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		std::cout << "TEXTURE_PACKER:: " << (settings.mode == ATLAS ? "atlas" : "array") << " " << layerWidth << "x" << layerHeight
+			<< " x " << stats.layers << " layers, " << stats.levels << " levels, " << stats.textures - stats.failed << "/" << stats.textures
+			<< " textures, " << stats.bytes / 1024 << " KB in " << stats.buildTime << " ms\n"
+			<< "TEXTURE_PACKER:: occupancy: " << stats.occupancy() * 100.0 << "%, wasted texels: " << stats.wastedTexels()
+			<< " (padding: " << stats.paddingTexels << ")" << std::endl;
+	}
+
+	// Delete the array. Call while the context is still current (the sampler
+	// belongs to SamplerCache).
+	// -------------------------------------------------------------------
+	void release()
+	{
+		waitForJobs();
+		streaming.clear();
+		if (texture)
+			GLState::instance().deleteTexture(texture);
+		texture = 0;
+	}
+
+private:
+	struct Entry
+	{
+		std::string path;
+		Region region;
+	};
+	// Entries placed on one layer
+	struct Layer
+	{
+		std::vector<int> entries;
+	};
+	// A layer of buildAsync() on its way in
+	struct PendingLayer
+	{
+		JobSystem::Handle job;
+		std::vector<unsigned char> pixels;
+		std::vector<ImageResample::MipLevel> mips;
+		bool done = false;
+	};
+
+	Settings settings;
+	Stats stats;
+	std::vector<Entry> entries;
+	std::vector<Layer> layers;
+	int layerWidth = 0;
+	int layerHeight = 0;
+	unsigned int texture = 0;
+	unsigned int sampler = 0;
+	std::atomic<unsigned long long> paddingTexels{ 0 };
+	std::vector<std::unique_ptr<PendingLayer>> streaming;
+	size_t nextJob = 0;  // layers handed to the workers
+	size_t uploaded = 0; // layers uploaded, in order
+	std::chrono::steady_clock::time_point buildStart;
+
+	// -------------------------------------------------------------------
+	void waitForJobs()
+	{
+		for (size_t i = 0; i < streaming.size(); i++)
+		{
+			JobSystem::instance().wait(streaming[i]->job);
+		}
+	}
+
+	// Read the image headers, lay out the layers and allocate the array
+	// -------------------------------------------------------------------
+	bool plan()
+	{
+		buildStart = std::chrono::steady_clock::now();
+		stats = Stats();
+		stats.textures = (unsigned int)entries.size();
+		release();
+		layers.clear();
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			entries[i].region = Region();
+		}
+		if (settings.channels < 3 || settings.channels > 4)
+			settings.channels = 4;
+		// power of two padding keeps regions aligned to every mip level we keep
+		int padding = 1;
+		while (padding < settings.padding)
+			padding *= 2;
+		settings.padding = settings.padding > 0 ? padding : 0;
+
+		GLint maxSize = 0;
+		GLint maxLayers = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			int components = 0;
+			Entry& entry = entries[i];
+			if (!stbi_info(entry.path.c_str(), &entry.region.width, &entry.region.height, &components))
+			{
+				std::cout << "Failed to load texture " << entry.path << std::endl;
+			}
+		}
+		if (settings.mode == ATLAS)
+			planAtlas(std::min(settings.pageSize, (int)maxSize));
+		else
+			planArray((int)maxSize);
+		if (layers.empty() || (GLint)layers.size() > maxLayers)
+		{
+			if (!layers.empty())
+				std::cout << "ERROR::TEXTURE_PACKER::TOO_MANY_LAYERS " << layers.size() << std::endl;
+			return false;
+		}
+
+		// mips stop once the padding would shrink below one texel
+		int levels = 1;
+		while ((layerWidth >> levels) > 0 || (layerHeight >> levels) > 0)
+		{
+			if (settings.mode == ATLAS && (settings.padding >> levels) < 1)
+				break;
+			levels++;
+		}
+		stats.layers = (unsigned int)layers.size();
+		stats.levels = levels;
+
+		allocate(levels);
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			Region& region = entries[i].region;
+			if (!region.valid)
+				continue;
+			region.scale[0] = (float)region.width / layerWidth;
+			region.scale[1] = (float)region.height / layerHeight;
+			region.offset[0] = (float)region.x / layerWidth;
+			region.offset[1] = (float)region.y / layerHeight;
+		}
+		return true;
+	}
+
+	// Stats once every layer is in (decoding may have failed some regions)
+	// -------------------------------------------------------------------
+	void finish()
+	{
+		stats.paddingTexels = paddingTexels.exchange(0);
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			const Region& region = entries[i].region;
+			if (!region.valid)
+			{
+				stats.failed++;
+				continue;
+			}
+			stats.usedTexels += (unsigned long long)region.width * region.height;
+		}
+		stats.totalTexels = (unsigned long long)layerWidth * layerHeight * layers.size();
+		stats.buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+	}
+
+	// ARRAY: one texture per layer, layers as large as the largest texture
+	// -------------------------------------------------------------------
+	void planArray(int maxSize)
+	{
+		layerWidth = 0;
+		layerHeight = 0;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			Region& region = entries[i].region;
+			if (region.width <= 0 || region.height <= 0)
+				continue;
+			if (region.width > maxSize || region.height > maxSize)
+			{
+				std::cout << "ERROR::TEXTURE_PACKER::TOO_LARGE " << entries[i].path << std::endl;
+				continue;
+			}
+			layerWidth = std::max(layerWidth, region.width);
+			layerHeight = std::max(layerHeight, region.height);
+			region.layer = (int)layers.size();
+			region.valid = true;
+			layers.push_back(Layer());
+			layers.back().entries.push_back((int)i);
+		}
+	}
+
+	// ATLAS: shelf packing, tallest first, a new layer when a shelf does not fit
+	// -------------------------------------------------------------------
+	void planAtlas(int pageSize)
+	{
+		layerWidth = pageSize;
+		layerHeight = pageSize;
+		int padding = std::max(0, settings.padding);
+		int align = std::max(1, padding);
+		std::vector<int> order;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			const Region& region = entries[i].region;
+			if (region.width <= 0 || region.height <= 0)
+				continue;
+			if (region.width + 2 * padding > pageSize || region.height + 2 * padding > pageSize)
+			{
+				std::cout << "ERROR::TEXTURE_PACKER::TOO_LARGE " << entries[i].path << std::endl;
+				continue;
+			}
+			order.push_back((int)i);
+		}
+		std::stable_sort(order.begin(), order.end(), [this](int a, int b) { return entries[a].region.height > entries[b].region.height; });
+
+		int x = 0;
+		int y = 0;
+		int shelfHeight = 0;
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			Region& region = entries[order[i]].region;
+			int width = roundUp(region.width + 2 * padding, align);
+			int height = roundUp(region.height + 2 * padding, align);
+			if (x + width > pageSize)
+			{
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
+			if (layers.empty() || y + height > pageSize)
+			{
+				layers.push_back(Layer());
+				x = 0;
+				y = 0;
+				shelfHeight = 0;
+			}
+			region.layer = (int)layers.size() - 1;
+			region.x = x + padding;
+			region.y = y + padding;
+			region.valid = true;
+			layers.back().entries.push_back(order[i]);
+			x += width;
+			shelfHeight = std::max(shelfHeight, height);
+		}
+	}
+
+	static int roundUp(int value, int multiple)
+	{
+		return (value + multiple - 1) / multiple * multiple;
+	}
+
+	// Storage for every level of every layer
+	// -------------------------------------------------------------------
+	void allocate(int levels)
+	{
+		GLenum format = settings.channels == 4 ? GL_RGBA : GL_RGB;
+		GLint internalFormat = settings.channels == 4 ? (settings.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8) : (settings.srgb ? GL_SRGB8 : GL_RGB8);
+		GLState& state = GLState::instance();
+		glGenTextures(1, &texture);
+		state.bindTextureForEdit(GL_TEXTURE_2D_ARRAY, texture);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		for (int level = 0; level < levels; level++)
+		{
+			int width = std::max(1, layerWidth >> level);
+			int height = std::max(1, layerHeight >> level);
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, width, height, (GLsizei)layers.size(), 0, format, GL_UNSIGNED_BYTE, NULL);
+			stats.bytes += (unsigned long long)width * height * layers.size() * settings.channels;
+		}
+
+		GLint minFilter = levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+		sampler = SamplerCache::instance().get(minFilter, GL_LINEAR, settings.mode == ATLAS ? GL_CLAMP_TO_EDGE : settings.wrap);
+	}
+
+	// Decode and compose layers on the JobSystem workers, a batch at a time (to bound
+	// memory), and upload each finished batch from this thread
+	// -------------------------------------------------------------------
+	void composeAndUpload(int levels)
+	{
+		JobSystem& jobs = JobSystem::instance();
+		unsigned int threads = jobs.threadCount();
+		for (size_t first = 0; first < layers.size(); first += threads)
+		{
+			size_t count = std::min((size_t)threads, layers.size() - first);
+			std::vector<std::vector<unsigned char>> pixels(count);
+			std::vector<std::vector<ImageResample::MipLevel>> mips(count);
+			jobs.parallelFor(count, 1, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					composeAndMip(layers[first + i], pixels[i], mips[i]);
+				}
+			});
+
+			for (size_t i = 0; i < count; i++)
+			{
+				uploadLayer((GLint)(first + i), pixels[i], mips[i], levels);
+			}
+		}
+	}
+
+	// Compose a layer and build its mip chain (worker thread)
+	// -------------------------------------------------------------------
+	void composeAndMip(const Layer& layer, std::vector<unsigned char>& pixels, std::vector<ImageResample::MipLevel>& mips)
+	{
+		composeLayer(layer, pixels);
+		ImageResample::Options options;
+		options.srgb = settings.srgb;
+		options.threads = 1;
+		mips = ImageResample::buildMipChain(pixels.data(), layerWidth, layerHeight, settings.channels, options);
+	}
+
+	// -------------------------------------------------------------------
+	void uploadLayer(GLint layer, const std::vector<unsigned char>& pixels, const std::vector<ImageResample::MipLevel>& mips, int levels)
+	{
+		GLenum format = settings.channels == 4 ? GL_RGBA : GL_RGB;
+		GLState& state = GLState::instance();
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 1);
+		state.bindTextureForEdit(GL_TEXTURE_2D_ARRAY, texture);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, layerWidth, layerHeight, 1, format, GL_UNSIGNED_BYTE, pixels.data());
+		for (int level = 1; level < levels && level <= (int)mips.size(); level++)
+		{
+			const ImageResample::MipLevel& mip = mips[level - 1];
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.width, mip.height, 1, format, GL_UNSIGNED_BYTE, mip.pixels.data());
+		}
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	// Grey in every level of every layer until buildAsync() uploads it (the
+	// storage is undefined otherwise)
+	// -------------------------------------------------------------------
+	void fillPlaceholder(int levels)
+	{
+		GLenum format = settings.channels == 4 ? GL_RGBA : GL_RGB;
+		std::vector<unsigned char> grey((size_t)layerWidth * layerHeight * settings.channels, 128);
+		GLState& state = GLState::instance();
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 1);
+		state.bindTextureForEdit(GL_TEXTURE_2D_ARRAY, texture);
+		for (int level = 0; level < levels; level++)
+		{
+			int width = std::max(1, layerWidth >> level);
+			int height = std::max(1, layerHeight >> level);
+			for (size_t layer = 0; layer < layers.size(); layer++)
+			{
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, (GLint)layer, width, height, 1, format, GL_UNSIGNED_BYTE, grey.data());
+			}
+		}
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	// Decode the layer's images into it and fill their padding with edge texels
+	// (worker thread; only touches this layer and its own entries)
+	// -------------------------------------------------------------------
+	void composeLayer(const Layer& layer, std::vector<unsigned char>& pixels)
+	{
+		const int channels = settings.channels;
+		pixels.assign((size_t)layerWidth * layerHeight * channels, 0);
+		for (size_t e = 0; e < layer.entries.size(); e++)
+		{
+			Entry& entry = entries[layer.entries[e]];
+			Region& region = entry.region;
+			int width, height, components;
+			unsigned char* image = stbi_load(entry.path.c_str(), &width, &height, &components, channels);
+			if (image == NULL || width != region.width || height != region.height)
+			{
+				std::cout << "Failed to load texture " << entry.path << std::endl;
+				if (image)
+					stbi_image_free(image);
+				region.valid = false;
+				continue;
+			}
+
+			// ARRAY layers belong to one image, so its edges fill the whole layer
+			int padding = settings.mode == ATLAS ? settings.padding : std::max(layerWidth, layerHeight);
+			int x0 = std::max(0, region.x - padding);
+			int y0 = std::max(0, region.y - padding);
+			int x1 = std::min(layerWidth, region.x + width + padding);
+			int y1 = std::min(layerHeight, region.y + height + padding);
+			for (int y = y0; y < y1; y++)
+			{
+				int sourceY = std::min(height - 1, std::max(0, y - region.y));
+				const unsigned char* source = image + (size_t)sourceY * width * channels;
+				unsigned char* target = &pixels[((size_t)y * layerWidth) * channels];
+				for (int x = x0; x < region.x; x++)
+				{
+					std::memcpy(target + (size_t)x * channels, source, channels);
+				}
+				std::memcpy(target + (size_t)region.x * channels, source, (size_t)width * channels);
+				for (int x = region.x + width; x < x1; x++)
+				{
+					std::memcpy(target + (size_t)x * channels, source + (size_t)(width - 1) * channels, channels);
+				}
+			}
+			stbi_image_free(image);
+			if (settings.mode == ATLAS)
+				paddingTexels += (unsigned long long)(x1 - x0) * (y1 - y0) - (unsigned long long)width * height;
+		}
+	}
+};
+#endif
@@ -0,0 +1,639 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+#include "gl_extensions.h"
+#include "gl_state.h"
+#include "baked_texture.h"
+#include "image_resample.h"
+#include "stb_image.h"
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <condition_variable>
+
+// Texture Streamer Declaration
+// Textures are decoded with stb_image on worker threads and uploaded through
+// a ring of pixel buffer memory guarded by fences, a few rows at a time, so
+// the render loop never waits for a decode or an upload. Until a texture is
+// complete, getTexture() returns a small placeholder.
+// The ring is one persistently mapped buffer when ARB_buffer_storage is
+// available, otherwise an unsynchronized glMapBufferRange of the free region.
+// Call update() once per frame and shutdown() before the context goes away.
+// Settings::flipVertically picks the row order for every texture (the
+// workers set stbi's per-thread flag, so the global one does not matter).
+// If a baked .gltx file (see baked_texture.h) sits next to the source image,
+// is not older than it and was baked with the same row order, the worker
+// maps that instead of decoding, and its mip levels are streamed as stored
+// (no glGenerateMipmap). Decoded images
+// get their mip chain from ImageResample on the worker by default, which
+// looks the same on every driver; set cpuMipmaps to false for glGenerateMipmap.
+
+class TextureStreamer
+{
+public:
+	struct Settings
+	{
+		size_t ringSize = 8 * 1024 * 1024;    // bytes of staging memory
+		size_t frameBudget = 4 * 1024 * 1024; // bytes uploaded per update()
+		unsigned int workers = 2;             // decode threads
+		bool preferBaked = true;              // use .gltx files when present
+		bool cpuMipmaps = true;               // mips from ImageResample, not the driver
+		bool flipVertically = true;           // rows bottom-up, as stbi_set_flip_vertically_on_load(true)
+	};
+
+	struct Stats
+	{
+		unsigned int requested = 0;
+		unsigned int resident = 0;
+		unsigned int failed = 0;
+		unsigned int baked = 0;
+		size_t lastFrameBytes = 0;
+		size_t maxFrameBytes = 0;
+		unsigned long long totalBytes = 0;
+		unsigned long long ringFullFrames = 0;
+	};
+
+	// TextureStreamer Constructor: needs a current context
+	// -------------------------------------------------------------------
+	TextureStreamer()
+		: TextureStreamer(Settings())
+	{
+	}
+	// -------------------------------------------------------------------
+	TextureStreamer(const Settings& settings)
+		: settings(settings)
+	{
+		createPlaceholder();
+		createRing();
+		unsigned int count = settings.workers > 0 ? settings.workers : 1;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			workers.push_back(std::thread(&TextureStreamer::decodeLoop, this));
+		}
+	}
+
+	~TextureStreamer()
+	{
+		stopWorkers();
+	}
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// Queue a texture. channels is passed to stbi_load (0 keeps the file's).
+	// Returns a handle for getTexture().
+	// -------------------------------------------------------------------
+	int request(const char* path, int channels = 0, GLint wrap = GL_REPEAT)
+	{
+		Texture texture;
+		texture.path = path;
+		texture.wrap = wrap;
+		int handle = (int)textures.size();
+		textures.push_back(texture);
+		stats.requested++;
+
+		// workers only see the job, never the textures array
+		Job job;
+		job.handle = handle;
+		job.path = path;
+		job.channels = channels;
+		job.preferBaked = settings.preferBaked;
+		job.cpuMipmaps = settings.cpuMipmaps;
+		job.flip = settings.flipVertically;
+		std::lock_guard<std::mutex> lock(mutex);
+		decodeQueue.push_back(job);
+		wake.notify_one();
+		return handle;
+	}
+
+	// Texture to bind for a handle: the placeholder until it is resident
+	// -------------------------------------------------------------------
+	unsigned int getTexture(int handle) const
+	{
+		if (handle < 0 || handle >= (int)textures.size() || !textures[handle].resident)
+			return placeholder;
+		return textures[handle].id;
+	}
+	// -------------------------------------------------------------------
+	bool isResident(int handle) const
+	{
+		return handle >= 0 && handle < (int)textures.size() && textures[handle].resident;
+	}
+	// -------------------------------------------------------------------
+	bool isIdle() const
+	{
+		return stats.resident + stats.failed == stats.requested;
+	}
+
+	// Per-frame upload step. Never blocks: fences are only polled.
+	// -------------------------------------------------------------------
+	void update()
+	{
+		retireRegions();
+		collectDecoded();
+		stats.lastFrameBytes = 0;
+		if (uploadQueue.empty())
+			return;
+
+		GLState& state = GLState::instance();
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 1);
+
+		size_t budget = settings.frameBudget;
+		size_t regionStart = head;
+		size_t regionBytes = 0;
+		while (!uploadQueue.empty())
+		{
+			Texture& texture = textures[uploadQueue.front()];
+			const Level& level = texture.levels[texture.level];
+			size_t rowBytes = (size_t)level.width * texture.components;
+			int rows = level.height - texture.rowsUploaded;
+			// always allow one row so a huge row cannot stall the queue forever
+			size_t allowed = budget > rowBytes ? budget : rowBytes;
+			if (allowed > settings.ringSize)
+				allowed = settings.ringSize;
+			if ((size_t)rows * rowBytes > allowed)
+				rows = (int)(allowed / rowBytes);
+			size_t bytes = (size_t)rows * rowBytes;
+
+			size_t offset = 0;
+			if (rows == 0 || !allocate(bytes, offset))
+			{
+				if (rows > 0)
+					stats.ringFullFrames++;
+				break;
+			}
+			if (offset != regionStart + regionBytes)
+			{
+				// allocation wrapped to the start of the ring: fence what we have so far
+				fenceRegion(regionStart, regionBytes);
+				regionStart = offset;
+				regionBytes = 0;
+			}
+			regionBytes += bytes;
+
+			const unsigned char* source = level.pixels + (size_t)texture.rowsUploaded * rowBytes;
+			writeRing(offset, source, bytes);
+			if (texture.id == 0)
+				allocateTexture(texture);
+			state.textureSubImage2D(texture.id, GL_TEXTURE_2D, texture.level, 0, texture.rowsUploaded, level.width, rows, texture.format, GL_UNSIGNED_BYTE, (void*)offset);
+			texture.rowsUploaded += rows;
+			budget = budget > bytes ? budget - bytes : 0;
+			stats.lastFrameBytes += bytes;
+
+			if (texture.rowsUploaded == level.height && texture.level + 1 < (int)texture.levels.size())
+			{
+				texture.level++;
+				texture.rowsUploaded = 0;
+			}
+			else if (texture.rowsUploaded == level.height)
+			{
+				if (texture.baked)
+				{
+					// all levels came from the file; drop the mapping
+					texture.baked.reset();
+				}
+				else
+				{
+					if (texture.mips.empty())
+					{
+						state.bindTextureForEdit(GL_TEXTURE_2D, texture.id);
+						glGenerateMipmap(GL_TEXTURE_2D);
+					}
+					stbi_image_free(texture.pixels);
+					texture.pixels = NULL;
+					texture.mips.clear();
+				}
+				texture.levels.clear();
+				texture.resident = true;
+				stats.resident++;
+				uploadQueue.pop_front();
+			}
+			if (budget == 0)
+				break;
+		}
+		fenceRegion(regionStart, regionBytes);
+
+		state.pixelStore(GL_UNPACK_ALIGNMENT, 4);
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		stats.totalBytes += stats.lastFrameBytes;
+		if (stats.lastFrameBytes > stats.maxFrameBytes)
+			stats.maxFrameBytes = stats.lastFrameBytes;
+	}
+
+	void setFrameBudget(size_t bytes) { settings.frameBudget = bytes; }
+	const Stats& getStats() const { return stats; }
+
+	// Print upload counters
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		std::cout << "TEXTURE_STREAMER:: resident: " << stats.resident << "/" << stats.requested
+			<< " failed: " << stats.failed << " baked: " << stats.baked << " uploaded: " << stats.totalBytes / 1024 << " KB, max per frame: "
+			<< stats.maxFrameBytes / 1024 << " KB (budget " << settings.frameBudget / 1024 << " KB), ring full: "
+			<< stats.ringFullFrames << " frames" << (persistent ? ", persistent mapping" : "") << std::endl;
+	}
+
+	// Release GL objects. Call while the context is still current.
+	// -------------------------------------------------------------------
+	void shutdown()
+	{
+		GLState& state = GLState::instance();
+		stopWorkers();
+		for (size_t i = 0; i < decoded.size(); i++)
+		{
+			if (decoded[i].pixels)
+				stbi_image_free(decoded[i].pixels);
+		}
+		decoded.clear();
+		for (size_t i = 0; i < regions.size(); i++)
+		{
+			glDeleteSync(regions[i].fence);
+		}
+		regions.clear();
+		for (size_t i = 0; i < textures.size(); i++)
+		{
+			if (textures[i].pixels)
+				stbi_image_free(textures[i].pixels);
+			textures[i].pixels = NULL;
+			textures[i].baked.reset();
+			textures[i].mips.clear();
+			textures[i].levels.clear();
+			if (textures[i].id)
+				state.deleteTexture(textures[i].id);
+			textures[i].id = 0;
+			textures[i].resident = false;
+		}
+		if (ring)
+		{
+			if (persistent)
+			{
+				state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+			state.deleteBuffer(ring);
+		}
+		ring = 0;
+		mapped = NULL;
+		if (placeholder)
+			state.deleteTexture(placeholder);
+		placeholder = 0;
+	}
+
+private:
+	struct Job
+	{
+		int handle;
+		std::string path;
+		int channels;
+		bool preferBaked;
+		bool cpuMipmaps;
+		bool flip;
+	};
+	// One mip level still to upload
+	struct Level
+	{
+		const unsigned char* pixels;
+		int width;
+		int height;
+	};
+	struct Texture
+	{
+		std::string path;
+		GLint wrap = GL_REPEAT;
+		unsigned int id = 0;
+		unsigned char* pixels = NULL;              // stbi path: level 0, owned
+		std::shared_ptr<BakedTexture> baked;       // baked path: every level, mapped
+		std::vector<ImageResample::MipLevel> mips; // stbi path: levels 1..n (cpuMipmaps)
+		std::vector<Level> levels;
+		int width = 0;
+		int height = 0;
+		int components = 0;
+		GLenum format = GL_RGBA;
+		GLenum internalFormat = GL_RGBA8;
+		int level = 0;
+		int rowsUploaded = 0;
+		bool resident = false;
+	};
+	struct Decoded
+	{
+		int handle;
+		unsigned char* pixels;
+		std::shared_ptr<BakedTexture> baked;
+		std::vector<ImageResample::MipLevel> mips;
+		int width;
+		int height;
+		int components;
+	};
+	// Ring memory still being read by the GPU
+	struct Region
+	{
+		GLsync fence;
+		size_t start;
+	};
+
+	Settings settings;
+	Stats stats;
+	std::vector<Texture> textures;
+	std::deque<int> uploadQueue;
+	unsigned int placeholder = 0;
+
+	// staging ring
+	unsigned int ring = 0;
+	unsigned char* mapped = NULL;
+	bool persistent = false;
+	size_t head = 0;
+	size_t tail = 0;
+	bool empty = true;
+	std::deque<Region> regions;
+
+	// worker side (guarded by mutex)
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Job> decodeQueue;
+	std::vector<Decoded> decoded;
+	std::vector<std::thread> workers;
+	bool stopping = false;
+
+	// Decode thread body
+	// -------------------------------------------------------------------
+	void decodeLoop()
+	{
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this] { return stopping || !decodeQueue.empty(); });
+				if (stopping)
+					return;
+				job = decodeQueue.front();
+				decodeQueue.pop_front();
+			}
+			Decoded result;
+			result.handle = job.handle;
+			result.pixels = NULL;
+			std::string bakedPath;
+			if (job.preferBaked && BakedTexture::findBaked(job.path, bakedPath))
+			{
+				std::shared_ptr<BakedTexture> baked = std::make_shared<BakedTexture>(bakedPath);
+				const BakedTexture::Header& header = baked->getHeader();
+				// baked the other way up: decode the source instead
+				bool flipped = (header.flags & BakedTexture::FLIPPED) != 0;
+				if (baked->isValid() && header.type == GL_UNSIGNED_BYTE && (job.channels == 0 || (int)header.components == job.channels)
+					&& flipped == job.flip)
+				{
+					// fault the pages in here, not in update()'s copy into the ring
+					baked->prefetch();
+					result.baked = baked;
+					result.width = header.width;
+					result.height = header.height;
+					result.components = header.components;
+				}
+			}
+			if (!result.baked)
+			{
+				stbi_set_flip_vertically_on_load_thread(job.flip ? 1 : 0);
+				result.pixels = stbi_load(job.path.c_str(), &result.width, &result.height, &result.components, job.channels);
+				if (job.channels != 0)
+					result.components = job.channels;
+				if (result.pixels != NULL && job.cpuMipmaps)
+				{
+					// the workers already run in parallel, keep the resampler on this thread
+					ImageResample::Options options;
+					options.threads = 1;
+					result.mips = ImageResample::buildMipChain(result.pixels, result.width, result.height, result.components, options);
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			decoded.push_back(std::move(result));
+		}
+	}
+
+	// Move finished decodes onto the upload queue
+	// -------------------------------------------------------------------
+	void collectDecoded()
+	{
+		std::vector<Decoded> ready;
+		{
+			std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+			if (!lock.owns_lock())
+				return;
+			ready.swap(decoded);
+		}
+		for (size_t i = 0; i < ready.size(); i++)
+		{
+			Texture& texture = textures[ready[i].handle];
+			if (ready[i].pixels == NULL && !ready[i].baked)
+			{
+				std::cout << "Failed to load texture " << texture.path << std::endl;
+				stats.failed++;
+				continue;
+			}
+			texture.pixels = ready[i].pixels;
+			texture.baked = ready[i].baked;
+			texture.width = ready[i].width;
+			texture.height = ready[i].height;
+			texture.components = ready[i].components;
+			texture.format = texture.components == 4 ? GL_RGBA : texture.components == 3 ? GL_RGB : texture.components == 2 ? GL_RG : GL_RED;
+			texture.internalFormat = texture.components == 4 ? GL_RGBA8 : texture.components == 3 ? GL_RGB8 : texture.components == 2 ? GL_RG8 : GL_R8;
+			texture.level = 0;
+			texture.rowsUploaded = 0;
+			if (texture.baked)
+			{
+				texture.format = texture.baked->getHeader().format;
+				texture.internalFormat = texture.baked->getHeader().internalFormat;
+				for (unsigned int level = 0; level < texture.baked->getLevelCount(); level++)
+				{
+					const BakedTexture::Level& stored = texture.baked->getLevel(level);
+					texture.levels.push_back(Level{ texture.baked->getPixels(level), (int)stored.width, (int)stored.height });
+				}
+				stats.baked++;
+			}
+			else
+			{
+				texture.mips = std::move(ready[i].mips);
+				texture.levels.push_back(Level{ texture.pixels, texture.width, texture.height });
+				for (size_t level = 0; level < texture.mips.size(); level++)
+				{
+					texture.levels.push_back(Level{ texture.mips[level].pixels.data(), texture.mips[level].width, texture.mips[level].height });
+				}
+			}
+			uploadQueue.push_back(ready[i].handle);
+		}
+	}
+
+	void stopWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			workers[i].join();
+		}
+		workers.clear();
+	}
+
+	// Storage for every level we upload (without cpuMipmaps the stbi path
+	// gets its mip chain from glGenerateMipmap at the end), filled in later
+	// -------------------------------------------------------------------
+	void allocateTexture(Texture& texture)
+	{
+		GLState& state = GLState::instance();
+		glGenTextures(1, &texture.id);
+		state.bindTextureForEdit(GL_TEXTURE_2D, texture.id);
+		if (texture.baked)
+		{
+			texture.baked->setParameters(texture.wrap);
+		}
+		else
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture.wrap);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture.wrap);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			if (!texture.mips.empty())
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)texture.levels.size() - 1);
+		}
+		// the unpack buffer is bound, so the NULL data pointer means "no data"
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		for (size_t i = 0; i < texture.levels.size(); i++)
+		{
+			glTexImage2D(GL_TEXTURE_2D, (GLint)i, texture.internalFormat, texture.levels[i].width, texture.levels[i].height, 0, texture.format, GL_UNSIGNED_BYTE, NULL);
+		}
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+	}
+
+	// 2x2 grey checker shown until the real texture is resident
+	// -------------------------------------------------------------------
+	void createPlaceholder()
+	{
+		const unsigned char pixels[16] = { 96, 96, 96, 255,  160, 160, 160, 255,  160, 160, 160, 255,  96, 96, 96, 255 };
+		GLState& state = GLState::instance();
+		glGenTextures(1, &placeholder);
+		state.bindTextureForEdit(GL_TEXTURE_2D, placeholder);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	}
+
+	// -------------------------------------------------------------------
+	void createRing()
+	{
+		typedef void (APIENTRYP BufferStorageProc)(GLenum, GLsizeiptr, const void*, GLbitfield);
+		BufferStorageProc bufferStorage = NULL;
+		if (GLExtensions::version(4, 4) || GLExtensions::has("GL_ARB_buffer_storage"))
+			bufferStorage = (BufferStorageProc)GLExtensions::getProcAddress("glBufferStorage");
+
+		GLState& state = GLState::instance();
+		glGenBuffers(1, &ring);
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+		if (bufferStorage != NULL)
+		{
+			const GLbitfield flags = GL_MAP_WRITE_BIT | 0x0040 /* GL_MAP_PERSISTENT_BIT */ | 0x0080 /* GL_MAP_COHERENT_BIT */;
+			bufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)settings.ringSize, NULL, flags);
+			mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)settings.ringSize, flags));
+			persistent = mapped != NULL;
+		}
+		if (!persistent)
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)settings.ringSize, NULL, GL_STREAM_DRAW);
+		state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	// Copy into the ring (the unpack buffer is bound)
+	// -------------------------------------------------------------------
+	void writeRing(size_t offset, const unsigned char* source, size_t bytes)
+	{
+		if (persistent)
+		{
+			std::memcpy(mapped + offset, source, bytes);
+			return;
+		}
+		// the range is not in use by the GPU (its fence signalled), so no sync needed
+		void* target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, (GLintptr)offset, (GLsizeiptr)bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		if (target)
+		{
+			std::memcpy(target, source, bytes);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+	}
+
+	// Reserve 'bytes' of contiguous ring space; false if it is not free yet
+	// -------------------------------------------------------------------
+	bool allocate(size_t bytes, size_t& offset)
+	{
+		if (bytes > settings.ringSize)
+			return false;
+		if (empty)
+		{
+			tail = 0;
+			offset = 0;
+		}
+		else if (head > tail)
+		{
+			// free space is [head, end) and [0, tail)
+			if (settings.ringSize - head >= bytes)
+				offset = head;
+			else if (tail >= bytes)
+				offset = 0;
+			else
+				return false;
+		}
+		else
+		{
+			// free space is [head, tail) (nothing when head == tail)
+			if (tail - head >= bytes)
+				offset = head;
+			else
+				return false;
+		}
+		head = offset + bytes;
+		empty = false;
+		return true;
+	}
+
+	// Fence the ring memory used by this frame's uploads
+	// -------------------------------------------------------------------
+	void fenceRegion(size_t start, size_t bytes)
+	{
+		if (bytes == 0)
+			return;
+		Region region;
+		region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		region.start = start;
+		regions.push_back(region);
+	}
+
+	// Free regions whose fence signalled (polled with a zero timeout)
+	// -------------------------------------------------------------------
+	void retireRegions()
+	{
+		while (!regions.empty())
+		{
+			GLenum status = glClientWaitSync(regions.front().fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				break;
+			glDeleteSync(regions.front().fence);
+			regions.pop_front();
+		}
+		// every allocation of earlier frames belongs to a region
+		if (regions.empty())
+			empty = true;
+		else
+			tail = regions.front().start;
+	}
+};
+#endif
@@ -0,0 +1,429 @@
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+#include "job_system.h"
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define TRANSFORM_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+// Transform Batch Declaration
+// Builds model matrices for many objects at once, the batch version of
+// glm::translate(glm::mat4(1.0f), position) * rotation * glm::scale(scale).
+// Transforms are kept as a structure of arrays (one array per component),
+// so 4 (SSE2) or 8 (AVX2) objects are built per step, and each matrix is
+// written as 16 column-major floats (the InstanceBuffer::Matrix layout)
+// straight into the target, e.g. an UploadRing allocation. With 'stream'
+// the matrices are written with non-temporal stores, which is what a
+// write-combined persistent mapping wants. Rotations are axis + angle (unit
+// axis, as InstanceBuffer::Packed) or unit quaternions. Large batches are
+// split into ranges that run on the JobSystem workers.
+// The SIMD paths use their own sin/cos (within ~1e-7 of std::sin/std::cos
+// for angles up to a few thousand radians).
+
+class TransformBatch
+{
+public:
+	enum Rotation
+	{
+		AXIS_ANGLE, // rotation x, y, z = unit axis, w = angle in radians
+		QUATERNION  // rotation x, y, z, w = unit quaternion
+	};
+
+	enum Instructions
+	{
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+	struct Options
+	{
+		unsigned int threads = 0; // 0: all JobSystem threads
+		Instructions instructions = best();
+		bool stream = false;      // non-temporal stores (target aligned to 32 bytes)
+	};
+
+	// One array per component, all 'size()' long
+	struct Transforms
+	{
+		Rotation rotation = AXIS_ANGLE;
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+		std::vector<float> scaleX, scaleY, scaleZ;
+
+		size_t size() const { return positionX.size(); }
+
+		void resize(size_t count)
+		{
+			positionX.resize(count, 0.0f);
+			positionY.resize(count, 0.0f);
+			positionZ.resize(count, 0.0f);
+			rotationX.resize(count, 0.0f);
+			rotationY.resize(count, rotation == AXIS_ANGLE ? 1.0f : 0.0f);
+			rotationZ.resize(count, 0.0f);
+			rotationW.resize(count, rotation == AXIS_ANGLE ? 0.0f : 1.0f);
+			scaleX.resize(count, 1.0f);
+			scaleY.resize(count, 1.0f);
+			scaleZ.resize(count, 1.0f);
+		}
+
+		// Set object i with a uniform scale
+		void set(size_t i, float x, float y, float z, float rx, float ry, float rz, float rw, float scale)
+		{
+			positionX[i] = x;
+			positionY[i] = y;
+			positionZ[i] = z;
+			rotationX[i] = rx;
+			rotationY[i] = ry;
+			rotationZ[i] = rz;
+			rotationW[i] = rw;
+			scaleX[i] = scaleY[i] = scaleZ[i] = scale;
+		}
+	};
+
+	// Widest instruction set this build can use
+	// -------------------------------------------------------------------
+	static Instructions best()
+	{
+#if defined(TRANSFORM_BATCH_AVX2)
+		return AVX2;
+#elif defined(TRANSFORM_BATCH_SSE2)
+		return SSE2;
+#else
+		return SCALAR;
+#endif
+	}
+
+	static const char* name(Instructions instructions)
+	{
+		return instructions == AVX2 ? "AVX2" : instructions == SSE2 ? "SSE2" : "scalar";
+	}
+
+	// Write transforms.size() matrices (16 floats each) to 'matrices'
+	// -------------------------------------------------------------------
+	static void build(const Transforms& transforms, float* matrices)
+	{
+		build(transforms, matrices, Options());
+	}
+	// -------------------------------------------------------------------
+	static void build(const Transforms& transforms, float* matrices, const Options& options)
+	{
+		size_t count = transforms.size();
+		if (matrices == NULL || count == 0)
+			return;
+		Instructions instructions = options.instructions > best() ? best() : options.instructions;
+		bool stream = options.stream && ((uintptr_t)matrices & 31) == 0;
+
+		unsigned int threads = options.threads;
+		if (threads != 1)
+		{
+			JobSystem& jobs = JobSystem::instance();
+			threads = threads != 0 ? std::min(threads, jobs.threadCount()) : jobs.threadCount();
+		}
+		// not worth a thread below ~32K objects per thread
+		unsigned int useful = (unsigned int)std::max((size_t)1, count / (32 * 1024));
+		threads = std::max(1u, std::min(threads, useful));
+		if (threads == 1)
+		{
+			buildRange(transforms, 0, count, matrices, instructions, stream);
+			return;
+		}
+
+		// a few ranges per thread so stealing can even out the load; whole
+		// SIMD steps per range
+		size_t grain = (count + threads * 4 - 1) / (threads * 4);
+		grain = (grain + 7) / 8 * 8;
+		JobSystem::instance().parallelFor(count, grain, [&](size_t first, size_t end)
+		{
+			buildRange(transforms, first, end, matrices, instructions, stream);
+		});
+	}
+
+	// One matrix, the reference the SIMD paths are checked against
+	// -------------------------------------------------------------------
+	static void buildOne(const Transforms& transforms, size_t i, float* matrix)
+	{
+		float r[9];
+		float x = transforms.rotationX[i], y = transforms.rotationY[i], z = transforms.rotationZ[i], w = transforms.rotationW[i];
+		if (transforms.rotation == AXIS_ANGLE)
+		{
+			float c = std::cos(w);
+			float s = std::sin(w);
+			float t = 1.0f - c;
+			r[0] = t * x * x + c;     r[1] = t * x * y + s * z; r[2] = t * x * z - s * y;
+			r[3] = t * x * y - s * z; r[4] = t * y * y + c;     r[5] = t * y * z + s * x;
+			r[6] = t * x * z + s * y; r[7] = t * y * z - s * x; r[8] = t * z * z + c;
+		}
+		else
+		{
+			r[0] = 1.0f - 2.0f * (y * y + z * z); r[1] = 2.0f * (x * y + w * z);        r[2] = 2.0f * (x * z - w * y);
+			r[3] = 2.0f * (x * y - w * z);        r[4] = 1.0f - 2.0f * (x * x + z * z); r[5] = 2.0f * (y * z + w * x);
+			r[6] = 2.0f * (x * z + w * y);        r[7] = 2.0f * (y * z - w * x);        r[8] = 1.0f - 2.0f * (x * x + y * y);
+		}
+		const float scale[3] = { transforms.scaleX[i], transforms.scaleY[i], transforms.scaleZ[i] };
+		for (int column = 0; column < 3; column++)
+		{
+			matrix[column * 4 + 0] = r[column * 3 + 0] * scale[column];
+			matrix[column * 4 + 1] = r[column * 3 + 1] * scale[column];
+			matrix[column * 4 + 2] = r[column * 3 + 2] * scale[column];
+			matrix[column * 4 + 3] = 0.0f;
+		}
+		matrix[12] = transforms.positionX[i];
+		matrix[13] = transforms.positionY[i];
+		matrix[14] = transforms.positionZ[i];
+		matrix[15] = 1.0f;
+	}
+
+private:
+	// Cephes single precision sin/cos on [-pi/4, pi/4] after reducing by pi/2
+	static constexpr float TWO_OVER_PI = 0.636619772f;
+	static constexpr float HALF_PI_1 = 1.5703125f;
+	static constexpr float HALF_PI_2 = 4.837512969970703125e-4f;
+	static constexpr float HALF_PI_3 = 7.549789948768648e-8f;
+	static constexpr float SIN_1 = -1.6666654611e-1f;
+	static constexpr float SIN_2 = 8.3321608736e-3f;
+	static constexpr float SIN_3 = -1.9515295891e-4f;
+	static constexpr float COS_1 = 4.166664568298827e-2f;
+	static constexpr float COS_2 = -1.388731625493765e-3f;
+	static constexpr float COS_3 = 2.443315711809948e-5f;
+
+	// Matrices first..end-1, SIMD steps first, the rest one at a time
+	// -------------------------------------------------------------------
+	static void buildRange(const Transforms& transforms, size_t first, size_t end, float* matrices, Instructions instructions, bool stream)
+	{
+		size_t i = first;
+#ifdef TRANSFORM_BATCH_AVX2
+		if (instructions == AVX2)
+		{
+			for (; i + 8 <= end; i += 8)
+			{
+				buildAVX2(transforms, i, matrices + i * 16, stream);
+			}
+		}
+#endif
+#ifdef TRANSFORM_BATCH_SSE2
+		if (instructions >= SSE2)
+		{
+			for (; i + 4 <= end; i += 4)
+			{
+				buildSSE2(transforms, i, matrices + i * 16, stream);
+			}
+			if (stream)
+				_mm_sfence();
+		}
+#endif
+		for (; i < end; i++)
+		{
+			buildOne(transforms, i, matrices + i * 16);
+		}
+	}
+
+#ifdef TRANSFORM_BATCH_SSE2
+	// -------------------------------------------------------------------
+	static void sinCos(__m128 angle, __m128& sine, __m128& cosine)
+	{
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(TWO_OVER_PI)));
+		__m128 j = _mm_cvtepi32_ps(quadrant);
+		__m128 r = _mm_sub_ps(angle, _mm_mul_ps(j, _mm_set1_ps(HALF_PI_1)));
+		r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(HALF_PI_2)));
+		r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(HALF_PI_3)));
+		__m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 s = _mm_add_ps(_mm_set1_ps(SIN_2), _mm_mul_ps(r2, _mm_set1_ps(SIN_3)));
+		s = _mm_add_ps(_mm_set1_ps(SIN_1), _mm_mul_ps(r2, s));
+		s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r2, r), s));
+		__m128 c = _mm_add_ps(_mm_set1_ps(COS_2), _mm_mul_ps(r2, _mm_set1_ps(COS_3)));
+		c = _mm_add_ps(_mm_set1_ps(COS_1), _mm_mul_ps(r2, c));
+		c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))), _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+		// odd quadrants swap sin and cos; the signs follow the quadrant
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+		sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sinSign);
+		cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosSign);
+	}
+
+	// Four matrices from objects i..i+3
+	// -------------------------------------------------------------------
+	static void buildSSE2(const Transforms& transforms, size_t i, float* target, bool stream)
+	{
+		__m128 x = _mm_loadu_ps(&transforms.rotationX[i]);
+		__m128 y = _mm_loadu_ps(&transforms.rotationY[i]);
+		__m128 z = _mm_loadu_ps(&transforms.rotationZ[i]);
+		__m128 w = _mm_loadu_ps(&transforms.rotationW[i]);
+		__m128 r[9];
+		if (transforms.rotation == AXIS_ANGLE)
+		{
+			__m128 s, c;
+			sinCos(w, s, c);
+			__m128 t = _mm_sub_ps(_mm_set1_ps(1.0f), c);
+			__m128 tx = _mm_mul_ps(t, x), ty = _mm_mul_ps(t, y), tz = _mm_mul_ps(t, z);
+			__m128 sx = _mm_mul_ps(s, x), sy = _mm_mul_ps(s, y), sz = _mm_mul_ps(s, z);
+			__m128 txy = _mm_mul_ps(tx, y), txz = _mm_mul_ps(tx, z), tyz = _mm_mul_ps(ty, z);
+			r[0] = _mm_add_ps(_mm_mul_ps(tx, x), c); r[1] = _mm_add_ps(txy, sz);                 r[2] = _mm_sub_ps(txz, sy);
+			r[3] = _mm_sub_ps(txy, sz);                 r[4] = _mm_add_ps(_mm_mul_ps(ty, y), c); r[5] = _mm_add_ps(tyz, sx);
+			r[6] = _mm_add_ps(txz, sy);                 r[7] = _mm_sub_ps(tyz, sx);                 r[8] = _mm_add_ps(_mm_mul_ps(tz, z), c);
+		}
+		else
+		{
+			const __m128 one = _mm_set1_ps(1.0f);
+			__m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+			__m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+			__m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+			__m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+			r[0] = _mm_sub_ps(one, _mm_add_ps(yy, zz)); r[1] = _mm_add_ps(xy, wz);                  r[2] = _mm_sub_ps(xz, wy);
+			r[3] = _mm_sub_ps(xy, wz);                  r[4] = _mm_sub_ps(one, _mm_add_ps(xx, zz)); r[5] = _mm_add_ps(yz, wx);
+			r[6] = _mm_add_ps(xz, wy);                  r[7] = _mm_sub_ps(yz, wx);                  r[8] = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+		}
+		__m128 scale[3] = { _mm_loadu_ps(&transforms.scaleX[i]), _mm_loadu_ps(&transforms.scaleY[i]), _mm_loadu_ps(&transforms.scaleZ[i]) };
+
+		// columns of the four matrices: transpose column-component rows
+		__m128 columns[4][4];
+		for (int column = 0; column < 3; column++)
+		{
+			columns[column][0] = _mm_mul_ps(r[column * 3 + 0], scale[column]);
+			columns[column][1] = _mm_mul_ps(r[column * 3 + 1], scale[column]);
+			columns[column][2] = _mm_mul_ps(r[column * 3 + 2], scale[column]);
+			columns[column][3] = _mm_setzero_ps();
+		}
+		columns[3][0] = _mm_loadu_ps(&transforms.positionX[i]);
+		columns[3][1] = _mm_loadu_ps(&transforms.positionY[i]);
+		columns[3][2] = _mm_loadu_ps(&transforms.positionZ[i]);
+		columns[3][3] = _mm_set1_ps(1.0f);
+		for (int column = 0; column < 4; column++)
+		{
+			_MM_TRANSPOSE4_PS(columns[column][0], columns[column][1], columns[column][2], columns[column][3]);
+			for (int object = 0; object < 4; object++)
+			{
+				float* out = target + object * 16 + column * 4;
+				if (stream)
+					_mm_stream_ps(out, columns[column][object]);
+				else
+					_mm_storeu_ps(out, columns[column][object]);
+			}
+		}
+	}
+#endif
+
+#ifdef TRANSFORM_BATCH_AVX2
+	// -------------------------------------------------------------------
+	static void sinCos(__m256 angle, __m256& sine, __m256& cosine)
+	{
+		__m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(angle, _mm256_set1_ps(TWO_OVER_PI)));
+		__m256 j = _mm256_cvtepi32_ps(quadrant);
+		__m256 r = _mm256_sub_ps(angle, _mm256_mul_ps(j, _mm256_set1_ps(HALF_PI_1)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(HALF_PI_2)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(HALF_PI_3)));
+		__m256 r2 = _mm256_mul_ps(r, r);
+
+		__m256 s = _mm256_add_ps(_mm256_set1_ps(SIN_2), _mm256_mul_ps(r2, _mm256_set1_ps(SIN_3)));
+		s = _mm256_add_ps(_mm256_set1_ps(SIN_1), _mm256_mul_ps(r2, s));
+		s = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r2, r), s));
+		__m256 c = _mm256_add_ps(_mm256_set1_ps(COS_2), _mm256_mul_ps(r2, _mm256_set1_ps(COS_3)));
+		c = _mm256_add_ps(_mm256_set1_ps(COS_1), _mm256_mul_ps(r2, c));
+		c = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(r2, _mm256_set1_ps(0.5f))), _mm256_mul_ps(_mm256_mul_ps(r2, r2), c));
+
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i two = _mm256_set1_epi32(2);
+		__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+		__m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+		__m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+		sine = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign);
+		cosine = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign);
+	}
+
+	// 4x4 transpose inside each 128-bit half: out[k] = (a, b, c, d) of
+	// object k in the low half and of object k + 4 in the high half
+	// -------------------------------------------------------------------
+	static void transpose(__m256 a, __m256 b, __m256 c, __m256 d, __m256* out)
+	{
+		__m256 abLow = _mm256_unpacklo_ps(a, b);
+		__m256 abHigh = _mm256_unpackhi_ps(a, b);
+		__m256 cdLow = _mm256_unpacklo_ps(c, d);
+		__m256 cdHigh = _mm256_unpackhi_ps(c, d);
+		out[0] = _mm256_shuffle_ps(abLow, cdLow, _MM_SHUFFLE(1, 0, 1, 0));
+		out[1] = _mm256_shuffle_ps(abLow, cdLow, _MM_SHUFFLE(3, 2, 3, 2));
+		out[2] = _mm256_shuffle_ps(abHigh, cdHigh, _MM_SHUFFLE(1, 0, 1, 0));
+		out[3] = _mm256_shuffle_ps(abHigh, cdHigh, _MM_SHUFFLE(3, 2, 3, 2));
+	}
+
+	// Eight matrices from objects i..i+7
+	// -------------------------------------------------------------------
+	static void buildAVX2(const Transforms& transforms, size_t i, float* target, bool stream)
+	{
+		__m256 x = _mm256_loadu_ps(&transforms.rotationX[i]);
+		__m256 y = _mm256_loadu_ps(&transforms.rotationY[i]);
+		__m256 z = _mm256_loadu_ps(&transforms.rotationZ[i]);
+		__m256 w = _mm256_loadu_ps(&transforms.rotationW[i]);
+		__m256 r[9];
+		if (transforms.rotation == AXIS_ANGLE)
+		{
+			__m256 s, c;
+			sinCos(w, s, c);
+			__m256 t = _mm256_sub_ps(_mm256_set1_ps(1.0f), c);
+			__m256 tx = _mm256_mul_ps(t, x), ty = _mm256_mul_ps(t, y), tz = _mm256_mul_ps(t, z);
+			__m256 sx = _mm256_mul_ps(s, x), sy = _mm256_mul_ps(s, y), sz = _mm256_mul_ps(s, z);
+			__m256 txy = _mm256_mul_ps(tx, y), txz = _mm256_mul_ps(tx, z), tyz = _mm256_mul_ps(ty, z);
+			r[0] = _mm256_add_ps(_mm256_mul_ps(tx, x), c); r[1] = _mm256_add_ps(txy, sz);                    r[2] = _mm256_sub_ps(txz, sy);
+			r[3] = _mm256_sub_ps(txy, sz);                    r[4] = _mm256_add_ps(_mm256_mul_ps(ty, y), c); r[5] = _mm256_add_ps(tyz, sx);
+			r[6] = _mm256_add_ps(txz, sy);                    r[7] = _mm256_sub_ps(tyz, sx);                    r[8] = _mm256_add_ps(_mm256_mul_ps(tz, z), c);
+		}
+		else
+		{
+			const __m256 one = _mm256_set1_ps(1.0f);
+			__m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+			__m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+			__m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+			__m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+			r[0] = _mm256_sub_ps(one, _mm256_add_ps(yy, zz)); r[1] = _mm256_add_ps(xy, wz);                     r[2] = _mm256_sub_ps(xz, wy);
+			r[3] = _mm256_sub_ps(xy, wz);                     r[4] = _mm256_sub_ps(one, _mm256_add_ps(xx, zz)); r[5] = _mm256_add_ps(yz, wx);
+			r[6] = _mm256_add_ps(xz, wy);                     r[7] = _mm256_sub_ps(yz, wx);                     r[8] = _mm256_sub_ps(one, _mm256_add_ps(xx, yy));
+		}
+		__m256 scale[3] = { _mm256_loadu_ps(&transforms.scaleX[i]), _mm256_loadu_ps(&transforms.scaleY[i]), _mm256_loadu_ps(&transforms.scaleZ[i]) };
+
+		__m256 columns[4][4];
+		const __m256 zero = _mm256_setzero_ps();
+		for (int column = 0; column < 3; column++)
+		{
+			transpose(_mm256_mul_ps(r[column * 3 + 0], scale[column]), _mm256_mul_ps(r[column * 3 + 1], scale[column]),
+				_mm256_mul_ps(r[column * 3 + 2], scale[column]), zero, columns[column]);
+		}
+		transpose(_mm256_loadu_ps(&transforms.positionX[i]), _mm256_loadu_ps(&transforms.positionY[i]),
+			_mm256_loadu_ps(&transforms.positionZ[i]), _mm256_set1_ps(1.0f), columns[3]);
+
+		// object k: columns 0+1 and 2+3 from the low halves, object k + 4 from the high ones
+		for (int k = 0; k < 4; k++)
+		{
+			__m256 parts[4] = {
+				_mm256_permute2f128_ps(columns[0][k], columns[1][k], 0x20),
+				_mm256_permute2f128_ps(columns[2][k], columns[3][k], 0x20),
+				_mm256_permute2f128_ps(columns[0][k], columns[1][k], 0x31),
+				_mm256_permute2f128_ps(columns[2][k], columns[3][k], 0x31)
+			};
+			float* out[4] = { target + k * 16, target + k * 16 + 8, target + (k + 4) * 16, target + (k + 4) * 16 + 8 };
+			for (int p = 0; p < 4; p++)
+			{
+				if (stream)
+					_mm256_stream_ps(out[p], parts[p]);
+				else
+					_mm256_storeu_ps(out[p], parts[p]);
+			}
+		}
+	}
+#endif
+};
+#endif
@@ -0,0 +1,19 @@
+// Uniform blocks shared by every program (see Common/uniform_blocks.h).
+// The C++ structs CameraBlock and FrameBlock mirror these std140 layouts;
+// change both together. Include after #version.
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;   // xyz, w unused
+};
+
+layout (std140) uniform Frame
+{
+	float time;            // seconds
+	float deltaTime;
+	int frameIndex;
+	vec2 resolution;       // framebuffer size in pixels
+};
@@ -0,0 +1,283 @@
+#ifndef UNIFORM_BLOCKS_H
+#define UNIFORM_BLOCKS_H
+
+#include <glad/glad.h>
+#include "gl_state.h"
+#include "upload_ring.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+// Uniform Blocks Declaration
+// Data that every program reads (camera, time ...) lives in uniform blocks
+// with one binding point per block name, shared by all programs: Shader
+// calls attach() on every program it links or loads, which binds each
+// active block to that point. A block's buffer is then uploaded once per
+// change and bound once, no matter how many programs or draws read it.
+// Blocks use the std140 layout. The C++ side is a plain struct of floats
+// laid out by hand to match (16 byte vec4/mat4 slots, see CameraBlock); it
+// is declared with declare<Block>() and checked against what the driver
+// reports (glGetActiveUniformBlockiv / GL_UNIFORM_OFFSET) for each program.
+// Camera and Frame are declared up front; their GLSL is uniform_blocks.glsl.
+
+// One member of a block: GLSL name and byte offset in the struct
+struct UniformBlockMember
+{
+	const char* name;
+	size_t offset;
+};
+
+// layout (std140) uniform Camera in uniform_blocks.glsl
+struct CameraBlock
+{
+	float view[16];
+	float projection[16];
+	float viewProjection[16];
+	float cameraPosition[4];
+
+	static const char* blockName() { return "Camera"; }
+	static std::vector<UniformBlockMember> members()
+	{
+		return {
+			{ "view", offsetof(CameraBlock, view) },
+			{ "projection", offsetof(CameraBlock, projection) },
+			{ "viewProjection", offsetof(CameraBlock, viewProjection) },
+			{ "cameraPosition", offsetof(CameraBlock, cameraPosition) }
+		};
+	}
+};
+static_assert(offsetof(CameraBlock, cameraPosition) == 192 && sizeof(CameraBlock) == 208, "CameraBlock does not match std140");
+
+// layout (std140) uniform Frame in uniform_blocks.glsl
+struct FrameBlock
+{
+	float time;
+	float deltaTime;
+	int frameIndex;
+	float padding0;      // vec2 starts on an 8 byte boundary: 16
+	float resolution[2];
+	float padding1[2];   // block size rounds up to 16
+
+	static const char* blockName() { return "Frame"; }
+	static std::vector<UniformBlockMember> members()
+	{
+		return {
+			{ "time", offsetof(FrameBlock, time) },
+			{ "deltaTime", offsetof(FrameBlock, deltaTime) },
+			{ "frameIndex", offsetof(FrameBlock, frameIndex) },
+			{ "resolution", offsetof(FrameBlock, resolution) }
+		};
+	}
+};
+static_assert(offsetof(FrameBlock, resolution) == 16 && sizeof(FrameBlock) == 32, "FrameBlock does not match std140");
+
+class UniformBlocks
+{
+public:
+	struct Stats
+	{
+		unsigned long long uploads = 0;    // buffer updates
+		unsigned long long unchanged = 0;  // update() calls with the same data
+		unsigned long long programs = 0;   // programs attached
+		unsigned long long mismatches = 0; // layouts that failed the check
+	};
+
+	// Shared registry for the rendering thread
+	// -------------------------------------------------------------------
+	static UniformBlocks& instance()
+	{
+		static UniformBlocks blocks;
+		return blocks;
+	}
+
+	// Binding point of a block name, assigned on first use
+	// -------------------------------------------------------------------
+	GLuint binding(const std::string& name)
+	{
+		std::map<std::string, size_t>::const_iterator it = byName.find(name);
+		if (it != byName.end())
+			return blocks[it->second].binding;
+		Block block;
+		block.name = name;
+		block.binding = (GLuint)blocks.size();
+		byName[name] = blocks.size();
+		blocks.push_back(block);
+		return block.binding;
+	}
+
+	// Register the C++ layout of a block (see CameraBlock). Programs
+	// attached from now on are checked against it.
+	// -------------------------------------------------------------------
+	template <typename T>
+	GLuint declare()
+	{
+		GLuint index = binding(T::blockName());
+		Block& block = blocks[byName[T::blockName()]];
+		block.size = sizeof(T);
+		block.members = T::members();
+		return index;
+	}
+
+	// Bind every active block of 'program' to its shared binding point and
+	// check declared layouts. Shader does this after linking/loading.
+	// -------------------------------------------------------------------
+	void attach(GLuint program)
+	{
+		if (program == 0)
+			return;
+		stats.programs++;
+		GLint count = 0;
+		GLint maxLength = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+		std::vector<GLchar> nameBuffer(maxLength > 0 ? maxLength : 1);
+		for (GLint i = 0; i < count; i++)
+		{
+			GLsizei length = 0;
+			glGetActiveUniformBlockName(program, (GLuint)i, (GLsizei)nameBuffer.size(), &length, nameBuffer.data());
+			std::string name(nameBuffer.data(), length);
+			glUniformBlockBinding(program, (GLuint)i, binding(name));
+			const Block& block = blocks[byName[name]];
+			if (block.size > 0 && !matches(program, (GLuint)i, block))
+				stats.mismatches++;
+		}
+	}
+
+	// Upload a block if it changed and keep it bound to its binding point
+	// -------------------------------------------------------------------
+	template <typename T>
+	void update(const T& data)
+	{
+		Block& block = find<T>();
+		GLState& state = GLState::instance();
+		if (block.buffer != 0 && block.shadow.size() == sizeof(T) && std::memcmp(block.shadow.data(), &data, sizeof(T)) == 0)
+		{
+			stats.unchanged++;
+			state.bindBufferBase(GL_UNIFORM_BUFFER, block.binding, block.buffer);
+			return;
+		}
+		block.shadow.assign(reinterpret_cast<const unsigned char*>(&data), reinterpret_cast<const unsigned char*>(&data) + sizeof(T));
+		if (block.buffer == 0)
+		{
+			glGenBuffers(1, &block.buffer);
+			state.bindBuffer(GL_UNIFORM_BUFFER, block.buffer);
+		}
+		// orphan so draws still reading the old values do not stall the update
+		state.bufferData(block.buffer, GL_UNIFORM_BUFFER, sizeof(T), NULL, GL_DYNAMIC_DRAW);
+		state.bufferSubData(block.buffer, GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+		state.bindBufferBase(GL_UNIFORM_BUFFER, block.binding, block.buffer);
+		stats.uploads++;
+	}
+
+	// Same, but through this frame's part of an UploadRing (for blocks that
+	// change every frame). Call between ring.beginFrame() and endFrame().
+	// -------------------------------------------------------------------
+	template <typename T>
+	void update(const T& data, UploadRing& ring)
+	{
+		Block& block = find<T>();
+		UploadRing::Allocation allocation = ring.allocateUniform(sizeof(T));
+		if (!allocation.valid())
+		{
+			update(data);
+			return;
+		}
+		std::memcpy(allocation.data, &data, sizeof(T));
+		ring.commit(allocation);
+		ring.bindUniform(block.binding, allocation);
+		block.shadow.clear();
+		stats.uploads++;
+	}
+
+	const Stats& getStats() const { return stats; }
+
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		std::cout << "UNIFORM_BLOCKS:: blocks: " << blocks.size() << ", programs: " << stats.programs << ", uploads: " << stats.uploads
+			<< ", unchanged: " << stats.unchanged << ", layout mismatches: " << stats.mismatches << std::endl;
+	}
+
+	// Delete the block buffers. Call while the context is still current.
+	// -------------------------------------------------------------------
+	void release()
+	{
+		for (size_t i = 0; i < blocks.size(); i++)
+		{
+			if (blocks[i].buffer)
+				GLState::instance().deleteBuffer(blocks[i].buffer);
+			blocks[i].buffer = 0;
+			blocks[i].shadow.clear();
+		}
+	}
+
+private:
+	struct Block
+	{
+		std::string name;
+		GLuint binding = 0;
+		size_t size = 0; // 0 until declared
+		std::vector<UniformBlockMember> members;
+		GLuint buffer = 0;
+		std::vector<unsigned char> shadow;
+	};
+
+	std::vector<Block> blocks;
+	std::map<std::string, size_t> byName;
+	Stats stats;
+
+	UniformBlocks()
+	{
+		declare<CameraBlock>();
+		declare<FrameBlock>();
+	}
+
+	template <typename T>
+	Block& find()
+	{
+		std::map<std::string, size_t>::const_iterator it = byName.find(T::blockName());
+		if (it == byName.end() || blocks[it->second].size == 0)
+			declare<T>();
+		return blocks[byName[T::blockName()]];
+	}
+
+	// Compare the driver's std140 layout with the declared struct
+	// -------------------------------------------------------------------
+	bool matches(GLuint program, GLuint index, const Block& block)
+	{
+		bool ok = true;
+		GLint dataSize = 0;
+		glGetActiveUniformBlockiv(program, index, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+		if ((size_t)dataSize != block.size)
+		{
+			std::cout << "ERROR::UNIFORM_BLOCKS::SIZE_MISMATCH " << block.name << ": GL " << dataSize << " bytes, struct " << block.size << std::endl;
+			ok = false;
+		}
+		for (size_t m = 0; m < block.members.size(); m++)
+		{
+			const UniformBlockMember& member = block.members[m];
+			GLuint uniform = GL_INVALID_INDEX;
+			glGetUniformIndices(program, 1, &member.name, &uniform);
+			if (uniform == GL_INVALID_INDEX)
+			{
+				std::cout << "ERROR::UNIFORM_BLOCKS::MISSING_MEMBER " << block.name << "." << member.name << std::endl;
+				ok = false;
+				continue;
+			}
+			GLint offset = -1;
+			glGetActiveUniformsiv(program, 1, &uniform, GL_UNIFORM_OFFSET, &offset);
+			if ((size_t)offset != member.offset)
+			{
+				std::cout << "ERROR::UNIFORM_BLOCKS::OFFSET_MISMATCH " << block.name << "." << member.name << ": GL " << offset
+					<< ", struct " << member.offset << std::endl;
+				ok = false;
+			}
+		}
+		return ok;
+	}
+};
+#endif
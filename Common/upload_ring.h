@@ -0,0 +1,257 @@
+#ifndef UPLOAD_RING_H
+#define UPLOAD_RING_H
+
+#include <glad/glad.h>
+#include "gl_extensions.h"
+#include "gl_state.h"
+
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <iostream>
+
+// Upload Ring Declaration
+// One buffer for all per-frame dynamic data (uniform blocks, instance data,
+// streamed vertices), split into 'frames' regions used round robin. Each
+// frame writes into its own region, which is fenced at endFrame(); by the
+// time the ring comes back around to it, beginFrame() only has to check the
+// fence, and it waits (a stall, counted) only if the GPU is that far behind.
+// With ARB_buffer_storage the buffer is mapped once, persistent and
+// coherent, and allocations are written in place. Without it, allocations
+// point into a CPU staging copy and commit() sends them with glBufferSubData.
+// An allocation is only valid for the frame it was made in.
+
+class UploadRing
+{
+public:
+	struct Settings
+	{
+		size_t frameSize = 4 * 1024 * 1024; // bytes per frame region
+		int frames = 3;                     // regions, i.e. frames in flight
+	};
+
+	// Part of this frame's region; offset is from the start of the buffer
+	struct Allocation
+	{
+		unsigned char* data = NULL;
+		GLintptr offset = 0;
+		size_t size = 0;
+		GLuint buffer = 0;
+
+		bool valid() const { return data != NULL; }
+	};
+
+	struct Stats
+	{
+		unsigned long long frames = 0;
+		unsigned long long totalBytes = 0;
+		unsigned long long stalls = 0;    // beginFrame() had to wait on a fence
+		unsigned long long overflows = 0; // allocations that did not fit
+		double stallTime = 0.0;           // milliseconds spent waiting
+		size_t lastFrameBytes = 0;
+		size_t maxFrameBytes = 0;
+	};
+
+	UploadRing()
+		: UploadRing(Settings())
+	{
+	}
+
+	explicit UploadRing(const Settings& settings)
+		: settings(settings)
+	{
+		if (this->settings.frames < 1)
+			this->settings.frames = 1;
+		fences.assign(this->settings.frames, (GLsync)0);
+		create();
+	}
+
+	UploadRing(const UploadRing&) = delete;
+	UploadRing& operator=(const UploadRing&) = delete;
+
+	// Start writing into the next region, once the GPU is done reading it
+	// -------------------------------------------------------------------
+	void beginFrame()
+	{
+		frame = (frame + 1) % settings.frames;
+		frameOffset = 0;
+		GLsync& fence = fences[frame];
+		if (fence)
+		{
+			GLenum status = glClientWaitSync(fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			{
+				stats.stalls++;
+				auto start = std::chrono::steady_clock::now();
+				do
+				{
+					status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+				} while (status == GL_TIMEOUT_EXPIRED);
+				stats.stallTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			}
+			glDeleteSync(fence);
+			fence = 0;
+		}
+	}
+
+	// Fence what this frame wrote; call after its last draw
+	// -------------------------------------------------------------------
+	void endFrame()
+	{
+		fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		stats.frames++;
+		stats.lastFrameBytes = frameOffset;
+		stats.totalBytes += frameOffset;
+		if (frameOffset > stats.maxFrameBytes)
+			stats.maxFrameBytes = frameOffset;
+	}
+
+	// 'bytes' of this frame's region starting at a multiple of 'alignment'.
+	// Invalid (data == NULL) if the region is full. Write the data, then
+	// commit() it before drawing with it.
+	// -------------------------------------------------------------------
+	Allocation allocate(size_t bytes, size_t alignment = 16)
+	{
+		Allocation allocation;
+		size_t offset = (frameOffset + alignment - 1) / alignment * alignment;
+		if (offset + bytes > settings.frameSize)
+		{
+			stats.overflows++;
+			return allocation;
+		}
+		frameOffset = offset + bytes;
+		size_t start = (size_t)frame * settings.frameSize + offset;
+		allocation.data = (mapped ? mapped : staging.data()) + start;
+		allocation.offset = (GLintptr)start;
+		allocation.size = bytes;
+		allocation.buffer = buffer;
+		return allocation;
+	}
+
+	// Make an allocation's contents visible to GL (coherent mappings need nothing)
+	// -------------------------------------------------------------------
+	void commit(const Allocation& allocation)
+	{
+		if (mapped || !allocation.valid() || allocation.size == 0)
+			return;
+		GLState::instance().bufferSubData(buffer, GL_COPY_WRITE_BUFFER, allocation.offset, (GLsizeiptr)allocation.size, allocation.data);
+	}
+
+	// allocate + copy + commit
+	// -------------------------------------------------------------------
+	Allocation write(const void* data, size_t bytes, size_t alignment = 16)
+	{
+		Allocation allocation = allocate(bytes, alignment);
+		if (allocation.valid())
+		{
+			std::memcpy(allocation.data, data, bytes);
+			commit(allocation);
+		}
+		return allocation;
+	}
+
+	// Allocation for a uniform block (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+	// -------------------------------------------------------------------
+	Allocation allocateUniform(size_t bytes)
+	{
+		return allocate(bytes, uniformAlignment);
+	}
+
+	// Bind an allocation to a uniform block binding point
+	// -------------------------------------------------------------------
+	void bindUniform(GLuint index, const Allocation& allocation)
+	{
+		GLState::instance().bindBufferRange(GL_UNIFORM_BUFFER, index, buffer, allocation.offset, (GLsizeiptr)allocation.size);
+	}
+
+	size_t getUniformAlignment() const { return uniformAlignment; }
+	bool isPersistent() const { return mapped != NULL; }
+	GLuint getBuffer() const { return buffer; }
+	const Stats& getStats() const { return stats; }
+
+	// Bytes streamed and stalls
+	// -------------------------------------------------------------------
+	void printStats() const
+	{
+		std::cout << "UPLOAD_RING:: " << settings.frames << " x " << settings.frameSize / 1024 << " KB"
+			<< (mapped ? ", persistent mapping" : ", glBufferSubData") << ", frames: " << stats.frames
+			<< ", streamed: " << stats.totalBytes / 1024 << " KB (" << (stats.frames ? stats.totalBytes / stats.frames / 1024 : 0)
+			<< " KB/frame, max " << stats.maxFrameBytes / 1024 << " KB)\n"
+			<< "UPLOAD_RING:: stalls: " << stats.stalls << " (" << stats.stallTime << " ms), overflows: " << stats.overflows << std::endl;
+	}
+
+	// Delete the buffer and fences. Call while the context is still current.
+	// -------------------------------------------------------------------
+	void release()
+	{
+		for (size_t i = 0; i < fences.size(); i++)
+		{
+			if (fences[i])
+				glDeleteSync(fences[i]);
+			fences[i] = 0;
+		}
+		if (buffer)
+		{
+			GLState& state = GLState::instance();
+			if (mapped)
+			{
+				state.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+				glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			}
+			state.deleteBuffer(buffer);
+		}
+		buffer = 0;
+		mapped = NULL;
+		staging.clear();
+	}
+
+private:
+	Settings settings;
+	GLuint buffer = 0;
+	unsigned char* mapped = NULL;
+	std::vector<unsigned char> staging;
+	std::vector<GLsync> fences;
+	int frame = 0;
+	size_t frameOffset = 0;
+	size_t uniformAlignment = 256;
+	Stats stats;
+
+	// -------------------------------------------------------------------
+	void create()
+	{
+		typedef void (APIENTRYP BufferStorageProc)(GLenum, GLsizeiptr, const void*, GLbitfield);
+		BufferStorageProc bufferStorage = NULL;
+		if (GLExtensions::version(4, 4) || GLExtensions::has("GL_ARB_buffer_storage"))
+			bufferStorage = (BufferStorageProc)GLExtensions::getProcAddress("glBufferStorage");
+
+		GLint alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if (alignment > 0)
+			uniformAlignment = (size_t)alignment;
+
+		// bound to the copy target so no vertex array or uniform binding is touched
+		GLState& state = GLState::instance();
+		size_t size = settings.frameSize * settings.frames;
+		glGenBuffers(1, &buffer);
+		state.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		if (bufferStorage != NULL)
+		{
+			const GLbitfield flags = GL_MAP_WRITE_BIT | 0x0040 /* GL_MAP_PERSISTENT_BIT */ | 0x0080 /* GL_MAP_COHERENT_BIT */;
+			bufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, NULL, flags);
+			mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)size, flags));
+		}
+		if (mapped == NULL)
+		{
+			if (bufferStorage != NULL)
+			{
+				// immutable storage that would not map: start over with a mutable buffer
+				state.deleteBuffer(buffer);
+				glGenBuffers(1, &buffer);
+				state.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+			}
+			glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_DRAW);
+			staging.assign(size, 0);
+		}
+	}
+};
+#endif
@@ -0,0 +1,407 @@
+#ifndef VERTEX_COMPRESS_H
+#define VERTEX_COMPRESS_H
+
+#include <glad/glad.h>
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+// Vertex Compression Declaration
+// Packs interleaved float vertices into smaller attribute formats that the
+// vertex fetch expands back to floats for free:
+//   HALF     16-bit float (GL_HALF_FLOAT), ~3 significant digits
+//   SNORM16  signed normalized shorts, e.g. normals or positions in their box
+//   UNORM16  unsigned normalized shorts, e.g. texture coordinates
+//   UNORM8   unsigned normalized bytes, e.g. colors (RGB becomes RGBA8)
+// The normalized formats cover [-1, 1] / [0, 1]. Data outside that range,
+// or any attribute with fitBounds set, is stored relative to its bounding
+// box instead; the shader then has to apply value * scale + bias (for a
+// position that fits in the model matrix, see decodeMatrix()). A HALF
+// attribute with fitBounds is mapped onto [-1, 1], where half floats are
+// densest, e.g. a mesh far from the origin; FLOAT32 ignores fitBounds.
+// Every attribute starts on a 4 byte boundary, so 3-component 16-bit
+// attributes take 8 bytes.
+
+class VertexCompress
+{
+public:
+	enum Encoding
+	{
+		FLOAT32,
+		HALF,
+		SNORM16,
+		UNORM16,
+		UNORM8
+	};
+
+	// One attribute of the source layout, in order
+	struct Attribute
+	{
+		int components;
+		Encoding encoding;
+		bool fitBounds; // quantize within the bounding box (more precision)
+
+		Attribute(int components, Encoding encoding, bool fitBounds = false)
+			: components(components), encoding(encoding), fitBounds(fitBounds)
+		{
+		}
+	};
+
+	// Where an attribute ended up and how to read it back
+	struct AttributeLayout
+	{
+		Encoding encoding;
+		int sourceComponents;
+		int components;      // passed to glVertexAttribPointer
+		GLenum type;
+		GLboolean normalized;
+		size_t offset;       // bytes into the vertex
+		size_t size;         // bytes, padded to a multiple of 4
+		float scale[4];      // decoded = value * scale + bias
+		float bias[4];
+
+		bool needsDecode() const
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				if (scale[c] != 1.0f || bias[c] != 0.0f)
+					return true;
+			}
+			return false;
+		}
+	};
+
+	// Largest and root mean square error of an attribute's components
+	struct AttributeError
+	{
+		float maxError = 0.0f;
+		float rmsError = 0.0f;
+	};
+
+	struct Encoded
+	{
+		std::vector<unsigned char> data;
+		std::vector<AttributeLayout> attributes;
+		std::vector<AttributeError> errors;
+		size_t vertexCount = 0;
+		size_t stride = 0;       // bytes per encoded vertex
+		size_t sourceStride = 0; // bytes per float vertex
+	};
+
+	// Encode 'vertexCount' vertices laid out as 'attributes' (floats,
+	// interleaved, no padding)
+	// -------------------------------------------------------------------
+	static Encoded encode(const float* vertices, size_t vertexCount, const std::vector<Attribute>& attributes)
+	{
+		Encoded result;
+		result.vertexCount = vertexCount;
+		size_t sourceFloats = 0;
+		for (size_t a = 0; a < attributes.size(); a++)
+		{
+			AttributeLayout layout = plan(vertices, vertexCount, attributes, a, sourceFloats);
+			layout.offset = result.stride;
+			result.stride += layout.size;
+			result.attributes.push_back(layout);
+			sourceFloats += attributes[a].components;
+		}
+		result.sourceStride = sourceFloats * sizeof(float);
+
+		result.data.assign(result.stride * vertexCount, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			const float* source = vertices + v * sourceFloats;
+			unsigned char* target = &result.data[v * result.stride];
+			for (size_t a = 0; a < result.attributes.size(); a++)
+			{
+				const AttributeLayout& layout = result.attributes[a];
+				write(layout, source, target + layout.offset);
+				source += layout.sourceComponents;
+			}
+		}
+		measureErrors(vertices, result);
+		return result;
+	}
+
+	// glVertexAttribPointer/glEnableVertexAttribArray for every attribute,
+	// at locations firstLocation, firstLocation + 1, ... Bind the VAO and
+	// the buffer holding the encoded data first.
+	// -------------------------------------------------------------------
+	static void setupAttributes(const Encoded& encoded, GLuint firstLocation = 0, size_t bufferOffset = 0)
+	{
+		for (size_t a = 0; a < encoded.attributes.size(); a++)
+		{
+			const AttributeLayout& layout = encoded.attributes[a];
+			GLuint location = firstLocation + (GLuint)a;
+			glVertexAttribPointer(location, layout.components, layout.type, layout.normalized, (GLsizei)encoded.stride,
+				(void*)(bufferOffset + layout.offset));
+			glEnableVertexAttribArray(location);
+		}
+	}
+
+	// Column-major matrix that undoes a position attribute's box mapping;
+	// multiply the model matrix by it (identity if nothing to undo)
+	// -------------------------------------------------------------------
+	static void decodeMatrix(const AttributeLayout& layout, float matrix[16])
+	{
+		std::fill(matrix, matrix + 16, 0.0f);
+		for (int c = 0; c < 3; c++)
+		{
+			matrix[c * 5] = layout.scale[c];
+			matrix[12 + c] = layout.bias[c];
+		}
+		matrix[15] = 1.0f;
+	}
+
+	// Decode one attribute of one vertex back to floats
+	// -------------------------------------------------------------------
+	static void decode(const Encoded& encoded, size_t vertex, size_t attribute, float* values)
+	{
+		const AttributeLayout& layout = encoded.attributes[attribute];
+		const unsigned char* source = &encoded.data[vertex * encoded.stride + layout.offset];
+		for (int c = 0; c < layout.sourceComponents; c++)
+		{
+			float value = 0.0f;
+			switch (layout.encoding)
+			{
+			case FLOAT32: std::memcpy(&value, source + c * 4, 4); break;
+			case HALF: value = halfToFloat(load<uint16_t>(source + c * 2)); break;
+			case SNORM16: value = std::max(load<int16_t>(source + c * 2) / 32767.0f, -1.0f); break;
+			case UNORM16: value = load<uint16_t>(source + c * 2) / 65535.0f; break;
+			case UNORM8: value = source[c] / 255.0f; break;
+			}
+			values[c] = value * layout.scale[c] + layout.bias[c];
+		}
+	}
+
+	// Round to nearest even, overflow to infinity, keeps denormals
+	// -------------------------------------------------------------------
+	static uint16_t floatToHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, 4);
+		uint32_t sign = (bits >> 16) & 0x8000u;
+		uint32_t magnitude = bits & 0x7FFFFFFFu;
+		if (magnitude >= 0x7F800000u)
+			return (uint16_t)(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x0200u : 0u));
+		if (magnitude >= 0x477FF000u)
+			return (uint16_t)(sign | 0x7C00u);
+
+		uint32_t half;
+		uint32_t remainder;
+		uint32_t midpoint;
+		if (magnitude < 0x38800000u)
+		{
+			// half denormal: the value in units of 2^-24
+			if (magnitude < 0x33000000u)
+				return (uint16_t)sign;
+			uint32_t exponent = magnitude >> 23;
+			uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+			uint32_t shift = 126 - exponent;
+			half = mantissa >> shift;
+			remainder = mantissa & ((1u << shift) - 1);
+			midpoint = 1u << (shift - 1);
+		}
+		else
+		{
+			half = (magnitude - 0x38000000u) >> 13;
+			remainder = magnitude & 0x1FFFu;
+			midpoint = 0x1000u;
+		}
+		if (remainder > midpoint || (remainder == midpoint && (half & 1)))
+			half++;
+		return (uint16_t)(sign | half);
+	}
+
+	// -------------------------------------------------------------------
+	static float halfToFloat(uint16_t half)
+	{
+		uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+		uint32_t exponent = (half >> 10) & 0x1Fu;
+		uint32_t mantissa = half & 0x3FFu;
+		uint32_t bits;
+		if (exponent == 0x1F)
+		{
+			bits = sign | 0x7F800000u | (mantissa << 13);
+		}
+		else if (exponent != 0)
+		{
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		}
+		else
+		{
+			float value = mantissa * (1.0f / 16777216.0f);
+			return sign ? -value : value;
+		}
+		float value;
+		std::memcpy(&value, &bits, 4);
+		return value;
+	}
+
+	static const char* name(Encoding encoding)
+	{
+		switch (encoding)
+		{
+		case HALF: return "half";
+		case SNORM16: return "snorm16";
+		case UNORM16: return "unorm16";
+		case UNORM8: return "unorm8";
+		default: return "float";
+		}
+	}
+
+	// Size comparison and per-attribute error
+	// -------------------------------------------------------------------
+	static void printReport(const char* label, const Encoded& encoded)
+	{
+		size_t sourceBytes = encoded.sourceStride * encoded.vertexCount;
+		size_t bytes = encoded.stride * encoded.vertexCount;
+		std::cout << "VERTEX_COMPRESS:: " << label << ": " << encoded.vertexCount << " vertices, " << encoded.sourceStride << " -> "
+			<< encoded.stride << " bytes per vertex, " << sourceBytes << " -> " << bytes << " bytes ("
+			<< (sourceBytes ? 100.0 * bytes / sourceBytes : 0.0) << "%)\n";
+		for (size_t a = 0; a < encoded.attributes.size(); a++)
+		{
+			const AttributeLayout& layout = encoded.attributes[a];
+			std::cout << "VERTEX_COMPRESS::   attribute " << a << ": " << layout.sourceComponents << " x " << name(layout.encoding)
+				<< (layout.needsDecode() ? " (scale/bias)" : "") << ", max error " << encoded.errors[a].maxError
+				<< ", rms error " << encoded.errors[a].rmsError << "\n";
+		}
+		std::cout << std::flush;
+	}
+
+private:
+	// Pick type, size and the value mapping for attribute 'index'
+	// -------------------------------------------------------------------
+	static AttributeLayout plan(const float* vertices, size_t vertexCount, const std::vector<Attribute>& attributes, size_t index, size_t first)
+	{
+		const Attribute& attribute = attributes[index];
+		size_t sourceFloats = 0;
+		for (size_t a = 0; a < attributes.size(); a++)
+		{
+			sourceFloats += attributes[a].components;
+		}
+
+		AttributeLayout layout;
+		layout.encoding = attribute.encoding;
+		layout.sourceComponents = attribute.components;
+		layout.components = attribute.components;
+		layout.normalized = GL_TRUE;
+		layout.offset = 0;
+		for (int c = 0; c < 4; c++)
+		{
+			layout.scale[c] = 1.0f;
+			layout.bias[c] = 0.0f;
+		}
+
+		size_t componentSize = 4;
+		switch (attribute.encoding)
+		{
+		case FLOAT32: layout.type = GL_FLOAT; layout.normalized = GL_FALSE; break;
+		case HALF: layout.type = GL_HALF_FLOAT; layout.normalized = GL_FALSE; componentSize = 2; break;
+		case SNORM16: layout.type = GL_SHORT; componentSize = 2; break;
+		case UNORM16: layout.type = GL_UNSIGNED_SHORT; componentSize = 2; break;
+		case UNORM8: layout.type = GL_UNSIGNED_BYTE; componentSize = 1; break;
+		}
+		// RGB bytes get an opaque alpha so the 4th byte is not just padding
+		if (attribute.encoding == UNORM8 && attribute.components == 3)
+			layout.components = 4;
+		layout.size = (layout.components * componentSize + 3) & ~(size_t)3;
+
+		// half floats cover any range, they only gain precision from a fit
+		if (attribute.encoding == FLOAT32 || (attribute.encoding == HALF && !attribute.fitBounds))
+			return layout;
+
+		float low = attribute.encoding == SNORM16 || attribute.encoding == HALF ? -1.0f : 0.0f;
+		for (int c = 0; c < attribute.components; c++)
+		{
+			float minimum = 0.0f;
+			float maximum = 0.0f;
+			for (size_t v = 0; v < vertexCount; v++)
+			{
+				float value = vertices[v * sourceFloats + first + c];
+				minimum = v == 0 || value < minimum ? value : minimum;
+				maximum = v == 0 || value > maximum ? value : maximum;
+			}
+			if (!attribute.fitBounds && minimum >= low && maximum <= 1.0f)
+				continue;
+			// map [minimum, maximum] onto [low, 1]
+			float extent = maximum > minimum ? maximum - minimum : 1.0f;
+			layout.scale[c] = extent / (1.0f - low);
+			layout.bias[c] = minimum - low * layout.scale[c];
+		}
+		return layout;
+	}
+
+	// -------------------------------------------------------------------
+	static void write(const AttributeLayout& layout, const float* source, unsigned char* target)
+	{
+		for (int c = 0; c < layout.components; c++)
+		{
+			if (c >= layout.sourceComponents)
+			{
+				// alpha of an RGB color
+				target[c] = 255;
+				continue;
+			}
+			float value = (source[c] - layout.bias[c]) / layout.scale[c];
+			switch (layout.encoding)
+			{
+			case FLOAT32: std::memcpy(target + c * 4, &value, 4); break;
+			case HALF: store<uint16_t>(target + c * 2, floatToHalf(value)); break;
+			case SNORM16: store<int16_t>(target + c * 2, (int16_t)quantize(value, -1.0f, 32767.0f)); break;
+			case UNORM16: store<uint16_t>(target + c * 2, (uint16_t)quantize(value, 0.0f, 65535.0f)); break;
+			case UNORM8: target[c] = (unsigned char)quantize(value, 0.0f, 255.0f); break;
+			}
+		}
+	}
+
+	static long quantize(float value, float low, float steps)
+	{
+		return std::lround(std::min(std::max(value, low), 1.0f) * steps);
+	}
+
+	// -------------------------------------------------------------------
+	static void measureErrors(const float* vertices, Encoded& encoded)
+	{
+		size_t sourceFloats = encoded.sourceStride / sizeof(float);
+		encoded.errors.assign(encoded.attributes.size(), AttributeError());
+		size_t first = 0;
+		for (size_t a = 0; a < encoded.attributes.size(); a++)
+		{
+			int components = encoded.attributes[a].sourceComponents;
+			double sum = 0.0;
+			float decoded[4];
+			for (size_t v = 0; v < encoded.vertexCount; v++)
+			{
+				decode(encoded, v, a, decoded);
+				for (int c = 0; c < components; c++)
+				{
+					float error = std::fabs(decoded[c] - vertices[v * sourceFloats + first + c]);
+					encoded.errors[a].maxError = std::max(encoded.errors[a].maxError, error);
+					sum += (double)error * error;
+				}
+			}
+			size_t count = encoded.vertexCount * components;
+			encoded.errors[a].rmsError = count ? (float)std::sqrt(sum / count) : 0.0f;
+			first += components;
+		}
+	}
+
+	template <typename T>
+	static T load(const unsigned char* source)
+	{
+		T value;
+		std::memcpy(&value, source, sizeof(T));
+		return value;
+	}
+
+	template <typename T>
+	static void store(unsigned char* target, T value)
+	{
+		std::memcpy(target, &value, sizeof(T));
+	}
+};
+#endif
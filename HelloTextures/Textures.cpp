@@ -8,11 +8,17 @@
 // -------------------------------------------------------------------------------
 
 #include "shader.h"
+#include "../Common/app_window.h"
 #include "stb_image.h"
+#include "../Common/shader_watcher.h"
+#include "../Common/frame_timer.h"
+#include "../Common/profiler.h"
+#include "../Common/texture_packer.h"
+#include "../Common/vertex_compress.h"
 
-void processInput(GLFWwindow* window);
+void processInput(AppWindow& window);
 
-int main()
+int main(int argc, char** argv)
 {
 	// Error Check Variables
 	int success;
@@ -22,34 +28,23 @@ int main()
 	const unsigned int SRC_WIDTH = 800;
 	const unsigned int SRC_HEIGHT = 600;
 
-	// Initialize GLFW
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	// Create Window
-	GLFWwindow* window = glfwCreateWindow(SRC_WIDTH, SRC_HEIGHT, "LearnOpenGL", NULL, NULL);
-	if (window == NULL)
+	// Window, or with --headless / GL_HEADLESS=1 an offscreen context that
+	// runs a fixed number of frames (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	if (!window.open("LearnOpenGL", SRC_WIDTH, SRC_HEIGHT))
 	{
-		std::cout << "Failed to create window" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-
-	// Set window to current context
-	glfwMakeContextCurrent(window);
-
-	// GLAD: Load all OpenGL function pointers
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-	{
-		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
 	}
 
 	// Shader initialization
 	Shader myShader("shader.vs", "shader.fs");
 
+	// Rebuild shader.vs/shader.fs in the background whenever they are saved
+	ShaderWatcher watcher(window);
+	watcher.watch(myShader);
+	watcher.start();
+	FrameTimer frameTimer;
+
 	// Triangle Vertices
 	float vertices[] =
 	{
@@ -67,73 +62,15 @@ int main()
 	// stbi settings
 	stbi_set_flip_vertically_on_load(true);
 
-	// ------------------------------ TEXTURE 1 ------------------------------
-	// Texture file reading
-	int width, height, nrChannels;
-	unsigned char* data = stbi_load("container.jpg", &width, &height, &nrChannels, 0);
-
-	// Texture generation (currently empty)
-	unsigned int texture0;
-	glGenTextures(1, &texture0);
-
-	// Bind texture
-	glBindTexture(GL_TEXTURE_2D, texture0);
-
-	// Configure texture wrapping parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	// set texture wrapping to GL_REPEAT (default wrapping method)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// set texture filtering parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Generate texture
-	if (data)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
-
-	// Free up memory from texture import
-	stbi_image_free(data);
-
-	// ------------------------------ TEXTURE 2 ------------------------------
-	// Texture file reading
-	data = stbi_load("awesomeface.png", &width, &height, &nrChannels, 0);
-
-	// Texture generation (currently empty)
-	unsigned int texture1;
-	glGenTextures(1, &texture1);
-
-	// Bind texture
-	glBindTexture(GL_TEXTURE_2D, texture1);
-
-	// Configure texture wrapping parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	// set texture wrapping to GL_REPEAT (default wrapping method)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// set texture filtering parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Generate texture
-	if (data)
-	{	
-		// (.PNG image uses RGBA, not RGB)
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
-
-	// Free up memory from texture import
-	stbi_image_free(data);
+	// ------------------------------ TEXTURES ------------------------------
+	// Both images go into one texture array with a shared sampler, so the
+	// render loop binds a single texture no matter how many it samples.
+	// The layers are decoded in the background and uploaded by update() in
+	// the render loop; startup only reads the image headers.
+	TexturePacker packer;
+	int texture0 = packer.add("container.jpg");
+	int texture1 = packer.add("awesomeface.png");
+	packer.buildAsync();
 
 	// Create VAO, VBO, and EBO
 	unsigned int VAO;
@@ -147,59 +84,102 @@ int main()
 	glBindVertexArray(VAO);
 	
 
+	// Half float positions, RGBA8 colors and 16-bit uvs: 16 bytes per
+	// vertex instead of 32 (all in range, so the shader needs no decode)
+	VertexCompress::Encoded quad = VertexCompress::encode(vertices, 4, { VertexCompress::Attribute(3, VertexCompress::HALF),
+		VertexCompress::Attribute(3, VertexCompress::UNORM8), VertexCompress::Attribute(2, VertexCompress::UNORM16) });
+	VertexCompress::printReport("quad", quad);
+
 	// Bind and set VBO
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, quad.data.size(), quad.data.data(), GL_STATIC_DRAW);
 
 	// Bind and set EBO
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-	// Set vertex attribute pointers
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
+	// Set vertex attribute pointers (locations 0, 1, 2)
+	VertexCompress::setupAttributes(quad);
 
 	// Use shader program
 	myShader.use();
 
-	// Specifiy texture units to shader samplers
-	myShader.setInt("texture0", 0);
-	myShader.setInt("texture1", 1);
+	// Specifiy texture unit and where each texture sits in the array
+	const TexturePacker::Region& region0 = packer.getRegion(texture0);
+	const TexturePacker::Region& region1 = packer.getRegion(texture1);
+	myShader.setInt("textures", 0);
+	myShader.setVec4(myShader.getUniform("region0"), region0.scale[0], region0.scale[1], region0.offset[0], region0.offset[1]);
+	myShader.setVec4(myShader.getUniform("region1"), region1.scale[0], region1.scale[1], region1.offset[0], region1.offset[1]);
+	myShader.setFloat("layer0", (float)region0.layer);
+	myShader.setFloat("layer1", (float)region1.layer);
+	packer.bind(0);
 
 	// RENDER LOOP
-	while (!glfwWindowShouldClose(window)) {
+	while (!window.shouldClose()) {
+
+		// Zones are timed only when the profiler is on (LEARNOPENGL_PROFILE=1)
+		Profiler::instance().beginFrame();
+
+		// Swap in shaders that finished rebuilding (frame boundary)
+		{
+			PROFILE_SCOPE("update");
+			if (watcher.applyPending() > 0)
+				frameTimer.markEvent();
+			// upload the texture layers that finished decoding
+			if (!packer.isComplete())
+			{
+				packer.update();
+				if (packer.isComplete())
+					packer.printStats();
+			}
+		}
 
 		// Input
-		processInput(window);
-
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-
-		// Texture activation
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture0);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, texture1);
-
-		// Render container
-		myShader.use();
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		{
+			PROFILE_SCOPE("input");
+			processInput(window);
+		}
+
+		GLState& state = GLState::instance();
+		{
+			PROFILE_SCOPE("draw");
+			PROFILE_GPU_SCOPE("draw");
+			state.clearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			// Texture activation: one array for the whole scene
+			packer.bind(0);
+
+			// Render container
+			myShader.use();
+			state.bindVertexArray(VAO);
+			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		}
+		{
+			PROFILE_SCOPE("swap");
+			window.swapBuffers();
+		}
+		frameTimer.tick();
+		state.endFrame();
+		Profiler::instance().endFrame();
 	}
-	glfwTerminate();
-	return 0;
+	watcher.stop();
+	frameTimer.printStats("shader reload");
+	packer.release();
+	SamplerCache::instance().clear();
+	// Report how much compile time the program binary cache saved
+	ProgramCache::instance().printStats();
+	GLState::instance().printStats();
+	Profiler::instance().shutdown();
+	window.close();
+	// non-zero after a --benchmark run slower than its baseline
+	return window.exitCode();
 }
 
-void processInput(GLFWwindow* window)
+void processInput(AppWindow& window)
 {
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	if (window.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS)
 	{
-		glfwSetWindowShouldClose(window, true);
+		window.setShouldClose(true);
 	}
 }
\ No newline at end of file
@@ -4,10 +4,20 @@ out vec4 FragColor;
 in vec3 ourColor;
 in vec2 TexCoord;
 
-uniform sampler2D texture0;
-uniform sampler2D texture1;
+// Both textures live in one array (see TexturePacker): each has a layer and
+// a uv scale (xy) and offset (zw) within it
+uniform sampler2DArray textures;
+uniform vec4 region0;
+uniform vec4 region1;
+uniform float layer0;
+uniform float layer1;
+
+vec4 sampleRegion(vec4 region, float layer)
+{
+    return texture(textures, vec3(TexCoord * region.xy + region.zw, layer));
+}
 
 void main()
 {
-    FragColor = mix(texture(texture0, TexCoord), texture(texture1, TexCoord), 0.2) * vec4(ourColor, 1.0);
+    FragColor = mix(sampleRegion(region0, layer0), sampleRegion(region1, layer1), 0.2) * vec4(ourColor, 1.0);
 }
\ No newline at end of file
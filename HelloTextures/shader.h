@@ -1,182 +1,7 @@
-#ifndef SHADER_H
-#define SHADER_H
+#ifndef TEXTURES_SHADER_H
+#define TEXTURES_SHADER_H
 
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-//#include <glm/glm.hpp>
+// The Shader class is shared between projects (see Common/shader.h)
+#include "../Common/shader.h"
 
-#include <string>
-#include <iostream>
-#include <fstream>
-#include <sstream>
-
-// Shader Declaration
-
-class Shader 
-{
-public:
-	// the program ID
-	unsigned int ID;
-
-	// Shader Constuctor: Reads and builds relevant shaders
-	// -------------------------------------------------------------------
-	Shader(const char* vertexPath, const char* fragmentPath)
-	{
-		// 1. retrieve the vertex/fragment source code from filePath
-		std::string vertexCode;
-		std::string fragmentCode;
-		std::ifstream vShaderFile;
-		std::ifstream fShaderFile;
-
-		// ensure ifstream objects can throw exceptions:
-		vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-		fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-		try
-		{
-			// open files
-			vShaderFile.open(vertexPath);
-			fShaderFile.open(fragmentPath);
-			std::stringstream vShaderStream;
-			std::stringstream fShaderStream;
-			// read file's buffer contents into streams
-			vShaderStream << vShaderFile.rdbuf();
-			fShaderStream << fShaderFile.rdbuf();
-			// close file handlers
-			vShaderFile.close();
-			fShaderFile.close();
-			// convert stream into string
-			vertexCode = vShaderStream.str();
-			fragmentCode = fShaderStream.str();
-		}
-		catch (std::ifstream::failure e)
-		{
-			std::cout << "ERROR::SHADER::FILE_FAILED_TO_READ" << std::endl;
-		}
-		// shader pointers
-		const char* vShaderCode = vertexCode.c_str();
-		const char* fShaderCode = fragmentCode.c_str();
-
-		// 2. compile shaders
-		unsigned int vertex;
-		unsigned int fragment;
-		int success;
-		char infoLog[512];
-
-		// vertex shader
-		vertex = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex, 1, &vShaderCode, NULL);
-		glCompileShader(vertex);
-		checkCompileErrors(vertex, "VERTEX");
-
-		// fragment shader
-		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment, 1, &fShaderCode, NULL);
-		glCompileShader(fragment);
-		checkCompileErrors(vertex, "FRAGMENT");
-
-		// shader program
-		ID = glCreateProgram();
-		glAttachShader(ID, vertex);
-		glAttachShader(ID, fragment);
-		glLinkProgram(ID);
-		checkCompileErrors(ID, "PROGRAM");
-		// delete shaders as they're linked into our program now and no longer necessary
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
-	}
-
-	// Shader Activation Function
-	// -------------------------------------------------------------------
-	void use()
-	{
-		glUseProgram(ID);
-	}
-
-	// Utility Uniform Functions
-	// -------------------------------------------------------------------
-	void setBool(const std::string& name, bool value) const
-	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
-	}
-	// -------------------------------------------------------------------
-	void setInt(const std::string& name, bool value) const
-	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
-	}
-	// -------------------------------------------------------------------
-	void setFloat(const std::string& name, bool value) const
-	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
-	}
-	// -------------------------------------------------------------------
-	//void setVec2(const std::string& name, const glm::vec2& value) const
-	//{
-	//	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-	//}
-	//void setVec2(const std::string& name, float x, float y) const
-	//{
-	//	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
-	//}
-	//// ------------------------------------------------------------------------
-	//void setVec3(const std::string& name, const glm::vec3& value) const
-	//{
-	//	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-	//}
-	//void setVec3(const std::string& name, float x, float y, float z) const
-	//{
-	//	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
-	//}
-	//// ------------------------------------------------------------------------
-	//void setVec4(const std::string& name, const glm::vec4& value) const
-	//{
-	//	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-	//}
-	//void setVec4(const std::string& name, float x, float y, float z, float w)
-	//{
-	//	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
-	//}
-	//// ------------------------------------------------------------------------
-	//void setMat2(const std::string& name, const glm::mat2& mat) const
-	//{
-	//	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-	//}
-	//// ------------------------------------------------------------------------
-	//void setMat3(const std::string& name, const glm::mat3& mat) const
-	//{
-	//	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-	//}
-	//// ------------------------------------------------------------------------
-	//void setMat4(const std::string& name, const glm::mat4& mat) const
-	//{
-	//	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-	//}
-
-private:
-	// Utility function for checking shader compilation/linking errors
-	// -------------------------------------------------------------------
-	void checkCompileErrors(GLuint shader, std::string type)
-	{
-		GLint success;
-		GLchar infoLog[1024];
-		if (type != "PROGRAM")
-		{
-			glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-			if (!success)
-			{
-				glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-				std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n" << "***" << std::endl;
-			}
-		}
-		else
-		{
-			glGetProgramiv(shader, GL_LINK_STATUS, &success);
-			if (!success)
-			{
-				glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-				std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n" << "***" << std::endl;
-			}
-		}
-	}
-};
-#endif
\ No newline at end of file
+#endif
@@ -1,37 +1,23 @@
 #include "shader.h"
+#include "../../Common/app_window.h"
+#include "../../Common/profiler.h"
+#include "../../Common/gl_state.h"
+#include "../../Common/mesh_optimizer.h"
 
 // Function Definitions
-void processInput(GLFWwindow* window);
+void processInput(AppWindow& window);
 
-int main() 
+int main(int argc, char** argv)
 {
 	// Window Settings
 	const unsigned int SRC_WIDTH = 800;
 	const unsigned int SRC_HEIGHT = 600;
 
-	// GLFW Initialization
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	// Create window
-	GLFWwindow* window = glfwCreateWindow(SRC_WIDTH, SRC_HEIGHT, "LearnOpenGL", NULL, NULL);
-	if (window == NULL)
-	{
-		std::cout << "Failed to create window" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-
-	// Set window to current context
-	glfwMakeContextCurrent(window);
-
-	// GLAD Initialization
-	// (NOTE: GLAD can only be initialized after window creation + context!)
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	// Window, or with --headless / GL_HEADLESS=1 an offscreen context that
+	// runs a fixed number of frames (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	if (!window.open("LearnOpenGL", SRC_WIDTH, SRC_HEIGHT))
 	{
-		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
 	}
 
@@ -94,16 +80,28 @@ int main()
 		 0.5f, -0.5f,  0.0f
 	};
 
-	// Vertex Buffer Object (VBO)
-	unsigned int VBO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	// Weld the box into an indexed mesh ordered for the post-transform
+	// vertex cache, and report how many vertex shader runs that saves
+	MeshOptimizer::Mesh box = MeshOptimizer::optimize(vertices, sizeof(vertices) / (3 * sizeof(float)), 3);
+	MeshOptimizer::printStats("box (glDrawArrays)", MeshOptimizer::analyzeUnindexed(36));
+	MeshOptimizer::printStats("box (optimized)", MeshOptimizer::analyzeVertexCache(box));
 
 	// Vertex Array Object (VAO)
 	unsigned int VAO;
 	glGenVertexArrays(1, &VAO);
 	glBindVertexArray(VAO);
+
+	// Vertex Buffer Object (VBO)
+	unsigned int VBO;
+	glGenBuffers(1, &VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, box.vertices.size() * sizeof(float), box.vertices.data(), GL_STATIC_DRAW);
+
+	// Element Buffer Object (EBO), recorded in the VAO
+	unsigned int EBO;
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, box.indices.size() * sizeof(unsigned int), box.indices.data(), GL_STATIC_DRAW);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 
@@ -111,32 +109,47 @@ int main()
 	myShader.use();
 
 	// RENDER LOOP
-	while (!glfwWindowShouldClose(window))
+	while (!window.shouldClose())
 	{
-		// Input
-		processInput(window);
+		// Zones are timed only when the profiler is on (LEARNOPENGL_PROFILE=1)
+		Profiler::instance().beginFrame();
 
-		// Screen Color
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-
-		// Render Calls
-		myShader.use();
-		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		// Input
+		{
+			PROFILE_SCOPE("input");
+			processInput(window);
+		}
+
+		{
+			PROFILE_SCOPE("draw");
+			PROFILE_GPU_SCOPE("draw");
+			// Screen Color
+			GLState::instance().clearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			// Render Calls
+			myShader.use();
+			glBindVertexArray(VAO);
+			glDrawElements(GL_TRIANGLES, (GLsizei)box.indices.size(), GL_UNSIGNED_INT, 0);
+		}
 		// Swap buffers and poll events
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		{
+			PROFILE_SCOPE("swap");
+			window.swapBuffers();
+		}
+		Profiler::instance().endFrame();
 	}
 
+	Profiler::instance().shutdown();
 
-	return 0;
+	// non-zero after a --benchmark run slower than its baseline
+	return window.exitCode();
 }
 
-void processInput(GLFWwindow* window)
+void processInput(AppWindow& window)
 {
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	if (window.getKey(GLFW_KEY_ESCAPE) == GLFW_PRESS)
 	{
-		glfwSetWindowShouldClose(window, true);
+		window.setShouldClose(true);
 	}
 }
\ No newline at end of file
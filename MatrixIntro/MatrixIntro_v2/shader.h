@@ -76,7 +76,7 @@ public:
 		fragment = glCreateShader(GL_FRAGMENT_SHADER);
 		glShaderSource(fragment, 1, &fShaderCode, NULL);
 		glCompileShader(fragment);
-		checkCompileErrors(vertex, "FRAGMENT");
+		checkCompileErrors(fragment, "FRAGMENT");
 
 		// shader program
 		ID = glCreateProgram();
@@ -1,43 +1,63 @@
 #include "shader.h"
+#include "../../Common/app_window.h"
+#include "../../Common/shader_watcher.h"
+#include "../../Common/frame_timer.h"
+#include "../../Common/profiler.h"
+#include "../../Common/input_queue.h"
+#include "../../Common/texture_streamer.h"
+#include "../../Common/mesh_optimizer.h"
+#include "../../Common/vertex_compress.h"
+
+// Input Actions
+enum Action
+{
+	QUIT,
+	CLEAR_RED,
+	CLEAR_ORANGE,
+	CLEAR_YELLOW,
+	CLEAR_GREEN,
+	CLEAR_BLUE,
+	CLEAR_PURPLE
+};
+
+// Key Bindings (rebinding a key only changes this table)
+static const InputQueue::Binding keyBindings[] =
+{
+	{ GLFW_KEY_ESCAPE, QUIT, InputQueue::PRESS },
+	{ GLFW_KEY_1, CLEAR_RED, InputQueue::PRESS },
+	{ GLFW_KEY_2, CLEAR_ORANGE, InputQueue::PRESS },
+	{ GLFW_KEY_3, CLEAR_YELLOW, InputQueue::PRESS },
+	{ GLFW_KEY_4, CLEAR_GREEN, InputQueue::PRESS },
+	{ GLFW_KEY_5, CLEAR_BLUE, InputQueue::PRESS },
+	{ GLFW_KEY_6, CLEAR_PURPLE, InputQueue::PRESS }
+};
 
 // Function Definitions
-void processInput(GLFWwindow* window);
+void processInput(AppWindow& window, InputQueue& input);
 
-int main() 
+int main(int argc, char** argv)
 {
 	// Window Settings
 	const unsigned int SRC_WIDTH = 800;
 	const unsigned int SRC_HEIGHT = 600;
 
-	// GLFW Initialization
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	// Create window
-	GLFWwindow* window = glfwCreateWindow(SRC_WIDTH, SRC_HEIGHT, "LearnOpenGL", NULL, NULL);
-	if (window == NULL)
+	// Window, or with --headless / GL_HEADLESS=1 an offscreen context that
+	// runs a fixed number of frames (see Common/app_window.h)
+	AppWindow window(argc, argv);
+	if (!window.open("LearnOpenGL", SRC_WIDTH, SRC_HEIGHT))
 	{
-		std::cout << "Failed to create window" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-
-	// Set window to current context
-	glfwMakeContextCurrent(window);
-
-	// GLAD Initialization
-	// (NOTE: GLAD can only be initialized after window creation + context!)
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-	{
-		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
 	}
 
 	// Shader initialization
 	Shader myShader("shader.vs", "shader.fs");
 
+	// Rebuild shader.vs/shader.fs in the background whenever they are saved
+	ShaderWatcher watcher(window);
+	watcher.watch(myShader);
+	watcher.start();
+	FrameTimer frameTimer;
+
 	// UNOPTIMIZED BOX:
 	// 36 Vertices
 	// 12 Triangles
@@ -94,52 +114,45 @@ int main()
 		 0.5f, -0.5f,  0.5f,  1.0f,  0.0f   // Bottom Right
 	};
 
-	// Vertex Buffer Object (VBO)
-	unsigned int VBO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	// Weld the box into an indexed mesh ordered for the post-transform
+	// vertex cache, and report how many vertex shader runs that saves
+	MeshOptimizer::Mesh box = MeshOptimizer::optimize(vertices, sizeof(vertices) / (5 * sizeof(float)), 5);
+	MeshOptimizer::printStats("box (glDrawArrays)", MeshOptimizer::analyzeUnindexed(36));
+	MeshOptimizer::printStats("box (optimized)", MeshOptimizer::analyzeVertexCache(box));
+
+	// Half float positions and 16-bit uvs (exact for this box): 12 bytes
+	// per vertex instead of 20
+	VertexCompress::Encoded boxVertices = VertexCompress::encode(box.vertices.data(), box.vertexCount(),
+		{ VertexCompress::Attribute(3, VertexCompress::HALF), VertexCompress::Attribute(2, VertexCompress::UNORM16) });
+	VertexCompress::printReport("box", boxVertices);
 
 	// Vertex Array Object (VAO)
 	unsigned int VAO;
 	glGenVertexArrays(1, &VAO);
 	glBindVertexArray(VAO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
+
+	// Vertex Buffer Object (VBO)
+	unsigned int VBO;
+	glGenBuffers(1, &VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, boxVertices.data.size(), boxVertices.data.data(), GL_STATIC_DRAW);
+
+	// Element Buffer Object (EBO), recorded in the VAO
+	unsigned int EBO;
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, box.indices.size() * sizeof(unsigned int), box.indices.data(), GL_STATIC_DRAW);
+	VertexCompress::setupAttributes(boxVertices);
 
 	// TEXTURE INITIALIZATION
 
 	// stbi settings
 	stbi_set_flip_vertically_on_load(true);
 
-	// Read texture file
-	int width, height, nrChannels;
-	unsigned char* data = stbi_load("heya.png", &width, &height, &nrChannels, 4);
-	// Texture generation
-	unsigned int texture0;
-	glGenTextures(1, &texture0);
-	// Bind texture
-	glBindTexture(GL_TEXTURE_2D, texture0);
-	// Configure texture wrapping
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	// Configure texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// Generate texture
-	if (data)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture0" << std::endl;
-	}
-	// Free up memory from texture import
-	stbi_image_free(data);
+	// Decode heya.png on a worker thread and upload it a few rows per frame;
+	// a placeholder is bound until it is resident
+	TextureStreamer streamer;
+	int texture0 = streamer.request("heya.png", 4);
 
 	// Initial Shader Call
 	myShader.use();
@@ -147,8 +160,21 @@ int main()
 	// Specify texture units to shader (only needs to be done once)
 	myShader.setInt("texture0", 0);
 
+	// Look up the transform uniform once instead of every frame
+	UniformHandle transformLoc = myShader.getUniform("transform");
+
+	// Binds and state changes go through the cache, which drops the ones
+	// that would not change anything
+	GLState& state = GLState::instance();
+
+	// Key events come in through callbacks, timestamped, and are handled
+	// once per frame
+	InputQueue input;
+	input.attach(window);
+	input.bind(keyBindings);
+
 	// Enable Depth Buffer
-	glEnable(GL_DEPTH_TEST);
+	state.enable(GL_DEPTH_TEST);
 
 	// COLORS:
 	//red     =  (1.0f, 0.0f, 0.0f, 1.0f);
@@ -160,75 +186,109 @@ int main()
 	//magenta =  (0.5f, 0.0f, 0.8f, 1.0f);
 
 	// RENDER LOOP
-	while (!glfwWindowShouldClose(window))
+	while (!window.shouldClose())
 	{
-		// Input
-		processInput(window);
-
-		// Screen Color
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// Zones are timed only when the profiler is on (LEARNOPENGL_PROFILE=1)
+		Profiler::instance().beginFrame();
 
-		// Texture Activation
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture0);
+		// Input
+		{
+			PROFILE_SCOPE("input");
+			processInput(window, input);
+		}
 
 		// Matrix Transformations
 		// Create a transformation matrix initalized as an identity matrix
 		glm::mat4 transform = glm::mat4(1.0f);
-		// TRANSLATION:
-		transform = glm::translate(transform, glm::vec3(0.0f, 0.0f, 0.0f));
-		// ROTATION:
-		transform = glm::rotate(transform, (float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
-		// Render Calls
-		myShader.use();
-		// Update shader uniform
-		unsigned int transformLoc = glGetUniformLocation(myShader.ID, "transform");
-		glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));
-		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		{
+			PROFILE_SCOPE("update");
+			// Swap in shaders that finished rebuilding (frame boundary)
+			if (watcher.applyPending() > 0)
+				frameTimer.markEvent();
+
+			// TRANSLATION:
+			transform = glm::translate(transform, glm::vec3(0.0f, 0.0f, 0.0f));
+			// ROTATION:
+			transform = glm::rotate(transform, (float)window.getTime(), glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+
+		{
+			PROFILE_SCOPE("draw");
+			PROFILE_GPU_SCOPE("draw");
+			// Screen Color
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// Upload the next slice of any pending textures
+			{
+				PROFILE_SCOPE("texture upload");
+				PROFILE_GPU_SCOPE("texture upload");
+				streamer.update();
+			}
+
+			// Texture Activation
+			state.bindTexture(0, GL_TEXTURE_2D, streamer.getTexture(texture0));
+
+			// Render Calls
+			myShader.use();
+			// Update shader uniform
+			myShader.setMat4(transformLoc, glm::value_ptr(transform));
+			state.bindVertexArray(VAO);
+			glDrawElements(GL_TRIANGLES, (GLsizei)box.indices.size(), GL_UNSIGNED_INT, 0);
+		}
 		// Swap buffers and poll events
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		{
+			PROFILE_SCOPE("swap");
+			window.swapBuffers();
+		}
+		input.markPresented();
+		frameTimer.tick();
+		state.endFrame();
+		Profiler::instance().endFrame();
 	}
+	watcher.stop();
+	frameTimer.printStats("shader reload");
+	streamer.printStats();
+	streamer.shutdown();
 
+	// Report how much compile time the program binary cache saved
+	ProgramCache::instance().printStats();
+	state.printStats();
+	input.printStats();
+	input.detach();
+	Profiler::instance().shutdown();
 
-	return 0;
+	// non-zero after a --benchmark run slower than its baseline
+	return window.exitCode();
 }
 
-void processInput(GLFWwindow* window)
+void processInput(AppWindow& window, InputQueue& input)
 {
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	// Every key event since the last frame, already mapped to its action
+	input.drain([&window](int action, const InputQueue::Event&)
 	{
-		glfwSetWindowShouldClose(window, true);
-	}
-	else if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
-	{
-		// RED
-		glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
-	}
-	else if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
-	{
-		// ORANGE
-		glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
-	}
-	else if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS)
-	{
-		// YELLOW
-		glClearColor(1.0f, 1.0f, 0.0f, 1.0f);
-	}
-	else if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS)
-	{
-		// GREEN
-		glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
-	}
-	else if (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS)
-	{
-		// BLUE
-		glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
-	}
-	else if (glfwGetKey(window, GLFW_KEY_6) == GLFW_PRESS)
-	{
-		// PURPLE
-		glClearColor(0.3f, 0.0f, 0.5f, 1.0f);
-	}
+		switch (action)
+		{
+		case QUIT:
+			window.setShouldClose(true);
+			break;
+		case CLEAR_RED:
+			GLState::instance().clearColor(1.0f, 0.0f, 0.0f, 1.0f);
+			break;
+		case CLEAR_ORANGE:
+			GLState::instance().clearColor(1.0f, 0.5f, 0.0f, 1.0f);
+			break;
+		case CLEAR_YELLOW:
+			GLState::instance().clearColor(1.0f, 1.0f, 0.0f, 1.0f);
+			break;
+		case CLEAR_GREEN:
+			GLState::instance().clearColor(0.0f, 1.0f, 0.0f, 1.0f);
+			break;
+		case CLEAR_BLUE:
+			GLState::instance().clearColor(0.0f, 0.0f, 1.0f, 1.0f);
+			break;
+		case CLEAR_PURPLE:
+			GLState::instance().clearColor(0.3f, 0.0f, 0.5f, 1.0f);
+			break;
+		}
+	});
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+// -------------------------------------------------------------------------------
+// PROJECT: TextureBaker
+// AUTHOR: willo488
+// DATE: 10/17/2026
+// DESCRIPTION: Command line tool that turns source images (anything stb_image
+// reads) into .gltx files: the full mip chain in its final GL format, laid out
+// so the runtime can map the file and upload each level without decoding.
+// The output goes next to the input with a .gltx extension, where
+// TextureStreamer picks it up automatically. Images are flipped vertically by
+// default to match stbi_set_flip_vertically_on_load(true) in the projects.
+// Mips are built on the CPU by ImageResample: --srgb stores sRGB formats and
+// filters in linear space, --kaiser uses the sharper Kaiser filter.
+// Usage: TextureBaker [--no-flip] [--srgb] [--kaiser] [--channels N] image...
+// -------------------------------------------------------------------------------
+
+#include "stb_image.h"
+#include "../Common/baked_texture.h"
+
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+	bool flip = true;
+	bool srgb = false;
+	ImageResample::Filter filter = ImageResample::BOX;
+	int channels = 0;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--no-flip")
+			flip = false;
+		else if (arg == "--srgb")
+			srgb = true;
+		else if (arg == "--kaiser")
+			filter = ImageResample::KAISER;
+		else if (arg == "--channels" && i + 1 < argc)
+			channels = std::atoi(argv[++i]);
+		else
+			inputs.push_back(arg);
+	}
+	if (inputs.empty() || channels < 0 || channels > 4)
+	{
+		std::cout << "Usage: TextureBaker [--no-flip] [--srgb] [--kaiser] [--channels N] image..." << std::endl;
+		return 1;
+	}
+
+	stbi_set_flip_vertically_on_load(flip);
+	int failed = 0;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		int width, height, components;
+		unsigned char* pixels = stbi_load(inputs[i].c_str(), &width, &height, &components, channels);
+		if (pixels == NULL)
+		{
+			std::cout << "Failed to load texture " << inputs[i] << std::endl;
+			failed++;
+			continue;
+		}
+		if (channels != 0)
+			components = channels;
+
+		std::string output = BakedTexture::bakedPath(inputs[i]);
+		uint32_t flags = (flip ? BakedTexture::FLIPPED : 0) | (srgb ? BakedTexture::SRGB : 0);
+		bool baked = BakedTexture::bake(output, pixels, width, height, components, flags, filter);
+		stbi_image_free(pixels);
+		if (!baked)
+		{
+			failed++;
+			continue;
+		}
+
+		// read it back to check and report it
+		BakedTexture result(output);
+		if (!result.isValid())
+		{
+			std::cout << "ERROR::TEXTURE_BAKER::INVALID_OUTPUT " << output << std::endl;
+			failed++;
+			continue;
+		}
+		std::error_code ec;
+		std::cout << output << ": " << width << "x" << height << "x" << components << ", "
+			<< result.getLevelCount() << " levels, " << std::filesystem::file_size(output, ec) / 1024 << " KB" << std::endl;
+	}
+	return failed == 0 ? 0 : 1;
+}